@@ -40,6 +40,10 @@ typedef struct
     gboolean ai;      /**< Booléen indiquant si l'IA est activée pour le joueur courant. */
     int port;         /**< Le port utilisé pour la communication réseau. */
     char address[16]; /**< L'adresse IP du serveur à laquelle se connecter (pour le client). */
+    char tt_path[256];/**< Fichier de table de transposition de l'IA (vide : pas de persistance). */
+    char journal_path[256];/**< Journal de la partie en réseau (vide : pas de journal). */
+    int clock_ms;     /**< Temps de réflexion de l'IA pour la partie, en millisecondes (0 : profondeur fixe). */
+    int increment_ms; /**< Temps ajouté à la pendule de l'IA après chacun de ses coups. */
 
     // Les Widgets de l'interface GTK
     GtkWidget *tour_label;        /**< Pointeur vers le label affichant le numéro du tour. */
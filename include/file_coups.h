@@ -0,0 +1,69 @@
+/**
+ * @file file_coups.h
+ * @authors Groupe 8
+ * @brief file_coups.h déclare la file sans verrou des coups reçus du réseau.
+ *
+ * La file relie exactement un producteur (le thread réseau) et un
+ * consommateur (le thread de l'interface). Sa capacité est fixe : aucun
+ * coup n'est alloué, et les coups ressortent dans leur ordre d'arrivée,
+ * même lorsqu'ils arrivent en rafale.
+ */
+
+#ifndef FILE_COUPS_H
+#define FILE_COUPS_H
+
+#include <stdatomic.h>
+#include <stdint.h>
+
+#define MOVE_QUEUE_CAPACITY 256 /**< Nombre de coups en attente au plus (puissance de 2). */
+#define MOVE_QUEUE_ALIGN    64  /**< Alignement des indices, un par ligne de cache. */
+#define MOVE_QUEUE_REPLAY   0x01 /**< Coup manqué, renvoyé par le serveur lors d'une reprise. */
+#define MOVE_QUEUE_RESYNC   0x02 /**< Pas un coup : la position de reprise est à appliquer. */
+
+/**
+ * @struct QueuedMove
+ * @brief Un coup en attente : cases de départ et d'arrivée (indices 0 à 80).
+ */
+typedef struct {
+    uint8_t from;        /**< Case de départ. */
+    uint8_t to;          /**< Case d'arrivée. */
+    int64_t received_us; /**< Instant de réception (`latency_now_us`), pour mesurer l'attente. */
+    uint8_t flags;       /**< MOVE_QUEUE_REPLAY, MOVE_QUEUE_RESYNC, ou 0 pour un coup ordinaire. */
+} QueuedMove;
+
+/**
+ * @struct MoveQueue
+ * @brief File circulaire à un producteur et un consommateur.
+ *
+ * `head` n'est écrit que par le consommateur et `tail` que par le
+ * producteur ; chacun occupe sa propre ligne de cache.
+ */
+typedef struct {
+    _Alignas(MOVE_QUEUE_ALIGN) _Atomic uint32_t head; /**< Nombre de coups retirés. */
+    _Alignas(MOVE_QUEUE_ALIGN) _Atomic uint32_t tail; /**< Nombre de coups ajoutés. */
+    QueuedMove slots[MOVE_QUEUE_CAPACITY];            /**< Coups, indexés modulo la capacité. */
+} MoveQueue;
+
+/**
+ * @brief Vide la file. À appeler avant que le producteur et le consommateur ne démarrent.
+ * @param q La file.
+ */
+void move_queue_init(MoveQueue *q);
+
+/**
+ * @brief Ajoute un coup en fin de file (producteur uniquement).
+ * @param q La file.
+ * @param m Le coup.
+ * @return 0 si succès, -1 si la file est pleine.
+ */
+int move_queue_push(MoveQueue *q, QueuedMove m);
+
+/**
+ * @brief Retire le coup en tête de file (consommateur uniquement).
+ * @param q La file.
+ * @param[out] m Le coup retiré.
+ * @return 1 si un coup est retiré, 0 si la file est vide.
+ */
+int move_queue_pop(MoveQueue *q, QueuedMove *m);
+
+#endif
@@ -0,0 +1,80 @@
+/**
+ * @file geometrie.h
+ * @authors Groupe 8
+ * @brief geometrie.h déclare les tables précalculées de géométrie du plateau.
+ *
+ * Les cases sont numérotées de 0 à 80 (ligne * SIZE + colonne). Pour chaque
+ * case et chaque direction, les tables donnent les cases atteignables en
+ * glissant (dans l'ordre) ainsi que les voisines utilisées par les règles
+ * de capture. Elles sont partagées par l'IA, les règles et l'interface.
+ */
+
+#ifndef GEOMETRIE_H
+#define GEOMETRIE_H
+
+#include "plateau.h"
+#include <stdint.h>
+
+#define NB_CASES (SIZE * SIZE)            /**< Nombre de cases du plateau. */
+#define CASE_IDX(r, c) ((r) * SIZE + (c)) /**< Indice d'une case à partir de ses coordonnées. */
+#define CASE_LIGNE(i) ((i) / SIZE)        /**< Ligne d'une case à partir de son indice. */
+#define CASE_COL(i) ((i) % SIZE)          /**< Colonne d'une case à partir de son indice. */
+
+/**
+ * @enum Direction
+ * @brief Les quatre directions de déplacement, vues depuis l'interface.
+ */
+typedef enum
+{
+    DIR_HAUT,     /**< Vers la ligne 0 (chiffres croissants à l'écran). */
+    DIR_BAS,      /**< Vers la ligne 8. */
+    DIR_GAUCHE,   /**< Vers la colonne A. */
+    DIR_DROITE,   /**< Vers la colonne I. */
+    NB_DIRECTIONS /**< Nombre de directions. */
+} Direction;
+
+/**
+ * @struct Rayons
+ * @brief Cases atteignables depuis une case dans chaque direction, de la plus proche à la plus lointaine.
+ */
+typedef struct
+{
+    uint8_t longueur[NB_DIRECTIONS];        /**< Nombre de cases avant le bord. */
+    uint8_t cases[NB_DIRECTIONS][SIZE - 1]; /**< Indices des cases, dans l'ordre. */
+} Rayons;
+
+extern Rayons geo_rayons[NB_CASES];                 /**< Rayons de glissement de chaque case. */
+extern int8_t geo_voisin[NB_CASES][NB_DIRECTIONS];  /**< Case adjacente (victime potentielle), -1 hors plateau. */
+extern int8_t geo_voisin2[NB_CASES][NB_DIRECTIONS]; /**< Case à deux pas (garde ou allié), -1 hors plateau. */
+extern const char *const geo_noms_directions[NB_DIRECTIONS]; /**< "haut", "bas", "gauche", "droite". */
+
+/**
+ * @brief Convertit le nom d'un mouvement en direction.
+ * @param mouvement "haut", "bas", "gauche" ou "droite".
+ * @return La direction, ou -1 si le nom est inconnu (ou NULL).
+ */
+int geo_direction(const char *mouvement);
+
+/**
+ * @brief Donne la direction d'un déplacement en ligne droite.
+ * @param from Indice de la case de départ.
+ * @param to Indice de la case d'arrivée.
+ * @return La direction, ou -1 si les cases sont confondues ou non alignées.
+ */
+int geo_direction_entre(int from, int to);
+
+/**
+ * @brief Convertit l'identifiant d'une case ("A9" ... "I1") en indice.
+ * @param id L'identifiant de la case.
+ * @return L'indice de la case, ou -1 si l'identifiant est invalide.
+ */
+int geo_index_depuis_id(const char *id);
+
+/**
+ * @brief Écrit l'identifiant d'une case ("A9" ... "I1") à partir de son indice.
+ * @param i L'indice de la case (0 à NB_CASES - 1).
+ * @param[out] id Tampon d'au moins 3 caractères.
+ */
+void geo_id_depuis_index(int i, char *id);
+
+#endif
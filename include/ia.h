@@ -19,9 +19,12 @@
 /**
  * @struct Board
  * @brief Représentation interne et simplifiée du plateau de jeu pour l'IA.
+ *
+ * Une case tient sur un octet (valeurs 0 à 4) : le plateau complet occupe
+ * 81 octets, ce qui rend les copies de position très peu coûteuses.
  */
 typedef struct {
-    int pion[SIZE][SIZE];  /**< Matrice des pièces sur le plateau. */
+    int8_t pion[SIZE][SIZE];  /**< Matrice des pièces sur le plateau. */
 } Board;
 
 /**
@@ -51,6 +54,44 @@ typedef struct {
     Move     best;  /**< Meilleur coup trouvé depuis cette position. */
 } TTEntry;
 
+/**
+ * @enum RepetitionPolicy
+ * @brief Valeur donnée par la recherche à une position déjà rencontrée.
+ */
+typedef enum {
+    REP_SCORE_DRAW,     /**< Une répétition vaut 0. */
+    REP_SCORE_CONTEMPT, /**< Une répétition coûte `contempt` au camp qui lance la recherche. */
+    REP_SCORE_EVAL      /**< Une répétition prend l'évaluation statique, sans recherche plus profonde. */
+} RepetitionPolicy;
+
+/**
+ * @struct SearchStats
+ * @brief Statistiques de la dernière recherche (`search_best_move`).
+ */
+typedef struct {
+    int      threads; /**< Nombre de threads ayant participé à la recherche. */
+    uint64_t nodes;   /**< Nombre total de nœuds visités. */
+    uint64_t splits;  /**< Points de partage créés (recherche parallèle). */
+    uint64_t steals;  /**< Tâches exécutées par un autre thread que leur créateur. */
+    uint64_t eval_probes; /**< Évaluations statiques demandées. */
+    uint64_t eval_hits;   /**< Évaluations servies par le cache d'évaluation. */
+    int      depth;       /**< Dernière profondeur entièrement recherchée. */
+    int64_t  time_ms;     /**< Durée de la recherche itérative, en millisecondes. */
+} SearchStats;
+
+/**
+ * @struct MoveBudget
+ * @brief Temps accordé à la recherche d'un coup.
+ *
+ * La recherche ne commence plus d'itération au-delà de la limite souple
+ * (ajustée selon la stabilité du meilleur coup) et s'interrompt à la limite
+ * dure, la première itération étant toujours menée à son terme.
+ */
+typedef struct {
+    int64_t soft_ms; /**< Durée visée pour le coup. */
+    int64_t hard_ms; /**< Durée à ne jamais dépasser (hors première itération). */
+} MoveBudget;
+
         /*  Constantes IA  */
 
 #define MAX_DEPTH        4     /**< Profondeur maximale de la recherche Minimax. */
@@ -59,8 +100,48 @@ typedef struct {
 #define TT_SIZE_POW2     17     /**< Taille de la table de transposition (2^17). */
 #define TT_SIZE          (1u << TT_SIZE_POW2)
 #define TT_MASK          (TT_SIZE - 1u)
+#define EVAL_CACHE_POW2  16     /**< Taille du cache d'évaluation (2^16 entrées de 8 octets), indépendante de la TT. */
+#define MAX_MULTIPV      16    /**< Nombre maximal de lignes en analyse multi-PV. */
+#define MAX_PV_LENGTH    32    /**< Longueur maximale d'une variation principale. */
+#define MAX_PLY          32    /**< Niveaux préalloués dans la pile de recherche de chaque thread. */
+#define HISTORY_MAX      512   /**< Positions mémorisées (partie + chemin de recherche). */
+#define HISTORY_GAME_MAX 384   /**< Positions de partie conservées, le reste est réservé à la recherche. */
+#define HISTORY_FILTER_SIZE 1024 /**< Alvéoles du filtre de répétition (puissance de 2). */
+#define TT_FILE_MAGIC    0x5454524Bu /**< "KRTT" : signature des fichiers de TT. */
+#define TT_FILE_VERSION  3     /**< Version des fichiers de TT : à augmenter quand le format ou l'évaluation change. */
+#define TT_FILE_RECORD_SIZE 14 /**< Taille d'une entrée de TT sur disque. */
+#define TT_SAVE_MIN_DEPTH 2    /**< Profondeur minimale des entrées sauvegardées en fin de partie. */
+#define PN_MAX_PIECES    8     /**< Nombre de pièces à partir duquel le solveur de finale est lancé. */
+#define PN_MAX_NODES     20000 /**< Budget de nœuds d'une résolution de finale. */
+#define PN_TABLE_POW2    16    /**< Taille de la table preuve/réfutation du solveur (2^16). */
+#define KING_RACE_HORIZON 3    /**< Nombre de coups au-delà duquel la course d'un roi n'est plus évaluée. */
+#define KING_RACE_WEIGHT  6    /**< Bonus par coup d'avance d'un roi dans la course vers son but. */
+#define SEE_MAX_DEPTH    4     /**< Nombre maximal de reprises examinées par l'évaluation des échanges. */
+#define IA_TOURS_MAX     64    /**< Dernier tour de la partie (tours impairs : bleus, pairs : rouges). */
+#define TIME_MAX_DEPTH   16    /**< Profondeur maximale d'une recherche limitée par le temps. */
+#define TIME_MARGIN_MS   50    /**< Réserve laissée sur la pendule pour la latence du réseau. */
+#define TIME_HARD_FACTOR 4     /**< Limite dure d'un coup, en multiples de sa limite souple. */
+#define TIME_CHECK_NODES 1024  /**< Nœuds entre deux lectures de l'horloge (puissance de 2). */
+#define TIME_UNSTABLE_PCT 160  /**< Limite souple (en %) quand le meilleur coup ou le score vient de changer. */
+#define TIME_STABLE_PCT  40    /**< Limite souple (en %) quand le meilleur coup est stable. */
+#define TIME_STABLE_ITERS 3    /**< Itérations sans changement pour juger le meilleur coup stable. */
+#define TIME_SWING_SCORE 40    /**< Variation de score entre deux itérations jugée significative. */
+#define YBW_MAX_THREADS      64   /**< Nombre maximal de threads de recherche. */
+#define YBW_MIN_SPLIT_DEPTH  2    /**< Profondeur restante minimale pour partager un nœud. */
+#define YBW_DEQUE_SIZE       8192 /**< Capacité de la file de tâches de chaque thread. */
 #define EVAL_CLAMP(x)    ((x) > 30000 ? 30000 : ((x) < -30000 ? -30000 : (x))) /**< Macro pour borner les valeurs d'évaluation. */
 
+/**
+ * @struct PVLine
+ * @brief Une ligne d'analyse multi-PV : coup racine, score et variation principale.
+ */
+typedef struct {
+    Move move;                 /**< Coup joué à la racine. */
+    int  score;                /**< Évaluation de la ligne (positif pour avantage bleu). */
+    int  length;               /**< Nombre de coups dans `pv`. */
+    Move pv[MAX_PV_LENGTH];    /**< Variation principale, commençant par `move`. */
+} PVLine;
+
             /*  Variables globales  */
 
 extern TTEntry *TT;                   /**< Pointeur vers la table de transposition. */
@@ -80,6 +161,150 @@ extern Move g_last_best_move_red;     /**< Stocke le dernier meilleur coup joué
  */
 Move search_best_move(const Board* start, bool blueToPlay);
 
+/**
+ * @brief Tente de prouver un gain forcé du camp au trait (solveur df-pn).
+ *
+ * Les gains considérés sont ceux de `check_winner` (conquête, capture du roi,
+ * extermination). Une répétition compte comme un échec de l'attaquant. Les
+ * preuves dépendant de l'historique de la partie, elles restent dans la
+ * table du solveur, vidée à chaque résolution, et jamais dans la table de
+ * transposition.
+ * @param start La position à résoudre.
+ * @param blueToPlay true si c'est au tour du joueur bleu.
+ * @param[out] out Le coup gagnant, si un gain est prouvé.
+ * @return true si un gain forcé est prouvé dans le budget PN_MAX_NODES.
+ */
+bool ia_solve_endgame(const Board* start, bool blueToPlay, Move* out);
+
+/**
+ * @brief Analyse multi-PV : cherche les `nLines` meilleurs coups depuis une position.
+ *
+ * Chaque ligne est recherchée en excluant les coups racine des lignes
+ * précédentes, en réutilisant la même table de transposition. Les lignes
+ * rendues sont toutes celles de la dernière itération terminée (ou, si la
+ * première est interrompue, celles qu'elle a trouvées), triées par score.
+ * @param start La position de départ.
+ * @param blueToPlay true si c'est au tour du joueur bleu, false sinon.
+ * @param nLines Nombre de lignes souhaitées (au plus MAX_MULTIPV).
+ * @param[out] lines Tableau d'au moins `nLines` lignes, du meilleur au moins bon coup.
+ * @return Le nombre de lignes effectivement remplies.
+ */
+int search_multipv(const Board* start, bool blueToPlay, int nLines, PVLine lines[]);
+
+/**
+ * @brief Répartit le temps restant d'une pendule sur les coups restants de la partie.
+ *
+ * La partie s'arrêtant après le tour IA_TOURS_MAX, le camp au trait sait
+ * exactement combien de coups il lui reste : le temps disponible (incréments
+ * à venir compris, réserve TIME_MARGIN_MS déduite) est divisé par ce nombre.
+ * @param remainingMs Temps restant à la pendule du camp au trait.
+ * @param incrementMs Temps ajouté à la pendule après chaque coup.
+ * @param tour Le tour du coup à jouer (1 à IA_TOURS_MAX).
+ * @return Le budget du coup ; `hard_ms` ne dépasse jamais le temps restant.
+ */
+MoveBudget ia_allocate_time(int64_t remainingMs, int64_t incrementMs, int tour);
+
+/**
+ * @brief Fixe le budget de temps des prochaines recherches.
+ *
+ * Avec un budget, l'approfondissement itératif va jusqu'à TIME_MAX_DEPTH
+ * tant que le temps le permet ; sans budget, il s'arrête à MAX_DEPTH.
+ * À appeler en dehors de toute recherche.
+ * @param budget Le budget, ou NULL pour revenir à la profondeur fixe.
+ */
+void ia_set_move_budget(const MoveBudget *budget);
+
+/**
+ * @brief Choisit le nombre de threads de la recherche parallèle "Young Brothers Wait".
+ *
+ * Avec plus d'un thread, chaque nœud suffisamment profond recherche d'abord son
+ * fils aîné seul, puis expose ses autres fils comme tâches que les threads
+ * inoccupés volent ; une coupure annule les tâches encore en cours.
+ * À appeler en dehors de toute recherche.
+ * @param n Nombre de threads souhaité (1 = recherche séquentielle).
+ * @return Le nombre de threads effectivement actifs.
+ */
+int ia_set_threads(int n);
+
+/**
+ * @brief Active le mode déterministe, destiné aux mesures de performance.
+ *
+ * Les fils partagés sont recherchés avec la fenêtre du nœud au moment du
+ * partage, sans annulation, et la table de transposition est ignorée : le
+ * nombre de nœuds ne dépend plus de l'ordonnancement des threads.
+ * @param on true pour activer le mode, false pour revenir au mode normal.
+ */
+void ia_set_deterministic(bool on);
+
+/**
+ * @brief Sauvegarde la table de transposition dans un fichier compact.
+ *
+ * L'écriture passe par un fichier temporaire renommé à la fin : un fichier
+ * existant n'est jamais laissé à moitié écrit. Si une écriture échoue
+ * (disque plein), le fichier temporaire est supprimé.
+ * @param path Chemin du fichier.
+ * @param minDepth Profondeur minimale des entrées conservées.
+ * @return Le nombre d'entrées écrites, ou -1 en cas d'erreur.
+ */
+int ia_tt_save(const char *path, int minDepth);
+
+/**
+ * @brief Charge (via mmap) un fichier de TT et fusionne ses entrées dans la table.
+ *
+ * Le fichier est refusé si son format, la taille des entrées ou l'empreinte
+ * des clés de Zobrist ne correspondent pas au programme courant, ou si un
+ * enregistrement porte un drapeau qui n'est pas une borne.
+ * @param path Chemin du fichier.
+ * @return Le nombre d'entrées lues, ou -1 si le fichier est absent ou invalide.
+ */
+int ia_tt_load(const char *path);
+
+/**
+ * @brief Vide la table de transposition.
+ */
+void ia_tt_clear(void);
+
+/**
+ * @brief Vide l'historique des positions de la partie (nouvelle partie).
+ */
+void ia_history_clear(void);
+
+/**
+ * @brief Ajoute une position atteinte dans la partie à l'historique.
+ *
+ * La recherche considère toute position déjà présente dans l'historique, ou
+ * déjà vue sur le chemin courant, comme une répétition.
+ * @param b La position atteinte.
+ * @param blueToPlay true si c'est aux bleus de jouer dans cette position.
+ */
+void ia_history_push(const Board* b, bool blueToPlay);
+
+/**
+ * @brief Choisit la valeur attribuée aux positions répétées.
+ * @param policy La politique (REP_SCORE_DRAW par défaut).
+ * @param contempt Pénalité pour le camp de la racine (REP_SCORE_CONTEMPT uniquement).
+ */
+void ia_set_repetition_policy(RepetitionPolicy policy, int contempt);
+
+/**
+ * @brief Demande l'arrêt de la recherche en cours (appelable depuis n'importe quel thread).
+ *
+ * La recherche rend alors le meilleur coup de la dernière itération terminée.
+ * La demande reste active jusqu'à l'appel de `ia_reset_stop`.
+ */
+void ia_stop_search(void);
+
+/**
+ * @brief Annule une demande d'arrêt, avant de lancer une nouvelle recherche.
+ */
+void ia_reset_stop(void);
+
+/**
+ * @brief Récupère les statistiques de la dernière recherche.
+ * @param[out] out Structure à remplir.
+ */
+void ia_get_search_stats(SearchStats *out);
+
 /**
  * @brief Initialise les composants de l'IA (tables Zobrist, TT). Ne s'exécute qu'une seule fois.
  */
@@ -87,14 +312,40 @@ void ia_init_once(void);
 
 /**
  * @brief Fait jouer l'IA pour le camp bleu.
+ *
+ * La recherche tourne dans un thread dédié ; le coup est joué plus tard
+ * depuis la boucle principale GTK. Sans effet si une recherche est déjà en cours.
  */
 void ia_play_blue();
 
 /**
  * @brief Fait jouer l'IA pour le camp rouge.
+ *
+ * La recherche tourne dans un thread dédié ; le coup est joué plus tard
+ * depuis la boucle principale GTK. Sans effet si une recherche est déjà en cours.
  */
 void ia_play_red();
 
+/**
+ * @brief Interrompt la recherche en cours et attend la fin de son thread.
+ *
+ * Un résultat déjà transmis à la boucle principale est ignoré. À appeler
+ * depuis le thread GTK (fin de partie, fermeture de la fenêtre).
+ */
+void ia_cancel_search(void);
+
+/**
+ * @brief Ajoute la position affichée par l'interface à l'historique de l'IA.
+ *
+ * À appeler après chaque coup joué (le camp au trait est déduit de `tour`).
+ */
+void ia_note_position(void);
+
+/**
+ * @brief Sauvegarde la TT dans `config.tt_path` si l'IA est active et un fichier configuré.
+ */
+void ia_persist_tt(void);
+
 /**
  * @brief Vérifie s'il y a un vainqueur sur le plateau de l'IA.
  * @param b Le plateau à vérifier.
@@ -102,6 +353,64 @@ void ia_play_red();
  */
 int check_winner(const Board* b);
 
+#ifdef IA_TESTS
+// Points d'entrée des fonctions internes, pour les tests unitaires seulement
+// (tests/test_ia.c est compilé avec -DIA_TESTS).
+
+/**
+ * @brief Calcule l'occupation des lignes et colonnes avec une version donnée.
+ * @param b Le plateau.
+ * @param pext true pour la version BMI2 (PEXT), false pour la multiplication.
+ * @param[out] rows Bit c de rows[r] : case (r,c) occupée.
+ * @param[out] cols Bit r de cols[c] : case (r,c) occupée.
+ * @return 0 si succès, -1 si la version demandée n'existe pas sur ce processeur.
+ */
+int ia_test_occupancy(const Board* b, bool pext, uint16_t rows[SIZE], uint16_t cols[SIZE]);
+
+/**
+ * @brief Valeur des pièces prises par un coup (poussée et sandwich), sans le jouer.
+ * @param b Le plateau avant le coup.
+ * @param from Indice de la case de départ.
+ * @param to Indice de la case d'arrivée (alignée avec `from`).
+ * @return La somme des valeurs capturées, ou -1 si les cases ne sont pas alignées.
+ */
+int ia_test_capture_gain(const Board* b, int from, int to);
+
+/**
+ * @brief Bilan de l'évaluation statique des échanges d'un coup.
+ * @param b Le plateau avant le coup.
+ * @param from Indice de la case de départ.
+ * @param to Indice de la case d'arrivée (alignée avec `from`).
+ * @return Le bilan pour le camp qui joue, ou INT32_MIN si les cases ne sont pas alignées.
+ */
+int ia_test_see(const Board* b, int from, int to);
+
+/**
+ * @brief Nombre de coups d'un roi jusqu'à sa case but, les autres pièces immobiles.
+ * @param b Le plateau.
+ * @param from Indice de la case du roi.
+ * @param goal Indice de la case but.
+ * @param limit Nombre de coups au-delà duquel le parcours s'arrête.
+ * @return Le nombre de coups, ou `limit + 1` si le but n'est pas atteint à temps.
+ */
+int ia_test_king_moves_to_goal(const Board* b, int from, int goal, int limit);
+
+/**
+ * @brief Indique si le roi du camp au trait atteint sa case but en un coup.
+ * @param b Le plateau.
+ * @param blueToPlay true si c'est au tour des bleus.
+ * @return true si le coup gagnant existe.
+ */
+bool ia_test_king_wins_next(const Board* b, bool blueToPlay);
+
+/**
+ * @brief Arrête la prochaine analyse multi-PV au milieu d'une itération (`ia_stop_search`).
+ * @param depth L'itération interrompue, 0 pour ne plus interrompre.
+ * @param lines Nombre de lignes de cette itération terminées avant l'arrêt.
+ */
+void ia_test_stop_multipv_at(int depth, int lines);
+#endif
+
 // Fonctions de jeu.h nécessaires pour l'intégration
 void select_case(Case *cell);
 void unselect_case(void);
@@ -12,6 +12,7 @@
 
 #include "plateau.h" 
 #include <stdbool.h>
+#include <stdint.h>
 
 /**
  * @struct GameState
@@ -20,14 +21,16 @@
  * C'est cette structure qui est manipulée et vérifiée par les tests.
  */
 typedef struct {
-    int pion[SIZE][SIZE];       /**< L'état de chaque case du plateau. */
-    int couleur[SIZE][SIZE];    /**< La couleur de contrôle de chaque case. */
+    int8_t pion[SIZE][SIZE];    /**< L'état de chaque case du plateau (un octet par case). */
+    int8_t couleur[SIZE][SIZE]; /**< La couleur de contrôle de chaque case (un octet par case). */
     int dead_red_count;         /**< Compteur de soldats rouges morts. */
     int dead_blue_count;        /**< Compteur de soldats bleus morts. */
     int tour;                   /**< Numéro du tour actuel. */
     int game_over_status;       /**< 0: en cours, 1: rouge gagne, 2: bleu gagne, 3: égalité. */
 } GameState;
 
+#define LOGIQUE_MAX_COUPS 160 /**< Coups légaux au plus : 10 pièces par camp, 16 cases atteignables chacune. */
+
 // Fonctions publiques de la bibliothèque de logique 
 
 /**
@@ -60,6 +63,42 @@ void logique_prise(GameState *state, int r, int c);
  */
 void logique_verifier_conditions_fin(GameState *state);
 
+/**
+ * @brief Vérifie qu'un coup est légal : partie en cours, pièce du camp au
+ * trait, déplacement en ligne droite sans traverser ni atteindre de pièce.
+ *
+ * Seules les cases du trajet sont lues, à l'aide des rayons précalculés de
+ * geometrie.h.
+ * @param state Pointeur vers l'état du jeu.
+ * @param from Indice de la case de départ.
+ * @param to Indice de la case d'arrivée.
+ * @return true si le coup est légal.
+ */
+bool logique_coup_legal(const GameState *state, int from, int to);
+
+/**
+ * @brief Énumère les coups légaux du camp au trait.
+ *
+ * Chaque pièce du camp glisse le long de ses rayons jusqu'à la première
+ * pièce rencontrée ; les coups sont ceux qu'accepte `logique_coup_legal`.
+ * @param state Pointeur vers l'état du jeu.
+ * @param[out] coups Les coups (case de départ, case d'arrivée), au moins LOGIQUE_MAX_COUPS places.
+ * @return Le nombre de coups, 0 si la partie est finie.
+ */
+int logique_coups_legaux(const GameState *state, uint8_t coups[][2]);
+
+/**
+ * @brief Joue un coup sans interface : déplacement, contrôle de la case
+ * d'arrivée, captures, prises, conditions de fin, puis passage au tour suivant.
+ *
+ * Le coup est d'abord vérifié par `logique_coup_legal`.
+ * @param state Pointeur vers l'état du jeu.
+ * @param from Indice de la case de départ (0 à 80).
+ * @param to Indice de la case d'arrivée (0 à 80).
+ * @return 0 si le coup est joué, -1 s'il est refusé (l'état est inchangé).
+ */
+int logique_jouer_coup(GameState *state, int from, int to);
+
 /**
  * @brief Calcule les scores et détermine le vainqueur si la partie atteint la limite de tours.
  * @param state Pointeur vers l'état du jeu à mettre à jour.
@@ -0,0 +1,127 @@
+/**
+ * @file journal.h
+ * @authors Groupe 8
+ * @brief journal.h déclare le journal binaire des parties : écriture en ajout seul et relecture.
+ *
+ * Un journal commence par un en-tête (signature, version, identifiant de
+ * partie, date), puis chaque coup joué occupe 2 octets (case de départ,
+ * case d'arrivée). Tous les JOURNAL_SNAPSHOT_INTERVAL coups, puis en fin de
+ * partie, un instantané enregistre la position complète suivie d'un CRC32
+ * de tous les octets écrits depuis l'instantané précédent : un segment dont
+ * le CRC est faux est une corruption, tandis qu'une fin de fichier
+ * incomplète (arrêt brutal) est simplement ignorée.
+ *
+ * Les écritures sont regroupées en mémoire et envoyées au système par
+ * `journal_flush` ; la politique `JournalSync` fixe la fréquence des
+ * `fdatasync`.
+ */
+
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include "jeu_logique.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#define JOURNAL_MAGIC             0x4E4A524Bu /**< "KRJN" : signature des journaux de partie. */
+#define JOURNAL_VERSION           1           /**< Version du format. */
+#define JOURNAL_SNAPSHOT_INTERVAL 32          /**< Coups entre deux instantanés. */
+#define JOURNAL_BUF_SIZE          1024        /**< Octets regroupés avant un `write`. */
+#define JOURNAL_DEFAULT_SYNC_MS   1000        /**< Intervalle par défaut entre deux `fdatasync`. */
+
+/**
+ * @enum JournalSync
+ * @brief Politique de synchronisation sur disque d'un journal.
+ */
+typedef enum {
+    JOURNAL_SYNC_NEVER,    /**< Jamais de `fdatasync` : résiste à l'arrêt du programme, pas du système. */
+    JOURNAL_SYNC_INTERVAL, /**< `fdatasync` au plus une fois par intervalle, et à la fermeture. */
+    JOURNAL_SYNC_ALWAYS    /**< `fdatasync` à chaque `journal_flush`. */
+} JournalSync;
+
+/**
+ * @struct Journal
+ * @brief Un journal ouvert en écriture.
+ */
+typedef struct {
+    int fd;                        /**< Fichier du journal. */
+    JournalSync sync;              /**< Politique de synchronisation. */
+    int sync_interval_ms;          /**< Intervalle pour JOURNAL_SYNC_INTERVAL. */
+    int64_t last_sync_us;          /**< Date du dernier `fdatasync` (horloge monotone). */
+    bool unsynced;                 /**< true si des octets écrits n'ont pas été synchronisés. */
+    uint32_t crc;                  /**< CRC du segment en cours, octets en tampon compris. */
+    int plies;                     /**< Coups enregistrés. */
+    int len;                       /**< Octets en attente dans `buf`. */
+    uint8_t buf[JOURNAL_BUF_SIZE]; /**< Octets pas encore écrits. */
+} Journal;
+
+/**
+ * @struct JournalInfo
+ * @brief Description d'un journal relu.
+ */
+typedef struct {
+    uint32_t game_id;  /**< Identifiant de la partie. */
+    int64_t created;   /**< Date de création (secondes Unix). */
+    int plies;         /**< Coups lisibles dans le journal. */
+    int status;        /**< `game_over_status` enregistré en fin de partie, -1 si le journal n'a pas de fin. */
+    bool truncated;    /**< true si une fin de fichier incomplète ou invalide a été ignorée. */
+} JournalInfo;
+
+/**
+ * @brief Crée (ou vide) un journal et y place son en-tête.
+ * @param j Le journal.
+ * @param path Le fichier.
+ * @param game_id L'identifiant de la partie.
+ * @param sync La politique de synchronisation.
+ * @param sync_interval_ms L'intervalle pour JOURNAL_SYNC_INTERVAL.
+ * @return 0 si succès, -1 si le fichier n'a pas pu être créé.
+ */
+int journal_open(Journal *j, const char *path, uint32_t game_id, JournalSync sync, int sync_interval_ms);
+
+/**
+ * @brief Enregistre un coup, et un instantané tous les JOURNAL_SNAPSHOT_INTERVAL coups.
+ * @param j Le journal.
+ * @param after La position après le coup.
+ * @param from La case de départ (0 à 80).
+ * @param to La case d'arrivée (0 à 80).
+ * @return 0 si succès, -1 si l'écriture a échoué.
+ */
+int journal_move(Journal *j, const GameState *after, int from, int to);
+
+/**
+ * @brief Enregistre la fin de la partie et sa position finale.
+ * @param j Le journal.
+ * @param final La position finale (`game_over_status` à 0 pour une partie interrompue).
+ * @return 0 si succès, -1 si l'écriture a échoué.
+ */
+int journal_end(Journal *j, const GameState *final);
+
+/**
+ * @brief Écrit les octets en attente, puis synchronise selon la politique du journal.
+ * @param j Le journal.
+ * @return 0 si succès, -1 en cas d'erreur.
+ */
+int journal_flush(Journal *j);
+
+/**
+ * @brief Écrit les octets en attente, synchronise (sauf JOURNAL_SYNC_NEVER) et ferme le journal.
+ * @param j Le journal.
+ * @return 0 si succès, -1 en cas d'erreur (le fichier est fermé dans tous les cas).
+ */
+int journal_close(Journal *j);
+
+/**
+ * @brief Reconstruit la position d'une partie après un nombre de coups donné.
+ *
+ * Le journal est parcouru une fois pour vérifier les CRC ; les coups sont
+ * ensuite rejoués, avec les règles, depuis le dernier instantané qui
+ * précède la position demandée.
+ * @param path Le fichier.
+ * @param ply Le nombre de coups à rejouer, ou -1 pour toute la partie.
+ * @param[out] out La position reconstruite.
+ * @param[out] info La description du journal (peut être NULL).
+ * @return Le nombre de coups rejoués (au plus `ply`), ou -1 si le journal est illisible ou corrompu.
+ */
+int journal_replay(const char *path, int ply, GameState *out, JournalInfo *info);
+
+#endif
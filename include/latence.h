@@ -0,0 +1,92 @@
+/**
+ * @file latence.h
+ * @authors Groupe 8
+ * @brief latence.h déclare les histogrammes de latence de la partie en réseau.
+ *
+ * Chaque étape du trajet d'un coup (attente dans la file, application à
+ * l'interface, réflexion de l'IA, envoi...) a son histogramme. Les
+ * histogrammes sont log-linéaires, dans l'esprit de HdrHistogram : chaque
+ * puissance de 2 est divisée en 2^LAT_SUB_BITS intervalles égaux, ce qui
+ * garantit une erreur relative d'au plus 1/2^LAT_SUB_BITS sur toute la plage.
+ * L'enregistrement est sans verrou et peut se faire depuis n'importe quel thread.
+ */
+
+#ifndef LATENCE_H
+#define LATENCE_H
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define LAT_SUB_BITS 4  /**< 16 intervalles par puissance de 2 (erreur relative <= 6,25 %). */
+#define LAT_MAX_BITS 40 /**< Plus grande valeur distinguée : 2^40 µs (environ 12 jours). */
+#define LAT_BUCKETS  ((LAT_MAX_BITS - LAT_SUB_BITS + 1) << LAT_SUB_BITS) /**< Nombre d'intervalles. */
+
+/**
+ * @enum LatencyStage
+ * @brief Étapes mesurées.
+ */
+typedef enum {
+    LAT_RTT,        /**< Aller-retour PING/PONG avec le pair. */
+    LAT_QUEUE,      /**< Coup reçu par le thread réseau jusqu'à sa prise en charge par l'interface. */
+    LAT_APPLY,      /**< Application d'un coup reçu à l'interface. */
+    LAT_THINK,      /**< Réflexion de l'IA. */
+    LAT_SEND,       /**< Codage et envoi d'un coup. */
+    LAT_TURNAROUND, /**< Coup adverse reçu jusqu'à l'envoi de notre réponse. */
+    LAT_STAGES      /**< Nombre d'étapes. */
+} LatencyStage;
+
+/**
+ * @struct LatencyHistogram
+ * @brief Histogramme de durées en microsecondes.
+ */
+typedef struct {
+    _Atomic uint64_t counts[LAT_BUCKETS]; /**< Nombre de mesures par intervalle. */
+    _Atomic uint64_t total;               /**< Nombre de mesures. */
+    _Atomic uint64_t sum;                 /**< Somme des mesures. */
+    _Atomic uint64_t min;                 /**< Plus petite mesure (UINT64_MAX si aucune). */
+    _Atomic uint64_t max;                 /**< Plus grande mesure. */
+} LatencyHistogram;
+
+/**
+ * @brief Vide un histogramme.
+ * @param h L'histogramme.
+ */
+void lat_hist_reset(LatencyHistogram *h);
+
+/**
+ * @brief Enregistre une durée.
+ * @param h L'histogramme.
+ * @param us La durée en microsecondes (une valeur négative compte pour 0).
+ */
+void lat_hist_record(LatencyHistogram *h, int64_t us);
+
+/**
+ * @brief Donne la durée sous laquelle se trouve une proportion des mesures.
+ * @param h L'histogramme.
+ * @param pct Le centile (0 à 100).
+ * @return La plus grande valeur de l'intervalle contenant ce centile (bornée par
+ * le maximum mesuré), ou 0 si l'histogramme est vide.
+ */
+uint64_t lat_hist_percentile(const LatencyHistogram *h, double pct);
+
+/**
+ * @brief Horloge monotone en microsecondes, commune à tous les threads.
+ * @return L'instant courant.
+ */
+int64_t latency_now_us(void);
+
+/**
+ * @brief Enregistre une durée dans l'histogramme d'une étape.
+ * @param stage L'étape.
+ * @param us La durée en microsecondes.
+ */
+void latency_record(LatencyStage stage, int64_t us);
+
+/**
+ * @brief Écrit un tableau des histogrammes non vides (nombre, moyenne, centiles, maximum).
+ * @param out Le flux de sortie.
+ */
+void latency_dump(FILE *out);
+
+#endif
@@ -0,0 +1,199 @@
+/**
+ * @file protocole.h
+ * @authors Groupe 8
+ * @brief protocole.h définit le protocole réseau binaire (version 3) et son codage.
+ *
+ * Chaque message est une trame : un en-tête de PROTO_HEADER_SIZE octets
+ * (taille du contenu, type, drapeaux, numéro de séquence, en gros-boutiste)
+ * suivi du contenu. Chaque sens d'une connexion numérote ses trames à partir
+ * de 0 ; une trame hors séquence est une erreur de protocole.
+ *
+ * Une connexion commence par un échange de trames HELLO : le client annonce
+ * la version qu'il parle, le serveur répond avec la même version et la
+ * couleur attribuée au client, ou par une trame ERROR.
+ *
+ * Un spectateur annonce le rôle PROTO_ROLE_SPECTATOR puis envoie une trame
+ * WATCH désignant la partie. Il ne reçoit pas de HELLO en retour mais une
+ * trame STATE, puis les trames de la partie. Ces trames, partagées entre
+ * tous les spectateurs, portent le drapeau PROTO_FLAG_BROADCAST et la
+ * séquence de diffusion de la partie : la séquence de la trame STATE est
+ * celle de la dernière trame diffusée, et chaque nouvelle trame STATE
+ * (resynchronisation d'un spectateur en retard) la remplace.
+ *
+ * Un serveur de parties envoie à chaque joueur, après son HELLO, une trame
+ * SESSION : identifiant de la partie et jeton secret du joueur. Après une
+ * coupure, le client se reconnecte avec le rôle PROTO_ROLE_RESUME et une
+ * trame RESUME (partie, jeton, nombre de coups qu'il connaît). Le serveur
+ * répond par HELLO, les coups manqués (MOVE), puis la position courante
+ * (STATE, sans drapeau), qui fait foi. Les séquences repartent de 0 sur la
+ * nouvelle connexion.
+ *
+ * Le module ne fait aucune entrée/sortie : les tampons `ProtoReader` et
+ * `ProtoWriter` sont remplis et vidés par la couche réseau, ce qui permet
+ * d'envoyer plusieurs trames en un seul appel système.
+ */
+
+#ifndef PROTOCOLE_H
+#define PROTOCOLE_H
+
+#include "jeu_logique.h"
+#include <stdint.h>
+
+#define PROTO_MAGIC        0x4B52u /**< "KR" : signature d'une trame HELLO. */
+#define PROTO_VERSION      3       /**< Version du protocole parlée par ce programme. */
+#define PROTO_HEADER_SIZE  8       /**< Taille de l'en-tête d'une trame. */
+#define PROTO_MAX_PAYLOAD  255     /**< Taille maximale du contenu d'une trame. */
+#define PROTO_BUF_SIZE     1024    /**< Capacité des tampons de lecture et d'écriture. */
+#define PROTO_STATE_SIZE   (2 * SIZE * SIZE + 4) /**< Contenu d'une trame STATE. */
+#define PROTO_FRAME_MAX    (PROTO_HEADER_SIZE + PROTO_MAX_PAYLOAD) /**< Taille maximale d'une trame. */
+#define PROTO_FLAG_BROADCAST 0x01  /**< Trame diffusée aux spectateurs (séquence de la partie). */
+#define PROTO_WATCH_LATEST 0       /**< Partie demandée par WATCH : la dernière formée. */
+
+/**
+ * @enum ProtoType
+ * @brief Types de trames.
+ */
+typedef enum {
+    PROTO_HELLO  = 1, /**< Poignée de main : version et couleur. */
+    PROTO_MOVE   = 2, /**< Un coup : case de départ et d'arrivée. */
+    PROTO_RESIGN = 3, /**< Abandon de l'émetteur. */
+    PROTO_CLOCK  = 4, /**< Temps restant aux deux camps. */
+    PROTO_PING   = 5, /**< Demande d'écho, avec une valeur opaque. */
+    PROTO_PONG   = 6, /**< Réponse à un PING, avec la même valeur. */
+    PROTO_STATE  = 7, /**< Position complète (resynchronisation). */
+    PROTO_ERROR  = 8, /**< Erreur de protocole ; l'émetteur ferme ensuite la connexion. */
+    PROTO_WATCH  = 9, /**< Demande d'un spectateur : identifiant de la partie à suivre. */
+    PROTO_SESSION = 10, /**< Partie et jeton attribués à un joueur, pour une reprise éventuelle. */
+    PROTO_RESUME = 11   /**< Demande de reprise : partie, jeton et coups connus du client. */
+} ProtoType;
+
+/**
+ * @enum ProtoRole
+ * @brief Couleur annoncée dans une trame HELLO.
+ */
+typedef enum {
+    PROTO_ROLE_ANY  = 0, /**< Pas de préférence (demande du client). */
+    PROTO_ROLE_BLUE = 1, /**< Le destinataire joue les bleus. */
+    PROTO_ROLE_RED  = 2, /**< Le destinataire joue les rouges. */
+    PROTO_ROLE_SPECTATOR = 3, /**< Le client ne joue pas et suit une partie. */
+    PROTO_ROLE_RESUME = 4     /**< Le client reprend sa place dans une partie (trame RESUME). */
+} ProtoRole;
+
+/**
+ * @enum ProtoError
+ * @brief Codes des trames ERROR.
+ */
+typedef enum {
+    PROTO_ERR_VERSION   = 1, /**< Version non prise en charge. */
+    PROTO_ERR_MALFORMED = 2, /**< Trame illisible ou inattendue. */
+    PROTO_ERR_SEQUENCE  = 3, /**< Numéro de séquence incorrect. */
+    PROTO_ERR_TURN      = 4, /**< Coup joué hors de son tour. */
+    PROTO_ERR_ILLEGAL   = 5, /**< Coup refusé par les règles. */
+    PROTO_ERR_NO_GAME   = 6  /**< Partie demandée par WATCH ou RESUME inconnue ou terminée, ou jeton refusé. */
+} ProtoError;
+
+/**
+ * @struct ProtoMsg
+ * @brief Une trame décodée.
+ */
+typedef struct {
+    uint8_t type;  /**< Un `ProtoType`. */
+    uint8_t flags; /**< Drapeaux (PROTO_FLAG_BROADCAST). */
+    uint32_t seq;  /**< Numéro de séquence (attribué par `proto_writer_push` à l'envoi). */
+    union {
+        struct { uint8_t version, role; } hello;        /**< PROTO_HELLO. */
+        struct { uint8_t from, to; } move;              /**< PROTO_MOVE : indices 0 à 80. */
+        struct { uint32_t blue_ms, red_ms; } clock;     /**< PROTO_CLOCK. */
+        uint64_t ping;                                  /**< PROTO_PING et PROTO_PONG. */
+        GameState state;                                /**< PROTO_STATE. */
+        uint8_t error;                                  /**< PROTO_ERROR : un `ProtoError`. */
+        uint32_t game;                                  /**< PROTO_WATCH : identifiant de partie. */
+        struct { uint32_t game; uint64_t token; uint32_t plies; } session; /**< PROTO_SESSION, et PROTO_RESUME avec `plies`. */
+    } u;
+} ProtoMsg;
+
+/**
+ * @struct ProtoReader
+ * @brief Octets reçus d'une connexion, pas encore décodés.
+ *
+ * La couche réseau lit dans `buf + len` (au plus PROTO_BUF_SIZE - len
+ * octets) et augmente `len`, puis appelle `proto_reader_next`.
+ */
+typedef struct {
+    uint8_t buf[PROTO_BUF_SIZE]; /**< Octets reçus. */
+    int len;                     /**< Nombre d'octets dans `buf`. */
+    uint32_t next_seq;           /**< Séquence attendue de la prochaine trame. */
+} ProtoReader;
+
+/**
+ * @struct ProtoWriter
+ * @brief Trames codées, en attente d'envoi sur une connexion.
+ *
+ * La couche réseau envoie `buf` (en une fois si possible) puis retire les
+ * octets envoyés avec `proto_writer_consume`.
+ */
+typedef struct {
+    uint8_t buf[PROTO_BUF_SIZE]; /**< Trames codées. */
+    int len;                     /**< Nombre d'octets dans `buf`. */
+    uint32_t next_seq;           /**< Séquence de la prochaine trame. */
+} ProtoWriter;
+
+/**
+ * @brief Code une trame.
+ * @param m La trame (ses champs `seq` et `flags` sont utilisés tels quels).
+ * @param out Le tampon de sortie.
+ * @param cap La capacité du tampon.
+ * @return Le nombre d'octets écrits, ou -1 si la trame est invalide ou le tampon trop petit.
+ */
+int proto_encode(const ProtoMsg *m, uint8_t *out, int cap);
+
+/**
+ * @brief Décode la première trame d'un tampon.
+ * @param in Les octets reçus.
+ * @param len Leur nombre.
+ * @param[out] m La trame décodée.
+ * @return Le nombre d'octets consommés, 0 si la trame est incomplète, -1 si elle est invalide.
+ */
+int proto_decode(const uint8_t *in, int len, ProtoMsg *m);
+
+/**
+ * @brief Prépare un lecteur (tampon vide, séquence attendue 0).
+ * @param r Le lecteur.
+ */
+void proto_reader_init(ProtoReader *r);
+
+/**
+ * @brief Extrait la prochaine trame complète d'un lecteur et vérifie sa séquence.
+ *
+ * Une trame STATE diffusée (PROTO_FLAG_BROADCAST) fixe la séquence
+ * attendue au lieu d'être contrôlée : c'est le point de départ, ou de
+ * reprise, du flux d'un spectateur.
+ * @param r Le lecteur.
+ * @param[out] m La trame.
+ * @return 1 si une trame est extraite, 0 s'il faut plus d'octets, ou -PROTO_ERR_MALFORMED /
+ * -PROTO_ERR_SEQUENCE en cas d'erreur.
+ */
+int proto_reader_next(ProtoReader *r, ProtoMsg *m);
+
+/**
+ * @brief Prépare un écrivain (tampon vide, séquence 0).
+ * @param w L'écrivain.
+ */
+void proto_writer_init(ProtoWriter *w);
+
+/**
+ * @brief Ajoute une trame à envoyer, numérotée avec la séquence suivante.
+ * @param w L'écrivain.
+ * @param m La trame (son champ `seq` est ignoré).
+ * @return 0 si succès, -1 si la trame est invalide ou le tampon plein.
+ */
+int proto_writer_push(ProtoWriter *w, const ProtoMsg *m);
+
+/**
+ * @brief Retire du tampon les octets déjà envoyés.
+ * @param w L'écrivain.
+ * @param n Le nombre d'octets envoyés.
+ */
+void proto_writer_consume(ProtoWriter *w, int n);
+
+#endif
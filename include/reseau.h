@@ -10,6 +10,8 @@
 #ifndef RESEAU_H
 #define RESEAU_H
 
+#include "protocole.h"
+
 /**
  * @brief Met le programme en mode serveur et attend la connexion d'un client.
  * @return Le descripteur de fichier du socket connecté au client, ou -1 en cas d'erreur.
@@ -23,19 +25,82 @@ int net_wait_for_client();
 int net_connect_to_server();
 
 /**
- * @brief Envoie un coup au travers d'un socket.
+ * @brief Se connecte au serveur de `config` sans attendre plus d'un délai donné.
+ *
+ * Utilisée pour les reconnexions, pendant lesquelles la boucle réseau doit
+ * rester attentive à une demande d'arrêt.
+ * @param timeout_ms Attente maximale de l'établissement de la connexion.
+ * @return Le socket connecté, en mode non bloquant, ou -1 en cas d'erreur ou de délai dépassé.
+ */
+int net_connect_timeout(int timeout_ms);
+
+#define NET_SEND_TIMEOUT_MS      2000  /**< Attente maximale d'un socket plein lors d'un envoi. */
+#define NET_HANDSHAKE_TIMEOUT_MS 10000 /**< Attente maximale de la trame HELLO d'un client. */
+
+/**
+ * @brief Passe un socket en mode non bloquant.
+ * @param sock Le socket.
+ * @return 0 si succès, -1 en cas d'erreur.
+ */
+int net_set_nonblocking(int sock);
+
+/**
+ * @brief Règle un socket de partie pour la latence et décrit les options obtenues.
+ *
+ * Active TCP_NODELAY (un coup part sans attendre l'acquittement du
+ * précédent) et SO_KEEPALIVE, puis relit ces options et la taille des
+ * tampons du noyau.
+ * @param sock Le socket connecté.
+ * @param[out] report Description des options, ex: "TCP_NODELAY=1 SO_KEEPALIVE=1 SO_SNDBUF=... SO_RCVBUF=...".
+ * @param len Taille de `report`.
+ * @return 0 si toutes les options ont été appliquées, -1 sinon.
+ */
+int net_tune_socket(int sock, char *report, int len);
+
+/**
+ * @brief Envoie un tampon complet au travers d'un socket.
+ *
+ * Fonctionne aussi sur un socket non bloquant : l'envoi attend au plus
+ * NET_SEND_TIMEOUT_MS que le socket accepte la suite des données. Un pair
+ * déconnecté est signalé par une erreur, sans SIGPIPE.
  * @param sock Le socket connecté.
- * @param move La chaîne de 4 caractères représentant le coup (ex: "A1A3").
+ * @param data Les données (en général plusieurs trames codées).
+ * @param len Leur taille.
  * @return 0 si succès, -1 en cas d'erreur.
  */
-int net_send_move(int sock, const char *move);
+int net_send_all(int sock, const void *data, int len);
+
+/**
+ * @brief Envoie sans attendre ce qu'un socket non bloquant accepte d'un tampon.
+ *
+ * Un pair déconnecté est signalé par une erreur, sans SIGPIPE.
+ * @param sock Le socket connecté.
+ * @param data Les données.
+ * @param len Leur taille.
+ * @return Le nombre d'octets envoyés (0 si le socket est plein), ou -1 en cas d'erreur.
+ */
+int net_send_available(int sock, const void *data, int len);
+
+/**
+ * @brief Attend une trame complète sur un socket.
+ *
+ * Utilisée pour la poignée de main, avant le lancement de la boucle réseau.
+ * @param sock Le socket connecté.
+ * @param r Le lecteur de la connexion (les octets en trop y restent).
+ * @param[out] m La trame reçue.
+ * @param timeout_ms Attente maximale, ou -1 pour attendre indéfiniment.
+ * @return 0 si succès, -1 en cas d'erreur, de trame invalide ou de délai dépassé.
+ */
+int net_recv_frame(int sock, ProtoReader *r, ProtoMsg *m, int timeout_ms);
 
 /**
- * @brief Reçoit un coup depuis un socket.
+ * @brief Lit les octets disponibles sur un socket non bloquant.
  * @param sock Le socket connecté.
- * @param buffer Buffer d’au moins 5 octets pour stocker le coup reçu (4 + '\0').
- * @return 0 si succès, -1 en cas d'erreur ou de déconnexion.
+ * @param buffer Le tampon de réception.
+ * @param len Le nombre maximal d'octets à lire.
+ * @return Le nombre d'octets lus (0 si aucune donnée n'est disponible),
+ * ou -1 si la connexion est fermée ou en erreur.
  */
-int net_recv_move(int sock, char *buffer);
+int net_recv_available(int sock, char *buffer, int len);
 
 #endif
\ No newline at end of file
@@ -10,39 +10,83 @@
 #ifndef RESEAU_INTEGRATION_H
 #define RESEAU_INTEGRATION_H
 
-/**
- * @struct MoveData
- * @brief Structure pour passer les informations d'un coup à l'interface GTK de manière asynchrone.
- */
-typedef struct
-{
-    char src_id[3]; /**< Identifiant de la case de départ (ex: "A1"). */
-    char dst_id[3]; /**< Identifiant de la case d'arrivée (ex: "B1"). */
-} MoveData;
+#define NET_FRAME_TIMEOUT_MS 5000 /**< Délai maximal pour recevoir la fin d'une trame commencée. */
+#define NET_PING_INTERVAL_S  5    /**< Intervalle entre deux PING de mesure de l'aller-retour. */
+#define NET_RESUME_WINDOW_MS 30000 /**< Durée des tentatives de reprise après une coupure. */
+#define NET_RESUME_RETRY_MS  1000  /**< Intervalle entre deux tentatives, et attente maximale de chacune. */
 
 /**
  * @brief Initialise l'état réseau du jeu.
+ *
+ * Le socket est réglé par `net_tune_socket` (TCP_NODELAY...) et les options
+ * obtenues sont affichées. Si `config.journal_path` est renseigné, chaque
+ * coup accepté par l'arbitre y est enregistré (`journal.h`) et synchronisé
+ * sur disque.
  * @param sock Le socket de communication.
  * @param server_mode 1 si le programme est un serveur, 0 si c'est un client.
  */
 void network_init(int sock, int server_mode);
 
 /**
- * @brief Boucle d'écoute réseau à exécuter dans un processus dédié.
+ * @brief Échange les trames HELLO avec le pair et fixe la couleur du joueur local.
+ *
+ * L'hôte (serveur) attend la trame du client au plus NET_HANDSHAKE_TIMEOUT_MS,
+ * vérifie sa version et lui attribue les bleus. Le client annonce sa version
+ * puis attend la couleur choisie par le pair sans limite de temps : un
+ * serveur de parties ne répond qu'une fois l'adversaire trouvé.
+ * @return 0 si succès, -1 en cas d'erreur ou de version incompatible.
  */
-void network_listen_loop(void);
+int network_handshake(void);
 
 /**
- * @brief Formate et envoie un coup sur le réseau.
- * @param src_id Identifiant de la case de départ.
- * @param dst_id Identifiant de la case d'arrivée.
+ * @brief Indique la couleur du joueur local, connue après `network_handshake`.
+ * @return 1 si le joueur local joue les bleus, 0 s'il joue les rouges.
  */
-void send_move_to_network(const char *src_id, const char *dst_id);
+int network_plays_blue(void);
 
 /**
- * @brief Traite un coup reçu du réseau et l'applique à l'interface.
- * @param move La chaîne de 4 caractères représentant le coup.
+ * @brief Lance la boucle réseau (epoll) dans un thread dédié.
+ *
+ * Le socket passe en mode non bloquant. Les coups reçus sont transmis à
+ * l'interface par une file de MOVE_QUEUE_CAPACITY coups, vidée par une
+ * source GTK ; les PING reçoivent leur PONG.
+ *
+ * Un PING part toutes les NET_PING_INTERVAL_S secondes, et chaque étape du
+ * trajet des coups est mesurée (`latence.h`) ; le signal SIGUSR1 affiche les
+ * histogrammes, qui le sont aussi à l'arrêt de la boucle. Une fermeture ou une erreur
+ * de la connexion, un abandon ou une trame ERROR du pair, une trame
+ * invalide, ou une trame restée incomplète plus de NET_FRAME_TIMEOUT_MS,
+ * termine la boucle et la partie. Le thread dort tant qu'aucune donnée
+ * n'arrive.
+ *
+ * Si le pair est un serveur de parties (trame SESSION reçue), une connexion
+ * fermée ou en erreur est d'abord reprise : une reconnexion est tentée
+ * toutes les NET_RESUME_RETRY_MS pendant NET_RESUME_WINDOW_MS, les coups
+ * manqués sont rejoués et la position du serveur, qui fait foi, est
+ * appliquée au plateau.
+ * @return 0 si succès, -1 si la partie n'est pas en réseau ou en cas d'erreur.
+ */
+int network_start(void);
+
+/**
+ * @brief Arrête la boucle réseau, attend la fin de son thread et ferme le socket.
+ *
+ * Le thread est réveillé par un eventfd. Sans effet si la boucle n'est pas lancée.
+ * Le journal de la partie, s'il est ouvert, reçoit la position finale et est fermé.
+ */
+void network_stop(void);
+
+/**
+ * @brief Envoie un coup sur le réseau dans une trame MOVE.
+ *
+ * Le coup est d'abord joué par l'arbitre : s'il le refuse, le plateau ne
+ * lui correspond plus, et la partie est abandonnée (trame RESIGN) au lieu
+ * d'envoyer le coup.
+ * @param src_id Identifiant de la case de départ.
+ * @param dst_id Identifiant de la case d'arrivée.
+ * @return 0 si la partie continue (coup envoyé, ou partie locale), -1 si le
+ * coup est refusé et la partie terminée : l'appelant ne doit plus l'appliquer.
  */
-void apply_network_move(const char *move);
+int send_move_to_network(const char *src_id, const char *dst_id);
 
 #endif
\ No newline at end of file
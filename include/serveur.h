@@ -0,0 +1,109 @@
+/**
+ * @file serveur.h
+ * @authors Groupe 8
+ * @brief serveur.h déclare le serveur de parties sans interface graphique.
+ *
+ * Le serveur accepte des connexions en continu et forme les parties deux à
+ * deux dans l'ordre d'arrivée : le premier client joue les bleus, le second
+ * les rouges. Chaque partie est un `GameState` tenu dans un tableau
+ * préalloué ; les coups reçus y sont joués puis relayés à l'adversaire.
+ * Les échanges suivent le protocole de `protocole.h` : la trame HELLO
+ * envoyée à l'appariement indique à chaque client sa couleur.
+ * Les sockets sont répartis sur quelques threads epoll, chaque partie
+ * restant attachée à un seul thread.
+ *
+ * Un joueur dont la connexion est perdue garde sa place
+ * SRV_RESUME_TIMEOUT_MS : il la reprend avec le jeton reçu dans sa trame
+ * SESSION, et reçoit les coups manqués puis la position.
+ *
+ * Une connexion qui n'a pas achevé sa présentation (HELLO, puis WATCH ou
+ * RESUME) après SRV_HANDSHAKE_TIMEOUT_MS est fermée ; le joueur en attente
+ * d'un adversaire n'est pas concerné.
+ *
+ * Avec un répertoire de journaux, chaque partie est enregistrée dans son
+ * propre journal (`journal.h`), écrit avant l'envoi des coups qu'il contient.
+ *
+ * Des spectateurs peuvent suivre une partie (trame WATCH) : ils reçoivent
+ * la position puis chaque coup, codé une seule fois et partagé entre eux.
+ * Un spectateur trop lent ne freine pas la partie : ses coups en retard
+ * sont remplacés par une nouvelle position, puis il est déconnecté s'il
+ * reste en retard.
+ */
+
+#ifndef SERVEUR_H
+#define SERVEUR_H
+
+#include "journal.h"
+#include <stdint.h>
+
+#define SRV_MAX_WORKERS       64   /**< Nombre maximal de threads de traitement. */
+#define SRV_DEFAULT_WORKERS   4    /**< Nombre de threads de traitement par défaut. */
+#define SRV_DEFAULT_MAX_GAMES 4096 /**< Nombre de parties simultanées par défaut. */
+#define SRV_LISTEN_BACKLOG    1024 /**< File d'attente des connexions entrantes. */
+#define SRV_EVENTS            64   /**< Événements epoll traités par appel. */
+#define SRV_MAX_GAMES         0xFFFF /**< Places de parties au plus (l'identifiant en garde l'indice sur 16 bits). */
+#define SRV_SPECTATOR_QUEUE   64   /**< Trames en attente d'envoi par spectateur. */
+#define SRV_SPECTATOR_RESYNCS 4    /**< Resynchronisations tolérées avant de déconnecter un spectateur. */
+#define SRV_RESUME_TIMEOUT_MS 30000 /**< Attente d'un joueur déconnecté avant d'interrompre sa partie. */
+#define SRV_HANDSHAKE_TIMEOUT_MS 10000 /**< Attente des premières trames d'une connexion avant de la fermer. */
+#define SRV_HISTORY           64   /**< Coups gardés par partie pour les reprises (une partie en compte au plus 64). */
+
+/**
+ * @struct ServerConfig
+ * @brief Paramètres du serveur de parties.
+ */
+typedef struct {
+    int port;      /**< Port d'écoute TCP. */
+    int workers;   /**< Nombre de threads de traitement (1 à SRV_MAX_WORKERS). */
+    int max_games; /**< Nombre maximal de parties simultanées (1 à SRV_MAX_GAMES). */
+    const char *journal_dir;  /**< Répertoire des journaux de parties, NULL pour ne pas en écrire. */
+    JournalSync journal_sync; /**< Politique de synchronisation des journaux. */
+    int journal_sync_ms;      /**< Intervalle pour JOURNAL_SYNC_INTERVAL. */
+} ServerConfig;
+
+/**
+ * @struct ServerStats
+ * @brief Compteurs du serveur depuis son lancement.
+ */
+typedef struct {
+    uint64_t accepted;       /**< Connexions acceptées. */
+    uint64_t refused;        /**< Connexions refusées faute de place. */
+    uint64_t games_started;  /**< Parties formées. */
+    uint64_t games_finished; /**< Parties terminées selon les règles. */
+    uint64_t games_aborted;  /**< Parties interrompues (déconnexion, coup refusé). */
+    uint64_t moves;          /**< Coups joués et relayés. */
+    uint64_t spectators;     /**< Spectateurs acceptés. */
+    uint64_t spectators_dropped; /**< Spectateurs déconnectés car trop lents. */
+    uint64_t resyncs;        /**< Positions envoyées à un spectateur en retard. */
+    uint64_t journal_errors; /**< Journaux abandonnés après une erreur d'écriture. */
+    uint64_t resumed;        /**< Joueurs revenus dans leur partie après une coupure. */
+    int active_games;        /**< Parties en cours. */
+    int active_spectators;   /**< Spectateurs connectés à une partie en cours. */
+} ServerStats;
+
+/**
+ * @brief Lance le serveur et traite les connexions jusqu'à `server_stop`.
+ *
+ * Le thread appelant accepte les connexions et forme les parties ; les
+ * threads de traitement relaient les coups. Toutes les connexions sont
+ * fermées au retour.
+ * @param cfg La configuration.
+ * @return 0 après un arrêt normal, -1 si le serveur n'a pas pu démarrer.
+ */
+int server_run(const ServerConfig *cfg);
+
+/**
+ * @brief Demande l'arrêt du serveur.
+ *
+ * Utilisable depuis un gestionnaire de signal : seul un `write` sur un
+ * eventfd est effectué.
+ */
+void server_stop(void);
+
+/**
+ * @brief Récupère les compteurs du serveur.
+ * @param[out] out Structure à remplir.
+ */
+void server_get_stats(ServerStats *out);
+
+#endif
@@ -0,0 +1,50 @@
+/**
+ * @file file_coups.c
+ * @brief File sans verrou des coups reçus du réseau.
+ * @authors Groupe 8
+ *
+ * Les indices croissent sans fin et sont ramenés à la capacité par un
+ * masque ; leur différence donne le nombre de coups en attente. Chaque côté
+ * publie son indice avec une écriture « release » et lit celui de l'autre
+ * avec une lecture « acquire » : un coup n'est visible du consommateur
+ * qu'une fois entièrement écrit, et sa place n'est réutilisée qu'une fois lue.
+ */
+
+#include "file_coups.h"
+
+_Static_assert((MOVE_QUEUE_CAPACITY & (MOVE_QUEUE_CAPACITY - 1)) == 0,
+               "MOVE_QUEUE_CAPACITY doit être une puissance de 2");
+
+/**
+ * @see file_coups.h
+ */
+void move_queue_init(MoveQueue *q) {
+    atomic_init(&q->head, 0);
+    atomic_init(&q->tail, 0);
+}
+
+/**
+ * @see file_coups.h
+ */
+int move_queue_push(MoveQueue *q, QueuedMove m) {
+    uint32_t tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+    uint32_t head = atomic_load_explicit(&q->head, memory_order_acquire);
+    if (tail - head == MOVE_QUEUE_CAPACITY) return -1;
+
+    q->slots[tail & (MOVE_QUEUE_CAPACITY - 1)] = m;
+    atomic_store_explicit(&q->tail, tail + 1, memory_order_release);
+    return 0;
+}
+
+/**
+ * @see file_coups.h
+ */
+int move_queue_pop(MoveQueue *q, QueuedMove *m) {
+    uint32_t head = atomic_load_explicit(&q->head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&q->tail, memory_order_acquire);
+    if (head == tail) return 0;
+
+    *m = q->slots[head & (MOVE_QUEUE_CAPACITY - 1)];
+    atomic_store_explicit(&q->head, head + 1, memory_order_release);
+    return 1;
+}
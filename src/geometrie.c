@@ -0,0 +1,98 @@
+/**
+ * @file geometrie.c
+ * @brief Construction des tables de géométrie du plateau.
+ * @authors Groupe 8
+ *
+ * geometrie.c calcule une fois pour toutes, au chargement du programme, les
+ * rayons de glissement et les voisins de chaque case. Les boucles de l'IA,
+ * des règles et de l'interface parcourent ces tables au lieu de refaire les
+ * calculs de coordonnées et de bornes.
+ */
+
+#include "geometrie.h"
+
+#include <string.h>
+
+Rayons geo_rayons[NB_CASES];                 /**< @see geometrie.h */
+int8_t geo_voisin[NB_CASES][NB_DIRECTIONS];  /**< @see geometrie.h */
+int8_t geo_voisin2[NB_CASES][NB_DIRECTIONS]; /**< @see geometrie.h */
+
+const char *const geo_noms_directions[NB_DIRECTIONS] = {"haut", "bas", "gauche", "droite"};
+
+static const int DR[NB_DIRECTIONS] = {-1, 1, 0, 0}; /**< Déplacement en ligne de chaque direction. */
+static const int DC[NB_DIRECTIONS] = {0, 0, -1, 1}; /**< Déplacement en colonne de chaque direction. */
+
+/**
+ * @brief Remplit les tables ; exécutée automatiquement avant `main`.
+ */
+__attribute__((constructor)) static void geometrie_init(void)
+{
+    for (int r = 0; r < SIZE; r++)
+    {
+        for (int c = 0; c < SIZE; c++)
+        {
+            int i = CASE_IDX(r, c);
+            for (int d = 0; d < NB_DIRECTIONS; d++)
+            {
+                int n = 0;
+                int nr = r + DR[d], nc = c + DC[d];
+                while (nr >= 0 && nr < SIZE && nc >= 0 && nc < SIZE)
+                {
+                    geo_rayons[i].cases[d][n++] = (uint8_t)CASE_IDX(nr, nc);
+                    nr += DR[d];
+                    nc += DC[d];
+                }
+                geo_rayons[i].longueur[d] = (uint8_t)n;
+                geo_voisin[i][d] = n >= 1 ? (int8_t)geo_rayons[i].cases[d][0] : -1;
+                geo_voisin2[i][d] = n >= 2 ? (int8_t)geo_rayons[i].cases[d][1] : -1;
+            }
+        }
+    }
+}
+
+/**
+ * @see geometrie.h
+ */
+int geo_direction(const char *mouvement)
+{
+    if (!mouvement)
+        return -1;
+    for (int d = 0; d < NB_DIRECTIONS; d++)
+    {
+        if (strcmp(mouvement, geo_noms_directions[d]) == 0)
+            return d;
+    }
+    return -1;
+}
+
+/**
+ * @see geometrie.h
+ */
+int geo_direction_entre(int from, int to)
+{
+    int r1 = CASE_LIGNE(from), c1 = CASE_COL(from);
+    int r2 = CASE_LIGNE(to), c2 = CASE_COL(to);
+    if (from == to || (r1 != r2 && c1 != c2))
+        return -1;
+    return r2 < r1 ? DIR_HAUT : r2 > r1 ? DIR_BAS : c2 < c1 ? DIR_GAUCHE : DIR_DROITE;
+}
+
+/**
+ * @see geometrie.h
+ */
+int geo_index_depuis_id(const char *id)
+{
+    if (!id || id[0] < 'A' || id[0] >= 'A' + SIZE || id[1] < '1' || id[1] > '0' + SIZE)
+        return -1;
+    return CASE_IDX(SIZE - (id[1] - '0'), id[0] - 'A');
+}
+
+/**
+ * @see geometrie.h
+ */
+void geo_id_depuis_index(int i, char *id)
+{
+    id[0] = (char)('A' + CASE_COL(i));
+    id[1] = (char)('0' + SIZE - CASE_LIGNE(i));
+    id[2] = '\0';
+}
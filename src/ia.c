@@ -12,12 +12,20 @@
 #include "ia.h"
 #include "jeu.h"
 #include "config.h"
+#include "geometrie.h"
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
 #include <stdint.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 // Variables globales (définition)
 
@@ -74,6 +82,16 @@ static inline bool ally (int p,bool blueSide){return blueSide ? is_blue(p) : is_
  */
 static inline bool enemy(int p,bool blueSide){return blueSide ? is_red(p)  : is_blue(p);}
 
+/**
+ * @brief Compare deux coups.
+ * @param a Premier coup.
+ * @param b Second coup.
+ * @return true si les deux coups ont mêmes cases de départ et d'arrivée.
+ */
+static inline bool same_move(const Move* a, const Move* b) {
+    return a->r1==b->r1 && a->c1==b->c1 && a->r2==b->r2 && a->c2==b->c2;
+}
+
 /**
  * @brief Retourne un index unique pour chaque type de pièce.
  * @param p Le type de pion (ex: SOLDAT_BLEU).
@@ -136,10 +154,262 @@ static uint64_t zobrist_hash(const Board *b, bool blueToPlay) {
     return h;
 }
 
+/**
+ * @brief Met à jour une clé de Zobrist après un coup, sans reparcourir le plateau.
+ *
+ * Seules changent la case de départ, la case d'arrivée et ses voisines
+ * (captures par poussée ou en sandwich).
+ * @param key Clé de la position avant le coup.
+ * @param before La position avant le coup.
+ * @param after La position après le coup.
+ * @param m Le coup joué.
+ * @return La clé de `after`, trait inversé.
+ */
+static uint64_t zobrist_after_move(uint64_t key, const Board *before, const Board *after, const Move *m) {
+    const int8_t *b0 = &before->pion[0][0], *b1 = &after->pion[0][0];
+    int to = CASE_IDX(m->r2, m->c2);
+    int from = CASE_IDX(m->r1, m->c1);
+    int changed[2 + NB_DIRECTIONS] = { from, to };
+    for (int d=0; d<NB_DIRECTIONS; d++)    // la case de départ est déjà comptée
+        changed[2+d] = (geo_voisin[to][d] == from) ? -1 : geo_voisin[to][d];
+
+    for (int k=0; k<2 + NB_DIRECTIONS; k++) {
+        int i = changed[k];
+        if (i < 0 || b0[i] == b1[i]) continue;
+        int p0 = piece_index(b0[i]), p1 = piece_index(b1[i]);
+        if (p0) key ^= (&Zobrist[p0][0][0])[i];
+        if (p1) key ^= (&Zobrist[p1][0][0])[i];
+    }
+    return key ^ Z_SIDE;
+}
+
+// Historique des positions (répétitions)
+
+/**
+ * @struct PositionHistory
+ * @brief Pile des clés Zobrist depuis le début de la partie jusqu'au nœud courant.
+ *
+ * Une capture est irréversible : aucune position antérieure ne peut se
+ * reproduire, la recherche de répétition s'arrête donc à la dernière capture.
+ * Le filtre compte les clés présentes par alvéole, ce qui écarte en O(1) le
+ * cas courant d'une position jamais vue.
+ */
+typedef struct {
+    uint64_t keys[HISTORY_MAX];         /**< Clés des positions, de la plus ancienne à la courante. */
+    int16_t  reversibleFrom[HISTORY_MAX]; /**< Indice de la première position atteignable sans capture. */
+    uint8_t  filter[HISTORY_FILTER_SIZE]; /**< Nombre de clés présentes par alvéole. */
+    int      count;                     /**< Nombre de positions dans la pile. */
+} PositionHistory;
+
+static PositionHistory g_game_history; /**< Positions de la partie en cours. */
+static int g_game_last_pieces = -1;    /**< Nombre de pièces de la dernière position de la partie. */
+static RepetitionPolicy g_rep_policy = REP_SCORE_DRAW; /**< Valeur attribuée aux répétitions. */
+static int g_rep_contempt = 0;         /**< Pénalité de répétition pour le camp de la racine. */
+static bool g_root_blue = true;        /**< Camp au trait à la racine de la recherche en cours. */
+
+/**
+ * @brief Empile une position.
+ * @param h L'historique.
+ * @param key La clé de la position.
+ * @param irreversible true si le coup qui y mène a capturé une pièce.
+ */
+static inline void history_push(PositionHistory *h, uint64_t key, bool irreversible) {
+    int i = h->count++;
+    h->keys[i] = key;
+    h->reversibleFrom[i] = (int16_t)((irreversible || i == 0) ? i : h->reversibleFrom[i-1]);
+    h->filter[key & (HISTORY_FILTER_SIZE-1)]++;
+}
+
+/**
+ * @brief Dépile la position courante.
+ * @param h L'historique.
+ */
+static inline void history_pop(PositionHistory *h) {
+    uint64_t key = h->keys[--h->count];
+    h->filter[key & (HISTORY_FILTER_SIZE-1)]--;
+}
+
+/**
+ * @brief Copie les `count` premières positions d'un historique.
+ * @param dst L'historique à remplir.
+ * @param src L'historique source.
+ * @param count Nombre de positions à copier.
+ */
+static void history_copy(PositionHistory *dst, const PositionHistory *src, int count) {
+    memcpy(dst->keys, src->keys, (size_t)count * sizeof(uint64_t));
+    memcpy(dst->reversibleFrom, src->reversibleFrom, (size_t)count * sizeof(int16_t));
+    memset(dst->filter, 0, sizeof(dst->filter));
+    for (int i=0; i<count; i++) dst->filter[dst->keys[i] & (HISTORY_FILTER_SIZE-1)]++;
+    dst->count = count;
+}
+
+/**
+ * @brief Indique si la position courante a déjà été rencontrée.
+ *
+ * Seules les positions depuis la dernière capture, avec le même camp au
+ * trait (un ply sur deux), sont examinées.
+ * @param h L'historique (la position courante est au sommet).
+ * @return true si la position courante est une répétition.
+ */
+static inline bool history_is_repetition(const PositionHistory *h) {
+    int i = h->count - 1;
+    uint64_t key = h->keys[i];
+    if (h->filter[key & (HISTORY_FILTER_SIZE-1)] < 2) return false;
+    for (int j = i - 2; j >= h->reversibleFrom[i]; j -= 2)
+        if (h->keys[j] == key) return true;
+    return false;
+}
+
 // Génération / Simulation  
 
-static const int DR4[4] = {-1, 1, 0, 0}; /**< Déplacements de ligne pour N, S, O, E. */
-static const int DC4[4] = { 0, 0,-1, 1}; /**< Déplacements de colonne pour N, S, O, E. */
+/**
+ * @struct Occupancy
+ * @brief Occupation du plateau, ligne par ligne et colonne par colonne (9 bits chacune).
+ */
+typedef struct {
+    uint16_t rows[SIZE]; /**< Bit c de rows[r] : case (r,c) occupée. */
+    uint16_t cols[SIZE]; /**< Bit r de cols[c] : case (r,c) occupée. */
+} Occupancy;
+
+/** Cases vides atteignables depuis la position `pos` d'une ligne de 9 cases dont l'occupation est `occ`. */
+static uint16_t g_slide[SIZE][1 << SIZE];
+
+#define BYTES_LOW7   0x7F7F7F7F7F7F7F7FULL /**< 7 bits de poids faible de chaque octet. */
+#define COL_LO_MASK  0x0040201008040201ULL /**< Bits 0, 9, ..., 54 : une colonne sur les lignes 0 à 6. */
+#define COL_HI_MASK  0x0000000000000201ULL /**< Bits 0 et 9 : une colonne sur les lignes 7 et 8. */
+
+/**
+ * @brief Marque les octets non nuls d'un mot de 8 cases.
+ * @param w Huit cases consécutives du plateau.
+ * @return Le bit de poids fort de chaque octet non nul, les autres bits à 0.
+ */
+static inline uint64_t nonzero_bytes(uint64_t w) {
+    return (((w & BYTES_LOW7) + BYTES_LOW7) | w) & ~BYTES_LOW7;
+}
+
+/**
+ * @brief Lit les cases du plateau sous forme d'un masque de 81 bits.
+ * @param b Le plateau.
+ * @param gather8 Fonction qui ramène les 8 bits de poids fort des octets d'un mot sur 8 bits.
+ * @return Bit i à 1 si la case i (ligne * SIZE + colonne) est occupée.
+ */
+static inline unsigned __int128 occupancy_bits(const Board* b, unsigned (*gather8)(uint64_t)) {
+    const int8_t *cells = &b->pion[0][0];
+    unsigned __int128 occ = 0;
+    int i = 0;
+    for (; i + 8 <= NB_CASES; i += 8) {
+        uint64_t w; memcpy(&w, cells + i, sizeof w);
+        occ |= (unsigned __int128)gather8(nonzero_bytes(w)) << i;
+    }
+    for (; i < NB_CASES; i++)
+        if (cells[i]) occ |= (unsigned __int128)1 << i;
+    return occ;
+}
+
+/**
+ * @brief Regroupe les bits de poids fort des octets par multiplication « magique ».
+ *
+ * Les produits partiels tombent tous à des positions distinctes : pas de retenue.
+ */
+static inline unsigned gather8_mul(uint64_t t) {
+    return (unsigned)(((t >> 7) * 0x0102040810204080ULL) >> 56);
+}
+
+/**
+ * @brief Calcule l'occupation des lignes et colonnes (version multiplication, toutes machines).
+ * @param b Le plateau.
+ * @param[out] o L'occupation calculée.
+ */
+static void occupancy_mul(const Board* b, Occupancy *o) {
+    unsigned __int128 occ = occupancy_bits(b, gather8_mul);
+    uint64_t lo = (uint64_t)occ & (UINT64_MAX >> 1);   // lignes 0 à 6
+    uint64_t hi = (uint64_t)(occ >> 63);               // lignes 7 et 8
+    for (int r=0; r<SIZE; r++) o->rows[r] = (uint16_t)((occ >> (r*SIZE)) & 0x1FF);
+    for (int c=0; c<SIZE; c++) {
+        uint64_t x = (lo >> c) & COL_LO_MASK;          // bit 9j -> bit 56+j, sans retenue
+        uint64_t y = hi >> c;
+        o->cols[c] = (uint16_t)(((x * 0x0101010101010101ULL) >> 56) | ((y & 1) << 7) | ((y >> 9 & 1) << 8));
+    }
+}
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+
+/**
+ * @brief Regroupe les bits de poids fort des octets avec PEXT.
+ */
+__attribute__((target("bmi2")))
+static inline unsigned gather8_pext(uint64_t t) {
+    return (unsigned)_pext_u64(t, ~BYTES_LOW7);
+}
+
+/**
+ * @brief Calcule l'occupation des lignes et colonnes avec les instructions BMI2.
+ * @param b Le plateau.
+ * @param[out] o L'occupation calculée.
+ */
+__attribute__((target("bmi2")))
+static void occupancy_pext(const Board* b, Occupancy *o) {
+    unsigned __int128 occ = occupancy_bits(b, gather8_pext);
+    uint64_t lo = (uint64_t)occ & (UINT64_MAX >> 1);
+    uint64_t hi = (uint64_t)(occ >> 63);
+    for (int r=0; r<SIZE; r++) o->rows[r] = (uint16_t)((occ >> (r*SIZE)) & 0x1FF);
+    for (int c=0; c<SIZE; c++)
+        o->cols[c] = (uint16_t)(_pext_u64(lo, COL_LO_MASK << c) | (_pext_u64(hi, COL_HI_MASK << c) << 7));
+}
+#endif
+
+/** Calcul d'occupation retenu à l'initialisation selon le processeur. */
+static void (*board_occupancy)(const Board*, Occupancy*) = occupancy_mul;
+
+/**
+ * @brief Remplit la table de glissement et choisit la version du calcul d'occupation.
+ */
+static void slide_init(void) {
+    for (int pos=0; pos<SIZE; pos++) {
+        for (int occ=0; occ < (1 << SIZE); occ++) {
+            uint16_t m = 0;
+            for (int i=pos+1; i<SIZE && !(occ >> i & 1); i++) m |= (uint16_t)(1u << i);
+            for (int i=pos-1; i>=0   && !(occ >> i & 1); i--) m |= (uint16_t)(1u << i);
+            g_slide[pos][occ] = m;
+        }
+    }
+#if defined(__x86_64__) && defined(__GNUC__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("bmi2")) board_occupancy = occupancy_pext;
+#endif
+}
+
+/**
+ * @brief Ajoute les coups d'une pièce le long d'une ligne ou d'une colonne.
+ *
+ * Les destinations sont émises en s'éloignant de la pièce, d'abord vers les
+ * indices décroissants puis croissants, comme le parcours des rayons.
+ *
+ * @param targets Les positions atteignables sur la ligne (masque de 9 bits).
+ * @param pos La position de la pièce sur la ligne.
+ * @param vertical true si la ligne est une colonne.
+ * @param r Ligne de la pièce.
+ * @param c Colonne de la pièce.
+ * @param out Tableau de sortie.
+ * @param n Nombre de coups déjà présents.
+ * @param maxOut Taille du tableau de sortie.
+ * @return Le nouveau nombre de coups.
+ */
+static inline int emit_slides(unsigned targets, int pos, bool vertical, int r, int c, Move out[], int n, int maxOut) {
+    unsigned before = targets & ((1u << pos) - 1), after = targets & ~((1u << pos) - 1);
+    while (before) {
+        int t = 31 - __builtin_clz(before);
+        before &= ~(1u << t);
+        if (n < maxOut) out[n++] = vertical ? (Move){r, c, t, c} : (Move){r, c, r, t};
+    }
+    while (after) {
+        int t = __builtin_ctz(after);
+        after &= after - 1;
+        if (n < maxOut) out[n++] = vertical ? (Move){r, c, t, c} : (Move){r, c, r, t};
+    }
+    return n;
+}
 
 /**
  * @brief Génère tous les coups possibles pour un camp donné.
@@ -150,30 +420,53 @@ static const int DC4[4] = { 0, 0,-1, 1}; /**< Déplacements de colonne pour N, S
  * @return Le nombre de coups générés.
  */
 static int generate_moves(const Board* b, bool blueSide, Move out[], int maxOut) {
+    Occupancy o;
+    board_occupancy(b, &o);
     int n = 0;
     for (int r=0; r<SIZE; r++) {
-        for (int c=0; c<SIZE; c++) {
-            int p = b->pion[r][c];
-            if (!ally(p, blueSide)) continue;
-
-            for (int d=0; d<4; d++) {
-                int nr = r + DR4[d];
-                int nc = c + DC4[d];
-                while (in_bounds(nr,nc) && is_empty(b->pion[nr][nc])) {
-                    if (n < maxOut) {
-                        out[n].r1 = r; out[n].c1 = c;
-                        out[n].r2 = nr; out[n].c2 = nc;
-                        n++;
-                    }
-                    nr += DR4[d];
-                    nc += DC4[d];
-                }
-            }
+        for (unsigned m = o.rows[r]; m; m &= m - 1) {
+            int c = __builtin_ctz(m);
+            if (!ally(b->pion[r][c], blueSide)) continue;
+            unsigned col = g_slide[r][o.cols[c]], row = g_slide[c][o.rows[r]];
+            n = emit_slides(col & ((1u << r) - 1), r, true, r, c, out, n, maxOut);  // haut
+            n = emit_slides(col & ~((1u << r) - 1), r, true, r, c, out, n, maxOut); // bas
+            n = emit_slides(row, c, false, r, c, out, n, maxOut);                   // gauche puis droite
+        }
+    }
+    return n;
+}
+
+/**
+ * @brief Compte les coups possibles d'un camp à partir d'une occupation déjà calculée.
+ * @param b Le plateau de jeu.
+ * @param o L'occupation du plateau.
+ * @param blueSide true pour compter les coups des bleus.
+ * @return Le nombre de coups possibles.
+ */
+static int count_moves_in(const Board* b, const Occupancy* o, bool blueSide) {
+    int n = 0;
+    for (int r=0; r<SIZE; r++) {
+        for (unsigned m = o->rows[r]; m; m &= m - 1) {
+            int c = __builtin_ctz(m);
+            if (!ally(b->pion[r][c], blueSide)) continue;
+            n += __builtin_popcount(g_slide[r][o->cols[c]]) + __builtin_popcount(g_slide[c][o->rows[r]]);
         }
     }
     return n;
 }
 
+/**
+ * @brief Compte les coups possibles d'un camp sans les générer.
+ * @param b Le plateau de jeu.
+ * @param blueSide true pour compter les coups des bleus.
+ * @return Le nombre de coups possibles.
+ */
+static int count_moves(const Board* b, bool blueSide) {
+    Occupancy o;
+    board_occupancy(b, &o);
+    return count_moves_in(b, &o, blueSide);
+}
+
 /**
  * @brief Détermine la direction unitaire d'un mouvement.
  * @param r1 Ligne de départ.
@@ -190,71 +483,94 @@ static void unit_dir(int r1,int c1,int r2,int c2,int*dr,int*dc){
 }
 
 /**
- * @brief Simule une capture par poussée (Seultou).
- * @param b Pointeur vers le plateau à modifier.
- * @param r Ligne de la pièce attaquante.
- * @param c Colonne de la pièce attaquante.
- * @param dr Direction de la ligne d'attaque.
- * @param dc Direction de la colonne d'attaque.
- */
-static void simulate_push_capture(Board* b, int r, int c, int dr, int dc) {
-    if (dr==0 && dc==0) return;
-    int me = b->pion[r][c];
-    bool blueSide = is_blue(me);
-
-    int vr = r + dr, vc = c + dc;        // victime
-    if (!in_bounds(vr,vc)) return;
-
-    int victim = b->pion[vr][vc];
-    if (!enemy(victim, blueSide)) return;
-
-    int gr = r + 2*dr, gc = c + 2*dc;    // garde
-    if (in_bounds(gr,gc)) {
-        int guard = b->pion[gr][gc];
-        if (enemy(guard, blueSide)) return;
-        b->pion[vr][vc] = EMPTY;
-    } else {
-        b->pion[vr][vc] = EMPTY;
-    }
+ * @brief Donne la direction (au sens de geometrie.h) d'un coup orthogonal.
+ * @param m Le coup.
+ * @return La direction du déplacement.
+ */
+static inline int move_direction(const Move* m) {
+    if (m->r2 < m->r1) return DIR_HAUT;
+    if (m->r2 > m->r1) return DIR_BAS;
+    return (m->c2 < m->c1) ? DIR_GAUCHE : DIR_DROITE;
 }
 
 /**
- * @brief Simule une capture par sandwich (Linca).
+ * @brief Simule une capture par poussée (Seultou).
  * @param b Pointeur vers le plateau à modifier.
- * @param r Ligne de la pièce qui vient de bouger.
- * @param c Colonne de la pièce qui vient de bouger.
+ * @param sq Indice de la case de la pièce attaquante.
+ * @param d Direction de l'attaque.
+ * @return Le nombre de pièces capturées (0 ou 1).
  */
-static void simulate_sandwich(Board * b, int r, int c) {
-    int me = b->pion[r][c];
-    bool blueSide = is_blue(me);
+static int simulate_push_capture(Board* b, int sq, int d) {
+    int8_t *cells = &b->pion[0][0];
+    bool blueSide = is_blue(cells[sq]);
+
+    int v = geo_voisin[sq][d];          // victime
+    if (v < 0 || !enemy(cells[v], blueSide)) return 0;
 
-    for (int d=0; d<4; d++) {
-        int nr = r + DR4[d], nc = c + DC4[d];
-        int fr = r + 2*DR4[d], fc = c + 2*DC4[d];
-        if (!in_bounds(nr,nc) || !in_bounds(fr,fc)) continue;
+    int g = geo_voisin2[sq][d];         // garde
+    if (g >= 0 && enemy(cells[g], blueSide)) return 0;
 
-        int nearP = b->pion[nr][nc];
-        int farP  = b->pion[fr][fc];
+    cells[v] = EMPTY;
+    return 1;
+}
 
-        if (enemy(nearP, blueSide) && ally(farP, blueSide)) {
-            b->pion[nr][nc] = EMPTY;
+/**
+ * @brief Simule une capture par sandwich (Linca).
+ * @param b Pointeur vers le plateau à modifier.
+ * @param sq Indice de la case de la pièce qui vient de bouger.
+ * @return Le nombre de pièces capturées.
+ */
+static int simulate_sandwich(Board * b, int sq) {
+    int8_t *cells = &b->pion[0][0];
+    bool blueSide = is_blue(cells[sq]);
+    int captured = 0;
+
+    for (int d=0; d<NB_DIRECTIONS; d++) {
+        int n = geo_voisin[sq][d], f = geo_voisin2[sq][d];
+        if (f < 0) continue;
+
+        if (enemy(cells[n], blueSide) && ally(cells[f], blueSide)) {
+            cells[n] = EMPTY;
+            captured++;
         }
     }
+    return captured;
 }
 
 /**
  * @brief Applique un coup sur le plateau, incluant les captures qui en découlent.
  * @param b Pointeur vers le plateau à modifier.
  * @param m Le coup à appliquer.
+ * @return Le nombre de pièces capturées par le coup.
  */
-static void apply_move(Board* b, const Move* m) {
+static int apply_move(Board* b, const Move* m) {
     int p = b->pion[m->r1][m->c1];
     b->pion[m->r2][m->c2] = p;
     b->pion[m->r1][m->c1] = EMPTY;
 
+    int to = CASE_IDX(m->r2, m->c2);
+    int captured = simulate_push_capture(b, to, move_direction(m));
+    captured += simulate_sandwich(b, to);
+    return captured;
+}
+
+/**
+ * @brief Vérifie qu'un coup est jouable dans une position donnée.
+ * @param b Le plateau.
+ * @param blueSide true si le coup est joué par les bleus.
+ * @param m Le coup à vérifier.
+ * @return true si une pièce alliée glisse en ligne droite sur des cases vides.
+ */
+static bool is_legal_move(const Board* b, bool blueSide, const Move* m) {
+    if (!in_bounds(m->r1,m->c1) || !in_bounds(m->r2,m->c2)) return false;
+    if (!ally(b->pion[m->r1][m->c1], blueSide)) return false;
+    if ((m->r1 != m->r2) == (m->c1 != m->c2)) return false;
+
     int dr,dc; unit_dir(m->r1,m->c1,m->r2,m->c2,&dr,&dc);
-    simulate_push_capture(b, m->r2, m->c2, dr, dc);
-    simulate_sandwich(b, m->r2, m->c2);
+    for (int r=m->r1+dr, c=m->c1+dc; ; r+=dr, c+=dc) {
+        if (!is_empty(b->pion[r][c])) return false;
+        if (r==m->r2 && c==m->c2) return true;
+    }
 }
 
 // Conditions de victoire 
@@ -289,17 +605,141 @@ int check_winner(const Board* b) {
     return 0;
 }
 
+/**
+ * @brief Compte les pièces présentes sur le plateau.
+ * @param b Le plateau.
+ * @return Le nombre de cases occupées.
+ */
+static int count_pieces(const Board* b) {
+    int n = 0;
+    for (int r=0; r<SIZE; r++)
+        for (int c=0; c<SIZE; c++)
+            if (!is_empty(b->pion[r][c])) n++;
+    return n;
+}
+
+// Course des rois
+
+/**
+ * @brief Cherche une pièce sur le plateau.
+ * @param b Le plateau.
+ * @param piece Le code de la pièce.
+ * @return L'indice de la première case qui la porte, -1 si elle est absente.
+ */
+static inline int find_piece(const Board* b, int piece) {
+    const int8_t *p = memchr(&b->pion[0][0], piece, NB_CASES);
+    return p ? (int)(p - &b->pion[0][0]) : -1;
+}
+
+typedef unsigned __int128 Bits81; /**< Ensemble de cases : bit i pour la case i. */
+
+#define BITS81_ALL  (((Bits81)1 << NB_CASES) - 1)
+#define BITS81_COL0 ((((Bits81)COL_LO_MASK << 63) | COL_LO_MASK) & BITS81_ALL) /**< Colonne 0 (bits 0, 9, ..., 72). */
+
+/**
+ * @brief Remplissage par glissement vers les indices croissants (Kogge-Stone).
+ * @param g Cases de départ.
+ * @param p Cases traversables, sans celles qu'un décalage ferait déborder de ligne.
+ * @param s Décalage d'une case dans la direction (1 ou SIZE).
+ * @return Les cases de départ et toutes celles atteintes en glissant.
+ */
+static inline Bits81 fill_up(Bits81 g, Bits81 p, int s) {
+    g |= p & (g << s);     p &= p << s;
+    g |= p & (g << 2*s);   p &= p << 2*s;
+    g |= p & (g << 4*s);   p &= p << 4*s;
+    g |= p & (g << 8*s);
+    return g;
+}
+
+/**
+ * @brief Remplissage par glissement vers les indices décroissants (Kogge-Stone).
+ * @see fill_up
+ */
+static inline Bits81 fill_down(Bits81 g, Bits81 p, int s) {
+    g |= p & (g >> s);     p &= p >> s;
+    g |= p & (g >> 2*s);   p &= p >> 2*s;
+    g |= p & (g >> 4*s);   p &= p >> 4*s;
+    g |= p & (g >> 8*s);
+    return g;
+}
+
+/**
+ * @brief Calcule le nombre de coups dont un roi a besoin pour atteindre sa case but.
+ *
+ * Parcours en largeur sur les glissements, les autres pièces restant
+ * immobiles. Chaque niveau s'obtient d'un bloc sur un masque de 81 bits :
+ * les cases du niveau précédent glissent dans les quatre directions à
+ * travers les cases vides (remplissage de Kogge-Stone).
+ * @param o L'occupation du plateau (roi compris).
+ * @param from Indice de la case du roi.
+ * @param goal Indice de la case but.
+ * @param limit Nombre de coups au-delà duquel le parcours s'arrête.
+ * @return Le nombre de coups, ou `limit + 1` si le but n'est pas atteint à temps.
+ */
+static int king_moves_to_goal(const Occupancy* o, int from, int goal, int limit) {
+    Bits81 occ = 0;
+    for (int r=0; r<SIZE; r++) occ |= (Bits81)o->rows[r] << (r*SIZE);
+
+    Bits81 start = (Bits81)1 << from, target = (Bits81)1 << goal;
+    Bits81 empty = ~(occ & ~start) & BITS81_ALL;   // le roi a quitté sa case
+    Bits81 notCol0 = empty & ~BITS81_COL0, notCol8 = empty & ~(BITS81_COL0 << (SIZE-1));
+    Bits81 seen = start, frontier = start;
+
+    for (int step=1; step<=limit; step++) {
+        Bits81 next = fill_up(frontier, notCol0, 1) | fill_down(frontier, notCol8, 1)
+                    | fill_up(frontier, empty, SIZE) | fill_down(frontier, empty, SIZE);
+        next &= empty & ~seen;
+        if (next & target) return step;
+        if (!next) break;
+        seen |= next;
+        frontier = next;
+    }
+    return limit + 1;
+}
+
+/**
+ * @brief Indique si le camp au trait gagne en amenant son roi sur sa case but.
+ *
+ * Reconnaît statiquement la fin d'une course de rois : la recherche n'a pas
+ * besoin d'un niveau de plus pour la voir.
+ * @param b Le plateau.
+ * @param blueToPlay true si c'est au tour des bleus.
+ * @return true si le roi du camp au trait atteint son but en un coup.
+ */
+static bool king_wins_next(const Board* b, bool blueToPlay) {
+    int king = find_piece(b, blueToPlay ? ROI_BLEU : ROI_ROUGE);
+    if (king < 0) return false;
+
+    // Le but doit être sur la ligne ou la colonne du roi : inutile de
+    // calculer l'occupation sinon.
+    int goal = blueToPlay ? NB_CASES-1 : 0;
+    if (CASE_LIGNE(king) != CASE_LIGNE(goal) && CASE_COL(king) != CASE_COL(goal)) return false;
+
+    Occupancy o;
+    board_occupancy(b, &o);
+    return king_moves_to_goal(&o, king, goal, 1) == 1;
+}
+
+/**
+ * @brief Bonus de course d'un roi selon le nombre de coups qui le séparent de son but.
+ * @param moves Le nombre de coups (`KING_RACE_HORIZON + 1` si hors d'atteinte).
+ * @return Le bonus, nul au-delà de l'horizon.
+ */
+static inline int king_race_bonus(int moves) {
+    return moves > KING_RACE_HORIZON ? 0 : (KING_RACE_HORIZON + 1 - moves) * KING_RACE_WEIGHT;
+}
+
 // Évaluation 
 
 /**
  * @brief Calcule la mobilité d'un camp (nombre de coups légaux).
  * @param b Le plateau de jeu.
+ * @param o L'occupation du plateau.
  * @param blueSide true pour évaluer la mobilité des bleus.
  * @return Le nombre de coups possibles.
  */
-static int mobility(const Board* b, bool blueSide) {
-    Move tmp[MAX_MOVES];
-    return generate_moves(b, blueSide, tmp, MAX_MOVES);
+static int mobility(const Board* b, const Occupancy* o, bool blueSide) {
+    return count_moves_in(b, o, blueSide);
 }
 
 /**
@@ -335,7 +775,14 @@ static int evaluate(const Board* b) {
     if (bestBlueKingDist < 100) score += (30 - bestBlueKingDist);
     if (bestRedKingDist < 100)  score -= (30 - bestRedKingDist);
 
-    score += (mobility(b,true) - mobility(b,false));
+    Occupancy o;
+    board_occupancy(b, &o);
+    score += (mobility(b,&o,true) - mobility(b,&o,false));
+
+    // Course des rois : coups réellement nécessaires, obstacles compris.
+    int blueKing = find_piece(b, ROI_BLEU), redKing = find_piece(b, ROI_ROUGE);
+    if (blueKing >= 0) score += king_race_bonus(king_moves_to_goal(&o, blueKing, NB_CASES-1, KING_RACE_HORIZON));
+    if (redKing >= 0)  score -= king_race_bonus(king_moves_to_goal(&o, redKing, 0, KING_RACE_HORIZON));
 
     for (int r=0; r<SIZE; r++) for (int c=0; c<SIZE; c++) {
         if (b->pion[r][c] == ROI_BLEU) {
@@ -351,12 +798,32 @@ static int evaluate(const Board* b) {
 // Table de transpositions 
 
 /**
- * @brief Accède à une entrée de la table de transposition.
+ * @brief Résume le contenu d'une entrée (hors clé) sur 64 bits.
+ *
+ * La clé est stockée XORée avec ce résumé : une entrée écrite à moitié par un
+ * autre thread de recherche ne passe plus la vérification de `tt_probe`.
+ * @param e L'entrée à résumer.
+ * @return Le résumé du contenu de l'entrée.
+ */
+static inline uint64_t tt_payload(const TTEntry *e) {
+    return  (uint64_t)(uint16_t)e->value
+         | ((uint64_t)(uint8_t)e->depth << 16)
+         | ((uint64_t)e->flag           << 24)
+         | ((uint64_t)(e->best.r1 & 0xF) << 32)
+         | ((uint64_t)(e->best.c1 & 0xF) << 36)
+         | ((uint64_t)(e->best.r2 & 0xF) << 40)
+         | ((uint64_t)(e->best.c2 & 0xF) << 44);
+}
+
+/**
+ * @brief Lit une entrée de la table de transposition.
  * @param key La clé de Zobrist.
- * @return Pointeur vers l'entrée correspondante.
+ * @param[out] out Copie de l'entrée si elle correspond à la clé.
+ * @return true si une entrée valide existe pour cette clé, false sinon.
  */
-static inline TTEntry* tt_probe(uint64_t key) {
-    return &TT[key & TT_MASK];
+static inline bool tt_probe(uint64_t key, TTEntry *out) {
+    *out = TT[key & TT_MASK];
+    return out->flag != TT_EMPTY && (out->key ^ tt_payload(out)) == key;
 }
 
 /**
@@ -369,13 +836,340 @@ static inline TTEntry* tt_probe(uint64_t key) {
  */
 static inline void tt_store(uint64_t key, int depth, int value, TTFlag flag, Move best) {
     TTEntry *e = &TT[key & TT_MASK];
-    if (e->key == 0 || depth >= e->depth) {
-        e->key = key;
-        e->depth = (int8_t)depth;
-        e->value = (int16_t)EVAL_CLAMP(value);
-        e->flag = (uint8_t)flag;
-        e->best = best;
+    if (e->flag == TT_EMPTY || depth >= e->depth) {
+        TTEntry n;
+        n.depth = (int8_t)depth;
+        n.value = (int16_t)EVAL_CLAMP(value);
+        n.flag = (uint8_t)flag;
+        n.best = best;
+        n.key = key ^ tt_payload(&n);
+        *e = n;
+    }
+}
+
+// Persistance de la TT
+
+/**
+ * @struct TTFileHeader
+ * @brief En-tête d'un fichier de table de transposition.
+ *
+ * Les entrées suivent l'en-tête sous forme compacte (TT_FILE_RECORD_SIZE
+ * octets : clé, valeur, profondeur, drapeau, coup sur 16 bits).
+ */
+typedef struct {
+    uint32_t magic;       /**< TT_FILE_MAGIC. */
+    uint32_t version;     /**< TT_FILE_VERSION (format des enregistrements et scores de l'évaluation). */
+    uint32_t entry_size;  /**< sizeof(TTEntry) du programme qui a écrit le fichier. */
+    uint32_t record_size; /**< TT_FILE_RECORD_SIZE. */
+    uint64_t zobrist;     /**< Empreinte des clés de Zobrist utilisées. */
+    uint32_t count;       /**< Nombre d'enregistrements. */
+    uint32_t reserved;    /**< Alignement, toujours 0. */
+} TTFileHeader;
+
+/**
+ * @brief Calcule une empreinte des tables de Zobrist.
+ *
+ * Des clés issues d'une autre graine ne désignent pas les mêmes positions :
+ * un fichier dont l'empreinte diffère est refusé.
+ * @return L'empreinte sur 64 bits.
+ */
+static uint64_t zobrist_fingerprint(void) {
+    uint64_t f = 0xcbf29ce484222325ULL;
+    for (int p=0;p<5;p++)
+        for (int r=0;r<SIZE;r++)
+            for (int c=0;c<SIZE;c++)
+                f = (f ^ Zobrist[p][r][c]) * 0x100000001b3ULL;
+    return (f ^ Z_SIDE) * 0x100000001b3ULL;
+}
+
+/**
+ * @brief Remplit l'en-tête correspondant au programme courant.
+ * @param[out] h L'en-tête à remplir.
+ * @param count Nombre d'enregistrements.
+ */
+static void tt_file_header(TTFileHeader *h, uint32_t count) {
+    memset(h, 0, sizeof(*h));
+    h->magic = TT_FILE_MAGIC;
+    h->version = TT_FILE_VERSION;
+    h->entry_size = (uint32_t)sizeof(TTEntry);
+    h->record_size = TT_FILE_RECORD_SIZE;
+    h->zobrist = zobrist_fingerprint();
+    h->count = count;
+}
+
+/**
+ * @see ia.h
+ */
+int ia_tt_save(const char *path, int minDepth) {
+    if (!TT || !path) return -1;
+
+    char tmp[512];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    FILE *f = fopen(tmp, "wb");
+    if (!f) return -1;
+
+    TTFileHeader h;
+    tt_file_header(&h, 0);
+    bool ok = fwrite(&h, sizeof(h), 1, f) == 1;
+
+    uint32_t count = 0;
+    for (uint32_t i=0; ok && i<TT_SIZE; i++) {
+        TTEntry e = TT[i];
+        if (e.flag == TT_EMPTY || e.depth < minDepth) continue;
+
+        uint64_t key = e.key ^ tt_payload(&e);
+        uint16_t move = (uint16_t)((e.best.r1 & 0xF) | (e.best.c1 & 0xF) << 4 |
+                                   (e.best.r2 & 0xF) << 8 | (e.best.c2 & 0xF) << 12);
+        uint8_t rec[TT_FILE_RECORD_SIZE];
+        memcpy(rec, &key, 8);
+        memcpy(rec + 8, &e.value, 2);
+        rec[10] = (uint8_t)e.depth;
+        rec[11] = e.flag;
+        memcpy(rec + 12, &move, 2);
+        ok = fwrite(rec, sizeof(rec), 1, f) == 1;
+        count++;
     }
+
+    // Un disque plein se signale au plus tard à fflush : le fichier
+    // temporaire n'est renommé que si tout a été écrit.
+    h.count = count;
+    ok = ok && fseek(f, 0, SEEK_SET) == 0 && fwrite(&h, sizeof(h), 1, f) == 1 && fflush(f) == 0;
+    ok = (fclose(f) == 0) && ok;
+    if (!ok || rename(tmp, path) != 0) {
+        remove(tmp);
+        return -1;
+    }
+    return (int)count;
+}
+
+/**
+ * @brief Décode une coordonnée de coup stockée sur 4 bits (15 = -1).
+ * @param v La valeur sur 4 bits.
+ * @return La coordonnée.
+ */
+static inline int tt_file_coord(unsigned v) {
+    return v == 0xF ? -1 : (int)v;
+}
+
+/**
+ * @brief Vérifie un enregistrement de fichier de TT avant de l'utiliser.
+ * @param rec L'enregistrement (TT_FILE_RECORD_SIZE octets).
+ * @return true si son drapeau est une borne et son coup plausible.
+ */
+static bool tt_file_record_valid(const uint8_t *rec) {
+    if (rec[11] != TT_EXACT && rec[11] != TT_LOWER && rec[11] != TT_UPPER) return false;
+    uint16_t move;
+    memcpy(&move, rec + 12, 2);
+    for (int k=0; k<4; k++) {
+        unsigned v = (move >> (4 * k)) & 0xF;
+        if (v >= SIZE && v != 0xF) return false;
+    }
+    return true;
+}
+
+/**
+ * @see ia.h
+ */
+int ia_tt_load(const char *path) {
+    ia_init_once();
+    if (!path) return -1;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return -1;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(TTFileHeader)) {
+        close(fd);
+        return -1;
+    }
+    const uint8_t *data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) return -1;
+
+    TTFileHeader expected, h;
+    memcpy(&h, data, sizeof(h));
+    tt_file_header(&expected, h.count);
+    if (memcmp(&h, &expected, sizeof(h)) != 0 ||
+        (size_t)st.st_size != sizeof(h) + (size_t)h.count * TT_FILE_RECORD_SIZE) {
+        munmap((void *)data, (size_t)st.st_size);
+        return -1;
+    }
+
+    // Le fichier entier est vérifié avant d'en fusionner la moindre entrée.
+    const uint8_t *rec = data + sizeof(h);
+    for (uint32_t i=0; i<h.count; i++, rec += TT_FILE_RECORD_SIZE) {
+        if (!tt_file_record_valid(rec)) {
+            munmap((void *)data, (size_t)st.st_size);
+            return -1;
+        }
+    }
+
+    rec = data + sizeof(h);
+    for (uint32_t i=0; i<h.count; i++, rec += TT_FILE_RECORD_SIZE) {
+        uint64_t key; int16_t value; uint16_t move;
+        memcpy(&key, rec, 8);
+        memcpy(&value, rec + 8, 2);
+        memcpy(&move, rec + 12, 2);
+        Move best = { tt_file_coord(move & 0xF), tt_file_coord((move >> 4) & 0xF),
+                      tt_file_coord((move >> 8) & 0xF), tt_file_coord((move >> 12) & 0xF) };
+        tt_store(key, (int8_t)rec[10], value, (TTFlag)rec[11], best);
+    }
+
+    munmap((void *)data, (size_t)st.st_size);
+    return (int)h.count;
+}
+
+/**
+ * @see ia.h
+ */
+void ia_tt_clear(void) {
+    if (TT) memset(TT, 0, TT_SIZE * sizeof(TTEntry));
+}
+
+// Static exchange evaluation
+
+/**
+ * @brief Valeur matérielle d'une pièce pour l'évaluation des échanges.
+ *
+ * Indexée par le code de la pièce (mêmes poids que `evaluate`).
+ */
+static const int SEE_VALUE[5] = { 0, 12, 12, 300, 300 };
+
+/**
+ * @brief Calcule la valeur des pièces capturées par un coup, sans le jouer.
+ * @param b Le plateau avant le coup.
+ * @param from Indice de la case de départ.
+ * @param to Indice de la case d'arrivée.
+ * @param d Direction du coup.
+ * @return La somme des valeurs des pièces prises par poussée et par sandwich.
+ */
+static int capture_gain(const Board* b, int from, int to, int d) {
+    const int8_t *cells = &b->pion[0][0];
+    bool blueSide = is_blue(cells[from]);
+    int gain = 0, pushed = -1;
+
+    int v = geo_voisin[to][d], g = geo_voisin2[to][d];
+    if (v >= 0 && enemy(cells[v], blueSide) && (g < 0 || !enemy(cells[g], blueSide))) {
+        gain += SEE_VALUE[cells[v]];
+        pushed = v;
+    }
+
+    for (int dd=0; dd<NB_DIRECTIONS; dd++) {
+        int n = geo_voisin[to][dd], f = geo_voisin2[to][dd];
+        if (f < 0 || n == pushed || f == from) continue;
+        if (enemy(cells[n], blueSide) && ally(cells[f], blueSide)) gain += SEE_VALUE[cells[n]];
+    }
+    return gain;
+}
+
+/**
+ * @brief Évalue statiquement l'échange déclenché par un coup.
+ *
+ * Le gain du coup est diminué de la valeur de la reprise adverse de la pièce
+ * jouée (poussée ou sandwich sur sa case d'arrivée), elle-même évaluée de
+ * la même façon ; l'adversaire peut toujours renoncer à reprendre. Comme
+ * pour l'attaquant le moins précieux aux échecs, une seule reprise est
+ * suivie à chaque niveau : celle qui rapporte le plus, avec la pièce la
+ * moins précieuse à égalité. Le coût reste ainsi linéaire en `SEE_MAX_DEPTH`.
+ * @param b Le plateau avant le coup.
+ * @param from Indice de la case de départ.
+ * @param to Indice de la case d'arrivée.
+ * @param d Direction du coup.
+ * @param depth Nombre de reprises déjà examinées.
+ * @return Le bilan matériel de l'échange pour le camp qui joue.
+ */
+static int see_exchange(const Board* b, int from, int to, int d, int depth) {
+    int gain = capture_gain(b, from, to, d);
+    if (gain >= SEE_VALUE[ROI_BLEU] || depth >= SEE_MAX_DEPTH) return gain;
+
+    Board c = *b;
+    int8_t *cells = &c.pion[0][0];
+    cells[to] = cells[from];
+    cells[from] = EMPTY;
+    simulate_push_capture(&c, to, d);
+    simulate_sandwich(&c, to);
+
+    bool blueSide = is_blue(cells[to]);
+    int bestGain = 0, bestCost = 0, bestFrom = -1, bestTo = -1, bestDir = 0;
+    for (int d2=0; d2<NB_DIRECTIONS; d2++) {
+        int a = geo_voisin[to][d2];
+        if (a < 0 || cells[a] != EMPTY) continue;
+
+        // Case opposée à `a` : garde contre la poussée, ou seconde mâchoire du sandwich.
+        int beyond = geo_voisin[to][d2 ^ 1];
+        bool guarded  = beyond >= 0 && ally(cells[beyond], blueSide);
+        bool sandwich = beyond >= 0 && enemy(cells[beyond], blueSide);
+
+        for (int e=0; e<NB_DIRECTIONS; e++) {
+            if (!sandwich && (e != d2 || guarded)) continue;
+
+            // Première pièce sur le rayon : si elle est adverse, elle glisse jusqu'à `a`.
+            const Rayons *ray = &geo_rayons[a];
+            int s = -1;
+            for (int k=0; k<ray->longueur[e] && s < 0; k++)
+                if (cells[ray->cases[e][k]] != EMPTY) s = ray->cases[e][k];
+            if (s < 0 || !enemy(cells[s], blueSide)) continue;
+
+            int g = capture_gain(&c, s, a, e ^ 1);
+            int cost = SEE_VALUE[cells[s]];
+            if (g > bestGain || (g == bestGain && cost < bestCost)) {
+                bestGain = g; bestCost = cost;
+                bestFrom = s; bestTo = a; bestDir = e ^ 1;
+            }
+        }
+    }
+    if (bestFrom < 0) return gain;
+
+    int reply = see_exchange(&c, bestFrom, bestTo, bestDir, depth + 1);
+    return gain - (reply > 0 ? reply : 0);
+}
+
+/**
+ * @brief Génère les captures dont l'évaluation des échanges est positive.
+ *
+ * Une capture suppose une pièce adverse voisine de la case d'arrivée : on
+ * part donc des cases vides au contact de l'adversaire et on cherche, sur
+ * chacun de leurs rayons, une pièce alliée capable d'y glisser.
+ * @param b Le plateau.
+ * @param blueSide true pour les coups des bleus.
+ * @param[out] out Les captures, triées par bilan décroissant.
+ * @param[out] scores Le bilan de chaque capture.
+ * @return Le nombre de captures générées.
+ */
+static int generate_winning_captures(const Board* b, bool blueSide, Move out[], int scores[]) {
+    const int8_t *cells = &b->pion[0][0];
+    bool seen[NB_CASES] = { false };
+    int n = 0;
+
+    for (int sq=0; sq<NB_CASES; sq++) {
+        if (!enemy(cells[sq], blueSide)) continue;
+        for (int d=0; d<NB_DIRECTIONS; d++) {
+            int a = geo_voisin[sq][d];
+            if (a < 0 || seen[a] || cells[a] != EMPTY) continue;
+            seen[a] = true;
+
+            for (int e=0; e<NB_DIRECTIONS; e++) {
+                const Rayons *ray = &geo_rayons[a];
+                int from = -1;
+                for (int k=0; k<ray->longueur[e] && from < 0; k++)
+                    if (cells[ray->cases[e][k]] != EMPTY) from = ray->cases[e][k];
+                if (from < 0 || !ally(cells[from], blueSide) || capture_gain(b, from, a, e ^ 1) == 0) continue;
+
+                int see = see_exchange(b, from, a, e ^ 1, 0);
+                if (see <= 0) continue;
+
+                // Tri par insertion sur le bilan de l'échange.
+                int j = n++;
+                while (j > 0 && scores[j-1] < see) {
+                    out[j] = out[j-1];
+                    scores[j] = scores[j-1];
+                    j--;
+                }
+                out[j] = (Move){ CASE_LIGNE(from), CASE_COL(from), CASE_LIGNE(a), CASE_COL(a) };
+                scores[j] = see;
+            }
+        }
+    }
+    return n;
 }
 
 // Move ordering  
@@ -386,21 +1180,28 @@ static inline void tt_store(uint64_t key, int depth, int value, TTFlag flag, Mov
  * @param blueToPlay true si c'est au tour des bleus.
  * @param m Le coup à évaluer.
  * @param ttMove Le meilleur coup suggéré par la table de transposition (peut être NULL).
+ * @param killers Les deux coups « killer » du niveau (peut être NULL).
  * @return Un score entier pour le coup.
  */
-static int move_score(const Board* b, bool blueToPlay, const Move* m, const Move* ttMove) {
+static int move_score(const Board* b, bool blueToPlay, const Move* m, const Move* ttMove, const Move* killers) {
     int score = 0;
 
-    if (ttMove && m->r1==ttMove->r1 && m->c1==ttMove->c1 && m->r2==ttMove->r2 && m->c2==ttMove->c2) {
+    if (ttMove && same_move(m, ttMove)) {
         score += 100000;
+    } else if (killers && (same_move(m, &killers[0]) || same_move(m, &killers[1]))) {
+        score += 4000;
     }
 
     int p = b->pion[m->r1][m->c1];
 
-    int dr,dc; unit_dir(m->r1,m->c1,m->r2,m->c2,&dr,&dc);
-    int vr = m->r2 + dr, vc = m->c2 + dc;
-    if (in_bounds(vr,vc) && enemy(b->pion[vr][vc], is_blue(p))) {
-        score += 5000;
+    // Contact dans le sens du coup (poussée possible ou menace), puis
+    // bilan des échanges pour les seuls coups qui capturent.
+    int from = CASE_IDX(m->r1, m->c1), to = CASE_IDX(m->r2, m->c2), d = move_direction(m);
+    int v = geo_voisin[to][d];
+    if (v >= 0 && enemy((&b->pion[0][0])[v], is_blue(p))) score += 5000;
+    if (capture_gain(b, from, to, d) > 0) {
+        int see = see_exchange(b, from, to, d, 0);
+        score += see > 0 ? 6000 + see : see * 10;
     }
 
     if (p == ROI_BLEU) {
@@ -423,116 +1224,1042 @@ static int move_score(const Board* b, bool blueToPlay, const Move* m, const Move
  * @param b Le plateau.
  * @param blueToPlay true si c'est au tour des bleus.
  * @param moves Le tableau de coups à trier.
+ * @param scores Tampon d'au moins `n` scores, calculés une fois par coup.
  * @param n Le nombre de coups dans le tableau.
  * @param ttMove Le meilleur coup suggéré par la table de transposition.
+ * @param killers Les coups « killer » du niveau (peut être NULL).
  */
-static void sort_moves(Board* b, bool blueToPlay, Move* moves, int n, const Move* ttMove) {
+static void sort_moves(Board* b, bool blueToPlay, Move* moves, int* scores, int n, const Move* ttMove, const Move* killers) {
+    for (int i=0;i<n;i++) scores[i] = move_score(b, blueToPlay, &moves[i], ttMove, killers);
     for (int i=1;i<n;i++) {
         Move key = moves[i];
-        int keyScore = move_score(b, blueToPlay, &key, ttMove);
+        int keyScore = scores[i];
         int j = i-1;
-        while (j>=0) {
-            int s = move_score(b, blueToPlay, &moves[j], ttMove);
-            if (s >= keyScore) break;
+        while (j>=0 && scores[j] < keyScore) {
             moves[j+1] = moves[j];
+            scores[j+1] = scores[j];
             j--;
         }
         moves[j+1] = key;
+        scores[j+1] = keyScore;
     }
 }
 
+// Recherche parallèle (Young Brothers Wait)
+
+/**
+ * @struct SplitPoint
+ * @brief Nœud dont les frères cadets sont partagés entre les threads de recherche.
+ *
+ * Il est créé sur la pile du thread propriétaire une fois le fils aîné
+ * recherché, et reste valide tant que `pending` n'est pas revenu à 0.
+ */
+typedef struct SplitPoint {
+    struct SplitPoint *parent; /**< Point de partage englobant (annulation en cascade). */
+    pthread_mutex_t lock;      /**< Protège les bornes et le meilleur coup. */
+    Board board;               /**< Position du nœud partagé. */
+    const PositionHistory *hist; /**< Historique du propriétaire (stable jusqu'à `histCount`). */
+    int histCount;             /**< Nombre de positions menant au nœud, nœud compris. */
+    const Move *moves;         /**< Coups triés du nœud (pile de recherche du propriétaire). */
+    int *vals;                 /**< Valeur de chaque coup (mode déterministe). */
+    int depth;                 /**< Profondeur restante au nœud. */
+    int ply;                   /**< Distance du nœud à la racine. */
+    bool blueToPlay;           /**< Camp au trait au nœud. */
+    int alpha, beta;           /**< Fenêtre courante, resserrée par les fils terminés. */
+    int bestVal;               /**< Meilleure valeur trouvée. */
+    int bestIdx;               /**< Indice du meilleur coup trouvé. */
+    atomic_bool stop;          /**< Levé lors d'une coupure : les fils en cours abandonnent. */
+    atomic_int pending;        /**< Nombre de tâches pas encore terminées. */
+} SplitPoint;
+
+/**
+ * @struct YbwTask
+ * @brief Tâche volable : recherche d'un frère cadet d'un point de partage.
+ */
+typedef struct {
+    SplitPoint *sp; /**< Point de partage d'origine. */
+    int idx;        /**< Indice du coup dans `sp->moves`. */
+} YbwTask;
+
+/**
+ * @struct TaskDeque
+ * @brief File double par thread : le propriétaire dépile en queue, les voleurs en tête.
+ */
+typedef struct {
+    pthread_mutex_t lock;            /**< Protège la file. */
+    int head, tail;                  /**< Bornes des tâches présentes [head, tail). */
+    YbwTask tasks[YBW_DEQUE_SIZE];   /**< Tâches en attente. */
+} TaskDeque;
+
+/**
+ * @struct SearchFrame
+ * @brief Données d'un niveau de la recherche, préallouées dans la pile du thread.
+ *
+ * Le niveau `ply` d'un thread n'est utilisé que par le nœud à cette distance
+ * de la racine : un thread qui aide un point de partage n'en traite que des
+ * descendants, donc des niveaux plus profonds que ceux qu'il occupe déjà.
+ */
+typedef struct {
+    Move moves[MAX_MOVES];      /**< Coups générés au nœud. */
+    int scores[MAX_MOVES];      /**< Scores d'ordonnancement des coups. */
+    int vals[MAX_MOVES];        /**< Valeurs des cadets d'un point de partage (mode déterministe). */
+    Board undo;                 /**< Position avant le coup en cours, restaurée après la recherche du fils. */
+    Move killers[2];            /**< Derniers coups sans capture ayant provoqué une coupure à ce niveau. */
+    uint64_t childKeys[MAX_MOVES]; /**< Clés des positions filles (solveur de finale). */
+    PositionHistory stolenHist; /**< Copie de l'historique d'un point de partage pour une tâche volée. */
+} __attribute__((aligned(64))) SearchFrame;
+
+/**
+ * @struct SearchThread
+ * @brief Contexte propre à chaque thread de recherche.
+ */
+typedef struct {
+    int id;                  /**< Indice du thread (0 = thread appelant). */
+    pthread_t tid;           /**< Identifiant système (threads auxiliaires). */
+    uint64_t nodes;          /**< Nœuds visités par ce thread. */
+    uint64_t steals;         /**< Tâches volées par ce thread. */
+    uint64_t splits;         /**< Points de partage créés par ce thread. */
+    uint64_t evalProbes;     /**< Évaluations statiques demandées par ce thread. */
+    uint64_t evalHits;       /**< Évaluations servies par le cache. */
+    SplitPoint *current_sp;  /**< Point de partage de la tâche en cours. */
+    PositionHistory *hist;   /**< Positions de la partie et du chemin de recherche courant. */
+    const PVLine *excluded;  /**< Coups racine déjà attribués à une ligne (multi-PV). */
+    int nExcluded;           /**< Nombre de coups racine exclus. */
+    TaskDeque deque;         /**< Tâches offertes aux autres threads. */
+    SearchFrame *stack;      /**< Pile de recherche de MAX_PLY niveaux, alignée sur 64 octets. */
+} SearchThread;
+
+/**
+ * @brief État global du groupe de threads de recherche.
+ */
+static struct {
+    pthread_mutex_t lock;     /**< Protège le réveil des threads auxiliaires. */
+    pthread_cond_t cv;        /**< Réveille les auxiliaires au début d'une recherche. */
+    int nthreads;             /**< Nombre de threads actifs (appelant compris). */
+    bool quit;                /**< Demande d'arrêt des auxiliaires. */
+    atomic_bool searching;    /**< true pendant un appel à `search_best_move`. */
+    bool deterministic;       /**< Mode de mesure à nombre de nœuds reproductible. */
+    SearchThread threads[YBW_MAX_THREADS]; /**< Contextes de recherche. */
+} pool = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .cv = PTHREAD_COND_INITIALIZER,
+    .nthreads = 1,
+};
+
+static SearchStats g_last_stats; /**< Statistiques de la dernière recherche. */
+static atomic_bool g_stop_requested; /**< Demande d'arrêt de la recherche en cours. */
+static atomic_bool g_time_up;        /**< Limite dure du coup atteinte. */
+static _Atomic int64_t g_deadline_ms = INT64_MAX; /**< Échéance de la limite dure (INT64_MAX : aucune). */
+static MoveBudget g_budget;          /**< Budget de temps des recherches. */
+static bool g_budget_active = false; /**< true si `g_budget` s'applique. */
+#ifdef IA_TESTS
+static int g_test_stop_depth = 0;    /**< Itération multi-PV interrompue par les tests (0 : aucune). */
+static int g_test_stop_lines = 0;    /**< Lignes terminées de cette itération avant l'arrêt. */
+#endif
+
+static int minimax(Board* b, int depth, int ply, int alpha, int beta, bool blueToPlay, uint64_t key, Move* outBest, SearchThread *th);
+
+/**
+ * @brief Indique si la table de transposition est utilisée par la recherche.
+ *
+ * Elle est désactivée en mode déterministe, son contenu dépendant de l'ordre
+ * d'exécution des threads.
+ * @return true si la TT peut être lue et écrite.
+ */
+static inline bool tt_enabled(void) {
+    return !pool.deterministic;
+}
+
+/**
+ * @brief Indique si les coups « killer » participent à l'ordonnancement.
+ *
+ * Propres à chaque thread, ils dépendent des tâches qu'il a traitées : ils
+ * sont eux aussi désactivés en mode déterministe.
+ * @return true si les killers sont lus et mis à jour.
+ */
+static inline bool killers_enabled(void) {
+    return !pool.deterministic;
+}
+
+/**
+ * @brief Lit l'horloge monotone.
+ * @return Le temps écoulé depuis une origine arbitraire, en millisecondes.
+ */
+static int64_t now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/**
+ * @brief Lève `g_time_up` si l'échéance de la limite dure est passée.
+ *
+ * Appelée tous les TIME_CHECK_NODES nœuds par chaque thread ; sans échéance
+ * armée, l'horloge n'est pas lue.
+ */
+static inline void time_check(void) {
+    int64_t deadline = atomic_load_explicit(&g_deadline_ms, memory_order_relaxed);
+    if (deadline != INT64_MAX && now_ms() >= deadline)
+        atomic_store_explicit(&g_time_up, true, memory_order_relaxed);
+}
+
+/**
+ * @brief Indique si la recherche itérative a été interrompue (arrêt demandé ou temps écoulé).
+ */
+static inline bool search_interrupted(void) {
+    return atomic_load(&g_stop_requested) || atomic_load(&g_time_up);
+}
+
+/**
+ * @brief Vérifie si la branche en cours doit être abandonnée.
+ * @param th Le thread de recherche.
+ * @return true si la recherche est arrêtée ou si un point de partage englobant a subi une coupure.
+ */
+static inline bool search_aborted(const SearchThread *th) {
+    if (atomic_load_explicit(&g_stop_requested, memory_order_relaxed)) return true;
+    if (atomic_load_explicit(&g_time_up, memory_order_relaxed)) return true;
+    for (SplitPoint *sp = th->current_sp; sp; sp = sp->parent)
+        if (atomic_load_explicit(&sp->stop, memory_order_relaxed)) return true;
+    return false;
+}
+
+/**
+ * @brief Vérifie si `sp` descend (au sens des points de partage) de `ancestor`.
+ * @param sp Le point de partage à tester.
+ * @param ancestor L'ancêtre recherché.
+ * @return true si `ancestor` apparaît dans la chaîne de `sp`.
+ */
+static bool sp_descends_from(const SplitPoint *sp, const SplitPoint *ancestor) {
+    for (; sp; sp = sp->parent)
+        if (sp == ancestor) return true;
+    return false;
+}
+
+/**
+ * @brief Vole une tâche en tête de la file d'un autre thread.
+ * @param th Le thread voleur.
+ * @param ancestor Si non NULL, seules les tâches issues de ce point de partage sont acceptées.
+ * @param[out] out La tâche volée.
+ * @return true si une tâche a été volée.
+ */
+static bool ybw_steal(SearchThread *th, const SplitPoint *ancestor, YbwTask *out) {
+    for (int k=1; k<pool.nthreads; k++) {
+        TaskDeque *dq = &pool.threads[(th->id + k) % pool.nthreads].deque;
+        if (dq->head == dq->tail) continue;
+        pthread_mutex_lock(&dq->lock);
+        bool ok = dq->head < dq->tail &&
+                  (!ancestor || sp_descends_from(dq->tasks[dq->head].sp, ancestor));
+        if (ok) *out = dq->tasks[dq->head++];
+        pthread_mutex_unlock(&dq->lock);
+        if (ok) { th->steals++; return true; }
+    }
+    return false;
+}
+
+/**
+ * @brief Dépile en queue de sa propre file une tâche du point de partage donné.
+ * @param th Le thread propriétaire.
+ * @param sp Le point de partage attendu.
+ * @param[out] out La tâche dépilée.
+ * @return true si une tâche de `sp` a été dépilée.
+ */
+static bool ybw_pop_own(SearchThread *th, const SplitPoint *sp, YbwTask *out) {
+    TaskDeque *dq = &th->deque;
+    pthread_mutex_lock(&dq->lock);
+    bool ok = dq->head < dq->tail && dq->tasks[dq->tail-1].sp == sp;
+    if (ok) *out = dq->tasks[--dq->tail];
+    if (dq->head == dq->tail) dq->head = dq->tail = 0;
+    pthread_mutex_unlock(&dq->lock);
+    return ok;
+}
+
+/**
+ * @brief Recherche un frère cadet et remonte son résultat au point de partage.
+ * @param th Le thread qui exécute la tâche.
+ * @param t La tâche à exécuter.
+ */
+static void ybw_run_task(SearchThread *th, YbwTask t) {
+    SplitPoint *sp = t.sp;
+    SplitPoint *prev = th->current_sp;
+    th->current_sp = sp;
+
+    if (!search_aborted(th)) {
+        Board b = sp->board;
+        int captured = apply_move(&b, &sp->moves[t.idx]);
+        uint64_t childKey = zobrist_hash(&b, !sp->blueToPlay);
+
+        // Le propriétaire prolonge son propre historique ; un voleur repart d'une copie.
+        PositionHistory *savedHist = th->hist;
+        if (th->hist != sp->hist || th->hist->count != sp->histCount) {
+            PositionHistory *local = &th->stack[sp->ply + 1].stolenHist;
+            history_copy(local, sp->hist, sp->histCount);
+            th->hist = local;
+        }
+        history_push(th->hist, childKey, captured > 0);
+
+        pthread_mutex_lock(&sp->lock);
+        int alpha = sp->alpha, beta = sp->beta;
+        pthread_mutex_unlock(&sp->lock);
+
+        int val = minimax(&b, sp->depth-1, sp->ply+1, alpha, beta, !sp->blueToPlay, childKey, NULL, th);
+        history_pop(th->hist);
+        th->hist = savedHist;
+
+        if (!search_aborted(th)) {
+            if (pool.deterministic) {
+                sp->vals[t.idx] = val;
+            } else {
+                pthread_mutex_lock(&sp->lock);
+                bool better = sp->blueToPlay ? val > sp->bestVal : val < sp->bestVal;
+                if (better || (val == sp->bestVal && t.idx < sp->bestIdx)) {
+                    sp->bestVal = val;
+                    sp->bestIdx = t.idx;
+                }
+                if (sp->blueToPlay && sp->bestVal > sp->alpha) sp->alpha = sp->bestVal;
+                if (!sp->blueToPlay && sp->bestVal < sp->beta) sp->beta = sp->bestVal;
+                if (sp->alpha >= sp->beta) atomic_store(&sp->stop, true);
+                pthread_mutex_unlock(&sp->lock);
+            }
+        }
+    }
+
+    th->current_sp = prev;
+    atomic_fetch_sub(&sp->pending, 1);
+}
+
+/**
+ * @brief Indique si un nœud peut partager ses frères cadets.
+ * @param th Le thread propriétaire du nœud.
+ * @param depth Profondeur restante au nœud.
+ * @param remaining Nombre de frères cadets à partager.
+ * @return true si le partage est possible.
+ */
+static bool ybw_can_split(const SearchThread *th, int depth, int remaining) {
+    return pool.nthreads > 1 && depth >= YBW_MIN_SPLIT_DEPTH && remaining > 0 &&
+           th->deque.tail + remaining <= YBW_DEQUE_SIZE;
+}
+
+/**
+ * @brief Partage les frères cadets d'un nœud et attend leur résultat.
+ *
+ * Le fils aîné (`moves[0]`) a déjà été recherché. Les coups 1..n-1 deviennent
+ * des tâches volables ; le propriétaire en traite lui-même le plus possible,
+ * puis aide les threads qui travaillent sous ce nœud jusqu'à la dernière tâche.
+ * @param th Le thread propriétaire.
+ * @param b La position du nœud.
+ * @param depth Profondeur restante au nœud.
+ * @param ply Distance du nœud à la racine.
+ * @param[in,out] alpha Borne alpha du nœud.
+ * @param[in,out] beta Borne bêta du nœud.
+ * @param blueToPlay Camp au trait.
+ * @param moves Les coups triés du nœud.
+ * @param n Le nombre de coups.
+ * @param[in,out] bestVal Meilleure valeur (celle du fils aîné en entrée).
+ * @param[in,out] bestIdx Indice du meilleur coup.
+ */
+static void ybw_split(SearchThread *th, const Board *b, int depth, int ply, int *alpha, int *beta,
+                      bool blueToPlay, const Move *moves, int n, int *bestVal, int *bestIdx) {
+    int *vals = th->stack[ply].vals;
+    SplitPoint sp = {
+        .parent = th->current_sp, .board = *b, .moves = moves, .vals = vals,
+        .hist = th->hist, .histCount = th->hist->count,
+        .depth = depth, .ply = ply, .blueToPlay = blueToPlay, .alpha = *alpha, .beta = *beta,
+        .bestVal = *bestVal, .bestIdx = *bestIdx,
+    };
+    pthread_mutex_init(&sp.lock, NULL);
+    atomic_init(&sp.stop, false);
+    atomic_init(&sp.pending, n-1);
+    th->splits++;
+
+    // Les cadets sont empilés du dernier au premier : le mieux classé sort en premier.
+    TaskDeque *dq = &th->deque;
+    pthread_mutex_lock(&dq->lock);
+    for (int i=n-1; i>=1; i--) dq->tasks[dq->tail++] = (YbwTask){ &sp, i };
+    pthread_mutex_unlock(&dq->lock);
+
+    YbwTask t;
+    while (ybw_pop_own(th, &sp, &t)) ybw_run_task(th, t);
+    while (atomic_load(&sp.pending) > 0) {
+        if (ybw_steal(th, &sp, &t)) ybw_run_task(th, t);
+        else sched_yield();
+    }
+
+    if (pool.deterministic) {
+        // Réduction dans l'ordre des coups : même résultat quel que soit l'ordonnancement.
+        for (int i=1; i<n; i++) {
+            if (blueToPlay) {
+                if (vals[i] > sp.bestVal) { sp.bestVal = vals[i]; sp.bestIdx = i; }
+                if (sp.bestVal > sp.alpha) sp.alpha = sp.bestVal;
+            } else {
+                if (vals[i] < sp.bestVal) { sp.bestVal = vals[i]; sp.bestIdx = i; }
+                if (sp.bestVal < sp.beta) sp.beta = sp.bestVal;
+            }
+            if (sp.alpha >= sp.beta) break;
+        }
+    }
+
+    pthread_mutex_destroy(&sp.lock);
+    *alpha = sp.alpha;
+    *beta = sp.beta;
+    *bestVal = sp.bestVal;
+    *bestIdx = sp.bestIdx;
+}
+
+/**
+ * @brief Boucle des threads auxiliaires : volent des tâches tant qu'une recherche est en cours.
+ * @param arg Le contexte `SearchThread` du thread.
+ * @return NULL.
+ */
+static void *ybw_helper_main(void *arg) {
+    SearchThread *th = (SearchThread *)arg;
+    pthread_mutex_lock(&pool.lock);
+    while (!pool.quit) {
+        if (!atomic_load(&pool.searching)) {
+            pthread_cond_wait(&pool.cv, &pool.lock);
+            continue;
+        }
+        pthread_mutex_unlock(&pool.lock);
+
+        YbwTask t;
+        while (atomic_load(&pool.searching)) {
+            if (ybw_steal(th, NULL, &t)) ybw_run_task(th, t);
+            else sched_yield();
+        }
+        pthread_mutex_lock(&pool.lock);
+    }
+    pthread_mutex_unlock(&pool.lock);
+    return NULL;
+}
+
+/**
+ * @brief Retire de la liste les coups déjà attribués à une ligne multi-PV.
+ * @param moves Les coups générés (modifiés sur place).
+ * @param n Le nombre de coups.
+ * @param excluded Les lignes déjà trouvées.
+ * @param nExcluded Le nombre de lignes déjà trouvées.
+ * @return Le nombre de coups restants.
+ */
+static int exclude_root_moves(Move* moves, int n, const PVLine* excluded, int nExcluded) {
+    int kept = 0;
+    for (int i=0; i<n; i++) {
+        bool skip = false;
+        for (int k=0; k<nExcluded && !skip; k++) skip = same_move(&moves[i], &excluded[k].move);
+        if (!skip) moves[kept++] = moves[i];
+    }
+    return kept;
+}
+
+/**
+ * @brief Valeur d'une position répétée selon la politique configurée.
+ * @param b La position répétée.
+ * @return Le score attribué (positif pour avantage bleu).
+ */
+static int repetition_score(const Board *b) {
+    switch (g_rep_policy) {
+        case REP_SCORE_CONTEMPT: return g_root_blue ? -g_rep_contempt : g_rep_contempt;
+        case REP_SCORE_EVAL:     return evaluate(b);
+        case REP_SCORE_DRAW:
+        default:                 return 0;
+    }
+}
+
+// Cache d'évaluation
+
+#define EVAL_CACHE_SIZE (1u << EVAL_CACHE_POW2)
+#define EVAL_CACHE_MASK (EVAL_CACHE_SIZE - 1u)
+
+/**
+ * @brief Cache des évaluations statiques, partagé sans verrou par les threads.
+ *
+ * Chaque entrée tient dans un mot de 64 bits lu et écrit atomiquement : les
+ * 48 bits de poids fort de la clé, puis le score sur 16 bits. Une écriture
+ * concurrente remplace simplement l'entrée ; le cache est « avec pertes ».
+ */
+static _Atomic uint64_t *g_eval_cache = NULL;
+
+/**
+ * @brief Évalue une position en passant par le cache d'évaluation.
+ *
+ * `evaluate` ne dépend pas du camp au trait : le trait est retiré de la clé
+ * pour partager l'entrée entre les deux camps.
+ * @param b Le plateau.
+ * @param key Clé de Zobrist de la position.
+ * @param blueToPlay true si c'est au tour des bleus.
+ * @param th Le thread de recherche (statistiques).
+ * @return L'évaluation statique de la position.
+ */
+static int cached_evaluate(const Board* b, uint64_t key, bool blueToPlay, SearchThread *th) {
+    th->evalProbes++;
+    if (!g_eval_cache) return evaluate(b);
+    if (blueToPlay) key ^= Z_SIDE;
+
+    _Atomic uint64_t *slot = &g_eval_cache[key & EVAL_CACHE_MASK];
+    uint64_t e = atomic_load_explicit(slot, memory_order_relaxed);
+    if ((e & ~0xFFFFull) == (key & ~0xFFFFull)) {
+        th->evalHits++;
+        return (int16_t)(uint16_t)e;
+    }
+
+    int score = evaluate(b);
+    if (score >= INT16_MIN && score <= INT16_MAX)
+        atomic_store_explicit(slot, (key & ~0xFFFFull) | (uint16_t)score, memory_order_relaxed);
+    return score;
+}
+
 // Minimax Alpha-Beta
 
+/**
+ * @brief Prolonge la recherche sur les seules captures gagnantes.
+ *
+ * Appelée aux feuilles de Minimax (position non terminale) pour ne pas
+ * évaluer une position au milieu d'un échange. Le camp au trait peut s'en tenir à l'évaluation
+ * statique ; les captures dont l'évaluation des échanges est négative sont
+ * écartées sans être jouées.
+ * @param b Le plateau (restauré au retour).
+ * @param ply Distance à la racine.
+ * @param alpha Borne inférieure.
+ * @param beta Borne supérieure.
+ * @param blueToPlay true si c'est au tour des bleus.
+ * @param key Clé de Zobrist de la position.
+ * @param th Le thread de recherche.
+ * @return La valeur de la position.
+ */
+static int quiesce(Board* b, int ply, int alpha, int beta, bool blueToPlay, uint64_t key, SearchThread *th) {
+    if (king_wins_next(b, blueToPlay)) return blueToPlay ? 100000 : -100000;
+
+    int standPat = cached_evaluate(b, key, blueToPlay, th);
+    if (ply >= MAX_PLY-1) return standPat;
+    if (blueToPlay) {
+        if (standPat >= beta) return standPat;
+        if (standPat > alpha) alpha = standPat;
+    } else {
+        if (standPat <= alpha) return standPat;
+        if (standPat < beta) beta = standPat;
+    }
+
+    SearchFrame *f = &th->stack[ply];
+    Move *moves = f->moves;
+    int nCaptures = generate_winning_captures(b, blueToPlay, moves, f->scores);
+
+    int best = standPat;
+    for (int i=0; i<nCaptures; i++) {
+        if ((++th->nodes & (TIME_CHECK_NODES-1)) == 0) time_check();
+        f->undo = *b;
+        apply_move(b, &moves[i]);
+        int winner = check_winner(b);
+        int val = winner ? winner * 100000
+                         : quiesce(b, ply+1, alpha, beta, !blueToPlay, zobrist_after_move(key, &f->undo, b, &moves[i]), th);
+        *b = f->undo;
+        if (search_aborted(th)) return 0;
+
+        if (blueToPlay) {
+            if (val > best) best = val;
+            if (best > alpha) alpha = best;
+        } else {
+            if (val < best) best = val;
+            if (best < beta) beta = best;
+        }
+        if (alpha >= beta) break;
+    }
+    return best;
+}
+
 /**
  * @brief Fonction récursive de recherche Minimax avec élagage Alpha-Bêta.
  * @param b Pointeur vers le plateau (sera modifié et restauré).
  * @param depth Profondeur de recherche restante.
+ * @param ply Distance à la racine : indice du niveau utilisé dans la pile du thread.
  * @param alpha La meilleure valeur garantie pour le joueur maximisant (bleu).
  * @param beta La meilleure valeur garantie pour le joueur minimisant (rouge).
  * @param blueToPlay true si le joueur actuel est bleu.
  * @param key La clé de Zobrist de la position actuelle.
  * @param[out] outBest Pointeur pour stocker le meilleur coup trouvé.
- * @return L'évaluation de la position.
+ * @param th Le thread de recherche qui exécute ce nœud.
+ * @return L'évaluation de la position (sans signification si la branche est abandonnée).
  */
-static int minimax(Board* b, int depth, int alpha, int beta, bool blueToPlay, uint64_t key, Move* outBest) {
+static int minimax(Board* b, int depth, int ply, int alpha, int beta, bool blueToPlay, uint64_t key, Move* outBest, SearchThread *th) {
+    if ((++th->nodes & (TIME_CHECK_NODES-1)) == 0) time_check();
     int winner = check_winner(b);
     if (winner == +1) return  100000;
     if (winner == -1) return -100000;
-    if (depth == 0)   return evaluate(b);
+    if (!outBest && history_is_repetition(th->hist)) return repetition_score(b);
+    if (!outBest && king_wins_next(b, blueToPlay)) return blueToPlay ? 100000 : -100000;
+    if (ply >= MAX_PLY-1) return cached_evaluate(b, key, blueToPlay, th);
+    if (depth == 0) return quiesce(b, ply, alpha, beta, blueToPlay, key, th);
 
-    TTEntry *e = tt_probe(key);
+    int alphaOrig = alpha, betaOrig = beta;
+    TTEntry e;
     Move ttMove = { -1,-1,-1,-1 };
-    if (e->key == key) {
-        if (e->depth >= depth) {
-            if (e->flag == TT_EXACT) return e->value;
-            if (e->flag == TT_LOWER && e->value > alpha) alpha = e->value;
-            else if (e->flag == TT_UPPER && e->value < beta) beta = e->value;
-            if (alpha >= beta) return e->value;
+    if (tt_enabled() && tt_probe(key, &e)) {
+        if (e.depth >= depth && !outBest) {
+            if (e.flag == TT_EXACT) return e.value;
+            if (e.flag == TT_LOWER && e.value > alpha) alpha = e.value;
+            else if (e.flag == TT_UPPER && e.value < beta) beta = e.value;
+            if (alpha >= beta) return e.value;
         }
-        ttMove = e->best;
+        ttMove = e.best;
     }
 
-    Move moves[MAX_MOVES];
+    SearchFrame *f = &th->stack[ply];
+    Move *moves = f->moves;
     int n = generate_moves(b, blueToPlay, moves, MAX_MOVES);
-    if (n == 0) return evaluate(b);
+    bool rootExcl = outBest && th->nExcluded > 0;
+    if (rootExcl) n = exclude_root_moves(moves, n, th->excluded, th->nExcluded);
+    if (n == 0) return cached_evaluate(b, key, blueToPlay, th);
 
-    sort_moves(b, blueToPlay, moves, n, &ttMove);
+    sort_moves(b, blueToPlay, moves, f->scores, n, &ttMove, killers_enabled() ? f->killers : NULL);
 
     int bestVal = blueToPlay ? -INF_SCORE : INF_SCORE;
-    Move bestMove = moves[0];
+    int bestIdx = 0;
 
     for (int i=0;i<n;i++) {
-        Board save = *b;
-        apply_move(b, &moves[i]);
+        if (i == 1 && ybw_can_split(th, depth, n-1)) {
+            ybw_split(th, b, depth, ply, &alpha, &beta, blueToPlay, moves, n, &bestVal, &bestIdx);
+            break;
+        }
+
+        f->undo = *b;
+        int captured = apply_move(b, &moves[i]);
 
         uint64_t childKey = zobrist_hash(b, !blueToPlay);
-        int val = minimax(b, depth-1, alpha, beta, !blueToPlay, childKey, outBest);
+        history_push(th->hist, childKey, captured > 0);
+        int val = minimax(b, depth-1, ply+1, alpha, beta, !blueToPlay, childKey, NULL, th);
+        history_pop(th->hist);
 
-        *b = save;
+        *b = f->undo;
+        if (search_aborted(th)) return 0;
 
         if (blueToPlay) {
-            if (val > bestVal) { bestVal = val; bestMove = moves[i]; }
+            if (val > bestVal) { bestVal = val; bestIdx = i; }
             if (bestVal > alpha) alpha = bestVal;
         } else {
-            if (val < bestVal) { bestVal = val; bestMove = moves[i]; }
+            if (val < bestVal) { bestVal = val; bestIdx = i; }
             if (bestVal < beta) beta = bestVal;
         }
-        if (alpha >= beta) break;
+        if (alpha >= beta) {
+            if (captured == 0 && killers_enabled() && !same_move(&moves[i], &f->killers[0])) {
+                f->killers[1] = f->killers[0];
+                f->killers[0] = moves[i];
+            }
+            break;
+        }
     }
+    if (search_aborted(th)) return 0;
 
     TTFlag flag;
-    if (bestVal <= alpha) flag = TT_UPPER;
-    else if (bestVal >= beta) flag = TT_LOWER;
+    if (bestVal <= alphaOrig) flag = TT_UPPER;
+    else if (bestVal >= betaOrig) flag = TT_LOWER;
     else flag = TT_EXACT;
 
-    tt_store(key, depth, bestVal, flag, bestMove);
-    if (outBest) *outBest = bestMove;
+    // À la racine, une recherche privée de ses meilleurs coups ne vaut pas pour la position.
+    if (tt_enabled() && !rootExcl) tt_store(key, depth, bestVal, flag, moves[bestIdx]);
+    if (outBest) *outBest = moves[bestIdx];
     return bestVal;
 }
 
 // Iterative Deepening 
 
 /**
- * @see ia.h
+ * @brief Prépare les threads pour une nouvelle recherche et réveille les auxiliaires.
  */
-Move search_best_move(const Board* start, bool blueToPlay) {
+static void search_begin(void) {
+    for (int i=0; i<pool.nthreads; i++) {
+        SearchThread *th = &pool.threads[i];
+        th->nodes = th->steals = th->splits = 0;
+        th->evalProbes = th->evalHits = 0;
+        th->current_sp = NULL;
+        th->excluded = NULL;
+        th->nExcluded = 0;
+        for (int p=0; p<MAX_PLY; p++)
+            for (int k=0; k<2; k++) th->stack[p].killers[k] = (Move){ -1,-1,-1,-1 };
+    }
+
+    if (pool.nthreads > 1) {
+        pthread_mutex_lock(&pool.lock);
+        atomic_store(&pool.searching, true);
+        pthread_cond_broadcast(&pool.cv);
+        pthread_mutex_unlock(&pool.lock);
+    }
+}
+
+/**
+ * @brief Rendort les threads auxiliaires et agrège les statistiques de la recherche.
+ */
+static void search_end(void) {
+    atomic_store(&pool.searching, false);
+
+    memset(&g_last_stats, 0, sizeof(g_last_stats));
+    g_last_stats.threads = pool.nthreads;
+    for (int i=0; i<pool.nthreads; i++) {
+        g_last_stats.nodes  += pool.threads[i].nodes;
+        g_last_stats.steals += pool.threads[i].steals;
+        g_last_stats.splits += pool.threads[i].splits;
+        g_last_stats.eval_probes += pool.threads[i].evalProbes;
+        g_last_stats.eval_hits   += pool.threads[i].evalHits;
+    }
+}
+
+/**
+ * @brief Reconstruit la variation principale d'un coup racine en suivant la TT.
+ * @param start La position racine.
+ * @param blueToPlay Camp au trait à la racine.
+ * @param first Le coup racine.
+ * @param[out] pv La variation (commence par `first`).
+ * @param maxLen Longueur maximale de la variation.
+ * @return La longueur de la variation.
+ */
+static int extract_pv(const Board* start, bool blueToPlay, Move first, Move pv[], int maxLen) {
     Board b = *start;
+    bool side = blueToPlay;
+    Move m = first;
+    int len = 0;
+
+    while (len < maxLen) {
+        pv[len++] = m;
+        apply_move(&b, &m);
+        side = !side;
+        if (check_winner(&b) != 0) break;
+
+        TTEntry e;
+        if (!tt_enabled() || !tt_probe(zobrist_hash(&b, side), &e)) break;
+        if (!is_legal_move(&b, side, &e.best)) break;
+        m = e.best;
+    }
+    return len;
+}
 
+/**
+ * @brief Range les lignes d'une itération du meilleur au moins bon score pour le camp au trait.
+ *
+ * Chaque ligne exclut les coups des précédentes, mais l'instabilité de la
+ * recherche peut donner à une ligne un score meilleur qu'à celle d'avant.
+ * @param lines Les lignes (tri par insertion, stable).
+ * @param n Nombre de lignes.
+ * @param blueToPlay Camp au trait à la racine.
+ */
+static void sort_pv_lines(PVLine lines[], int n, bool blueToPlay) {
+    for (int i=1; i<n; i++) {
+        PVLine x = lines[i];
+        int j = i - 1;
+        while (j >= 0 && (blueToPlay ? lines[j].score < x.score : lines[j].score > x.score)) {
+            lines[j+1] = lines[j];
+            j--;
+        }
+        lines[j+1] = x;
+    }
+}
+
+/**
+ * @see ia.h
+ */
+int search_multipv(const Board* start, bool blueToPlay, int nLines, PVLine lines[]) {
+    ia_init_once();
+    if (!pool.threads[0].stack) return 0;
+
+    Board b = *start;
+    SearchThread *main_th = &pool.threads[0];
     uint64_t key = zobrist_hash(&b, blueToPlay);
+
+    int nLegal = count_moves(&b, blueToPlay);
+    if (nLines > nLegal) nLines = nLegal;
+    if (nLines > MAX_MULTIPV) nLines = MAX_MULTIPV;
+
+    atomic_store(&g_time_up, false);
+    search_begin();
+
+    // Historique de la recherche : partie jouée, puis la racine si elle n'y figure pas déjà.
+    static PositionHistory rootHistory;
+    history_copy(&rootHistory, &g_game_history, g_game_history.count);
+    if (rootHistory.count == 0 || rootHistory.keys[rootHistory.count-1] != key)
+        history_push(&rootHistory, key, count_pieces(&b) != g_game_last_pieces);
+    main_th->hist = &rootHistory;
+    g_root_blue = blueToPlay;
+
+    // Avec un budget de temps, l'approfondissement continue tant que la
+    // limite souple, ajustée à la stabilité du meilleur coup, n'est pas
+    // atteinte ; la limite dure n'est armée qu'après la première itération
+    // pour que la recherche rende toujours un coup.
+    int64_t start_ms = now_ms();
+    int maxDepth = g_budget_active ? TIME_MAX_DEPTH : MAX_DEPTH;
+    Move prevBest = { -1,-1,-1,-1 };
+    int prevScore = 0, stableIters = 0, depthDone = 0;
+    int64_t iterStart = start_ms, prevIterMs = 0;
+
+    // Lignes de l'itération en cours, recopiées dans `lines` une fois toutes
+    // trouvées : une ligne de profondeur d ne côtoie pas celles de d-1, dont
+    // elle pourrait reprendre le coup racine.
+    static PVLine iter[MAX_MULTIPV];
+    int found = 0;
+    for (int d=1; d<=maxDepth; d++) {
+        // Chaque ligne est recherchée sans les coups des lignes précédentes ;
+        // la TT, partagée, garde les sous-arbres communs d'une ligne à l'autre.
+        int k;
+        for (k=0; k<nLines; k++) {
+            Move iterBest = { -1,-1,-1,-1 };
+            main_th->excluded = iter;
+            main_th->nExcluded = k;
+            int val = minimax(&b, d, 0, -INF_SCORE, INF_SCORE, blueToPlay, key, &iterBest, main_th);
+            if (search_interrupted() || iterBest.r1 < 0) break;
+            iter[k].move = iterBest;
+            iter[k].score = val;
+#ifdef IA_TESTS
+            if (d == g_test_stop_depth && k + 1 == g_test_stop_lines) atomic_store(&g_stop_requested, true);
+#endif
+        }
+        // Une itération interrompue est abandonnée, sauf la première : ses
+        // lignes terminées valent mieux qu'aucune.
+        if (search_interrupted()) {
+            if (found == 0) {
+                sort_pv_lines(iter, k, blueToPlay);
+                memcpy(lines, iter, k * sizeof(PVLine));
+                found = k;
+            }
+            break;
+        }
+        sort_pv_lines(iter, k, blueToPlay);
+        memcpy(lines, iter, k * sizeof(PVLine));
+        found = k;
+        if (found == 0) break;
+        depthDone = d;
+
+        if (!g_budget_active) continue;
+        if (d == 1) atomic_store(&g_deadline_ms, start_ms + g_budget.hard_ms);
+
+        bool changed = d > 1 && !same_move(&lines[0].move, &prevBest);
+        bool swing = d > 1 && abs(lines[0].score - prevScore) > TIME_SWING_SCORE;
+        stableIters = (changed || swing) ? 0 : stableIters + 1;
+        prevBest = lines[0].move;
+        prevScore = lines[0].score;
+
+        int64_t soft = g_budget.soft_ms;
+        if (changed || swing) soft = soft * TIME_UNSTABLE_PCT / 100;
+        else if (stableIters >= TIME_STABLE_ITERS) soft = soft * TIME_STABLE_PCT / 100;
+        if (abs(lines[0].score) >= 100000) break; // gain ou perte forcés
+
+        // Une itération coûte plusieurs fois la précédente : on n'en commence
+        // pas une qui n'aurait aucune chance de finir avant la limite dure.
+        int64_t now = now_ms(), iterMs = now - iterStart;
+        int64_t growth = prevIterMs > 0 ? iterMs / prevIterMs : 0;
+        if (growth < 2) growth = 2;
+        if (now - start_ms >= soft || now - start_ms + iterMs * growth > g_budget.hard_ms) break;
+        prevIterMs = iterMs > 0 ? iterMs : 1;
+        iterStart = now;
+    }
+    main_th->excluded = NULL;
+    main_th->nExcluded = 0;
+    atomic_store(&g_deadline_ms, INT64_MAX);
+
+    search_end();
+    g_last_stats.depth = depthDone;
+    g_last_stats.time_ms = now_ms() - start_ms;
+
+    for (int k=0; k<found; k++)
+        lines[k].length = extract_pv(&b, blueToPlay, lines[k].move, lines[k].pv, MAX_PV_LENGTH);
+
+    return found;
+}
+
+// Solveur de finale (df-pn)
+
+#define PN_INF     100000000u          /**< Nombre de preuve (ou de réfutation) infini. */
+#define PN_TABLE_SIZE (1u << PN_TABLE_POW2)
+
+/**
+ * @brief État d'une position fille, déterminé une fois à l'entrée du nœud.
+ */
+enum { PN_OPEN, PN_WIN, PN_LOSS };
+
+/**
+ * @struct PnEntry
+ * @brief Nombres de preuve et de réfutation d'une position (gain de l'attaquant).
+ */
+typedef struct {
+    uint64_t key; /**< Clé de Zobrist de la position. */
+    uint32_t pn;  /**< Nombre de preuve : 0 si le gain est prouvé. */
+    uint32_t dn;  /**< Nombre de réfutation : 0 si le gain est impossible. */
+} PnEntry;
+
+static PnEntry *g_pn_table = NULL; /**< Table du solveur, vidée à chaque résolution. */
+
+/**
+ * @struct PnSearch
+ * @brief Contexte d'une résolution.
+ */
+typedef struct {
+    SearchThread *th;      /**< Thread dont la pile de recherche est utilisée. */
+    bool attackerBlue;     /**< Camp dont on cherche à prouver le gain. */
+    uint64_t nodes;        /**< Nœuds développés. */
+    bool aborted;          /**< Budget épuisé ou arrêt demandé. */
+    Move rootBest;         /**< Coup gagnant de la racine, une fois prouvé. */
+} PnSearch;
+
+/**
+ * @brief Additionne deux nombres de preuve en saturant à PN_INF.
+ */
+static inline uint32_t pn_add(uint32_t a, uint32_t b) {
+    return (a >= PN_INF - b) ? PN_INF : a + b;
+}
+
+/**
+ * @brief Lit les nombres de preuve et de réfutation d'une position (1, 1 si inconnue).
+ */
+static inline void pn_lookup(uint64_t key, uint32_t *pn, uint32_t *dn) {
+    const PnEntry *e = &g_pn_table[key & (PN_TABLE_SIZE - 1)];
+    if (e->key == key) { *pn = e->pn; *dn = e->dn; }
+    else               { *pn = 1;     *dn = 1; }
+}
+
+/**
+ * @brief Mémorise les nombres de preuve et de réfutation d'une position.
+ */
+static inline void pn_store(uint64_t key, uint32_t pn, uint32_t dn) {
+    PnEntry *e = &g_pn_table[key & (PN_TABLE_SIZE - 1)];
+    e->key = key; e->pn = pn; e->dn = dn;
+}
+
+/**
+ * @brief Développe un nœud jusqu'à dépasser l'un de ses seuils (Nagai, df-pn).
+ *
+ * On raisonne en (phi, delta) : au nœud OU (attaquant au trait) phi = pn et
+ * delta = dn, au nœud ET l'inverse. Les fils terminaux, les répétitions et
+ * les fils au-delà de la pile de recherche sont classés une fois pour toutes.
+ * @param ps Le contexte de résolution.
+ * @param b La position (modifiée puis restaurée).
+ * @param blueToPlay Camp au trait.
+ * @param key Clé de Zobrist de la position.
+ * @param ply Distance à la racine (niveau de la pile de recherche).
+ * @param thPhi Seuil de phi.
+ * @param thDelta Seuil de delta.
+ */
+static void pn_mid(PnSearch *ps, Board *b, bool blueToPlay, uint64_t key, int ply, uint32_t thPhi, uint32_t thDelta) {
+    bool orNode = (blueToPlay == ps->attackerBlue);
+    if (++ps->nodes > PN_MAX_NODES || atomic_load_explicit(&g_stop_requested, memory_order_relaxed)) {
+        ps->aborted = true;
+        return;
+    }
+
+    SearchFrame *f = &ps->th->stack[ply];
+    PositionHistory *h = ps->th->hist;
+    int n = generate_moves(b, blueToPlay, f->moves, MAX_MOVES);
+    if (n == 0) {
+        // Sans coup, la partie n'est pas gagnée par l'attaquant.
+        pn_store(key, PN_INF, 0);
+        return;
+    }
+
+    for (int i=0; i<n; i++) {
+        f->undo = *b;
+        int mover = b->pion[f->moves[i].r1][f->moves[i].c1];
+        int captured = apply_move(b, &f->moves[i]);
+        f->childKeys[i] = zobrist_after_move(key, &f->undo, b, &f->moves[i]);
+        // La position mère n'est pas terminale : seul un roi qui bouge ou une capture peut la conclure.
+        int w = (captured > 0 || mover == ROI_BLEU || mover == ROI_ROUGE) ? check_winner(b) : 0;
+        if (w != 0) {
+            f->scores[i] = ((w > 0) == ps->attackerBlue) ? PN_WIN : PN_LOSS;
+        } else {
+            history_push(h, f->childKeys[i], captured > 0);
+            f->scores[i] = (history_is_repetition(h) || ply+1 >= MAX_PLY-1) ? PN_LOSS : PN_OPEN;
+            history_pop(h);
+        }
+        *b = f->undo;
+    }
+
+    for (;;) {
+        uint32_t minDelta = PN_INF, delta2 = PN_INF, sumPhi = 0, bestPhi = 0;
+        int best = 0;
+        for (int i=0; i<n; i++) {
+            uint32_t pn, dn;
+            if (f->scores[i] == PN_WIN)       { pn = 0;      dn = PN_INF; }
+            else if (f->scores[i] == PN_LOSS) { pn = PN_INF; dn = 0; }
+            else pn_lookup(f->childKeys[i], &pn, &dn);
+            // Le fils est un nœud du type opposé.
+            uint32_t phi = orNode ? dn : pn, delta = orNode ? pn : dn;
+            sumPhi = pn_add(sumPhi, phi);
+            if (delta < minDelta) { delta2 = minDelta; minDelta = delta; best = i; bestPhi = phi; }
+            else if (delta < delta2) delta2 = delta;
+        }
+
+        uint32_t phiN = minDelta, deltaN = sumPhi;
+        if (phiN >= thPhi || deltaN >= thDelta || ps->aborted) {
+            uint32_t pn = orNode ? phiN : deltaN, dn = orNode ? deltaN : phiN;
+            // Les preuves restent dans la table du solveur : elles dépendent de
+            // l'historique (répétitions) et de la distance à la racine (MAX_PLY),
+            // que la TT, partagée par les recherches et sauvegardée, ignore.
+            pn_store(key, pn, dn);
+            if (ply == 0) ps->rootBest = f->moves[best];
+            return;
+        }
+
+        uint64_t childPhi = (uint64_t)thDelta + bestPhi - sumPhi;
+        uint32_t childDelta = (delta2 + 1 < thPhi) ? delta2 + 1 : thPhi;
+        if (childPhi > PN_INF) childPhi = PN_INF;
+
+        f->undo = *b;
+        int captured = apply_move(b, &f->moves[best]);
+        history_push(h, f->childKeys[best], captured > 0);
+        pn_mid(ps, b, !blueToPlay, f->childKeys[best], ply+1, (uint32_t)childPhi, childDelta);
+        history_pop(h);
+        *b = f->undo;
+    }
+}
+
+/**
+ * @see ia.h
+ */
+bool ia_solve_endgame(const Board* start, bool blueToPlay, Move* out) {
+    ia_init_once();
+    SearchThread *th = &pool.threads[0];
+    if (!th->stack || check_winner(start) != 0 || atomic_load(&g_stop_requested)) return false;
+
+    uint64_t key = zobrist_hash(start, blueToPlay);
+    memset(&g_last_stats, 0, sizeof(g_last_stats));
+    g_last_stats.threads = pool.nthreads;
+
+    // Même historique que la recherche : les répétitions de la partie comptent.
+    static PositionHistory pnHistory;
+    history_copy(&pnHistory, &g_game_history, g_game_history.count);
+    if (pnHistory.count == 0 || pnHistory.keys[pnHistory.count-1] != key)
+        history_push(&pnHistory, key, count_pieces(start) != g_game_last_pieces);
+
+    if (!g_pn_table) g_pn_table = (PnEntry*)malloc(PN_TABLE_SIZE * sizeof(PnEntry));
+    if (!g_pn_table) return false;
+    memset(g_pn_table, 0, PN_TABLE_SIZE * sizeof(PnEntry));
+
+    PositionHistory *savedHist = th->hist;
+    th->hist = &pnHistory;
+    PnSearch ps = { .th = th, .attackerBlue = blueToPlay, .rootBest = { -1,-1,-1,-1 } };
+    Board b = *start;
+    pn_mid(&ps, &b, blueToPlay, key, 0, PN_INF - 1, PN_INF - 1);
+    th->hist = savedHist;
+    g_last_stats.nodes = ps.nodes;
+
+    uint32_t pn, dn;
+    pn_lookup(key, &pn, &dn);
+    if (pn != 0 || ps.rootBest.r1 < 0) return false;
+    *out = ps.rootBest;
+    return true;
+}
+
+/**
+ * @see ia.h
+ */
+Move search_best_move(const Board* start, bool blueToPlay) {
     Move best = { -1,-1,-1,-1 };
+    ia_init_once();
 
     Move hint = blueToPlay ? g_last_best_move_blue : g_last_best_move_red;
-    if (hint.r1>=0) {
-        TTEntry *e = tt_probe(key);
-        tt_store(key, 0, 0, TT_EXACT, hint);
+    if (hint.r1>=0 && tt_enabled()) {
+        tt_store(zobrist_hash(start, blueToPlay), 0, 0, TT_EXACT, hint);
     }
 
-    for (int d=1; d<=MAX_DEPTH; d++) {
-        Move iterBest = best;
-        int alpha = -INF_SCORE, beta = INF_SCORE;
-        int val = minimax(&b, d, alpha, beta, blueToPlay, key, &iterBest);
-        (void)val;
-        if (iterBest.r1>=0) best = iterBest;
+    // En finale, un gain forcé prouvé dispense de la recherche. Le mode
+    // déterministe, qui mesure la recherche elle-même, s'en passe.
+    Move proven;
+    if (tt_enabled() && count_pieces(start) <= PN_MAX_PIECES && ia_solve_endgame(start, blueToPlay, &proven)) {
+        best = proven;
+    } else {
+        PVLine line;
+        if (search_multipv(start, blueToPlay, 1, &line) > 0) best = line.move;
     }
 
     if (blueToPlay) g_last_best_move_blue = best;
@@ -541,6 +2268,138 @@ Move search_best_move(const Board* start, bool blueToPlay) {
     return best;
 }
 
+/**
+ * @brief Alloue la pile de recherche d'un thread si elle ne l'est pas déjà.
+ * @param th Le thread de recherche.
+ * @return true si la pile est disponible.
+ */
+static bool search_stack_alloc(SearchThread *th) {
+    if (!th->stack) th->stack = aligned_alloc(64, MAX_PLY * sizeof(SearchFrame));
+    return th->stack != NULL;
+}
+
+/**
+ * @brief Arrête et rejoint tous les threads auxiliaires.
+ */
+static void ybw_stop_helpers(void) {
+    pthread_mutex_lock(&pool.lock);
+    pool.quit = true;
+    pthread_cond_broadcast(&pool.cv);
+    pthread_mutex_unlock(&pool.lock);
+    for (int i=1; i<pool.nthreads; i++) pthread_join(pool.threads[i].tid, NULL);
+    pool.quit = false;
+    pool.nthreads = 1;
+}
+
+/**
+ * @see ia.h
+ */
+int ia_set_threads(int n) {
+    if (n < 1) n = 1;
+    if (n > YBW_MAX_THREADS) n = YBW_MAX_THREADS;
+    if (n == pool.nthreads) return n;
+
+    ybw_stop_helpers();
+    for (int i=0; i<n; i++) {
+        SearchThread *th = &pool.threads[i];
+        th->id = i;
+        th->deque.head = th->deque.tail = 0;
+        pthread_mutex_init(&th->deque.lock, NULL);
+    }
+    pool.nthreads = 1;
+    for (int i=1; i<n; i++) {
+        if (!search_stack_alloc(&pool.threads[i])) break;
+        if (pthread_create(&pool.threads[i].tid, NULL, ybw_helper_main, &pool.threads[i]) != 0) break;
+        pool.nthreads++;
+    }
+    return pool.nthreads;
+}
+
+/**
+ * @see ia.h
+ */
+void ia_set_deterministic(bool on) {
+    pool.deterministic = on;
+}
+
+/**
+ * @see ia.h
+ */
+void ia_history_clear(void) {
+    memset(&g_game_history, 0, sizeof(g_game_history));
+    g_game_last_pieces = -1;
+}
+
+/**
+ * @see ia.h
+ */
+void ia_history_push(const Board* b, bool blueToPlay) {
+    ia_init_once();
+    if (g_game_history.count >= HISTORY_GAME_MAX) return;
+
+    int pieces = count_pieces(b);
+    history_push(&g_game_history, zobrist_hash(b, blueToPlay), pieces != g_game_last_pieces);
+    g_game_last_pieces = pieces;
+}
+
+/**
+ * @see ia.h
+ */
+void ia_set_repetition_policy(RepetitionPolicy policy, int contempt) {
+    g_rep_policy = policy;
+    g_rep_contempt = contempt;
+}
+
+/**
+ * @see ia.h
+ */
+MoveBudget ia_allocate_time(int64_t remainingMs, int64_t incrementMs, int tour) {
+    if (tour < 1) tour = 1;
+    int movesLeft = tour >= IA_TOURS_MAX ? 1 : (IA_TOURS_MAX - tour) / 2 + 1;
+
+    int64_t usable = remainingMs - TIME_MARGIN_MS;
+    if (usable < 0) usable = 0;
+    if (incrementMs < 0) incrementMs = 0;
+
+    // Les incréments des coups suivants s'ajoutent au temps à répartir,
+    // pas celui de ce coup : il n'arrive qu'une fois le coup joué.
+    MoveBudget mb;
+    mb.soft_ms = (usable + incrementMs * (movesLeft - 1)) / movesLeft;
+    mb.hard_ms = mb.soft_ms * TIME_HARD_FACTOR;
+    if (mb.hard_ms > usable) mb.hard_ms = usable;
+    if (mb.soft_ms > mb.hard_ms) mb.soft_ms = mb.hard_ms;
+    return mb;
+}
+
+/**
+ * @see ia.h
+ */
+void ia_set_move_budget(const MoveBudget *budget) {
+    g_budget_active = budget != NULL;
+    if (budget) g_budget = *budget;
+}
+
+/**
+ * @see ia.h
+ */
+void ia_stop_search(void) {
+    atomic_store(&g_stop_requested, true);
+}
+
+/**
+ * @see ia.h
+ */
+void ia_reset_stop(void) {
+    atomic_store(&g_stop_requested, false);
+}
+
+/**
+ * @see ia.h
+ */
+void ia_get_search_stats(SearchStats *out) {
+    *out = g_last_stats;
+}
+
 // API publique 
 
 /**
@@ -548,8 +2407,77 @@ Move search_best_move(const Board* start, bool blueToPlay) {
  */
 void ia_init_once(void) {
     if (!TT) {
+        pthread_mutex_init(&pool.threads[0].deque.lock, NULL);
         TT = (TTEntry*)calloc(TT_SIZE, sizeof(TTEntry));
+        g_eval_cache = calloc(EVAL_CACHE_SIZE, sizeof(*g_eval_cache));
         zobrist_init();
+        slide_init();
     }
+    if (!search_stack_alloc(&pool.threads[0]))
+        fprintf(stderr, "IA : allocation de la pile de recherche impossible\n");
 }
 
+#ifdef IA_TESTS
+// Points d'entrée pour les tests
+
+/**
+ * @see ia.h
+ */
+int ia_test_occupancy(const Board* b, bool pext, uint16_t rows[SIZE], uint16_t cols[SIZE]) {
+    Occupancy o;
+    if (!pext) {
+        occupancy_mul(b, &o);
+    } else {
+#if defined(__x86_64__) && defined(__GNUC__)
+        __builtin_cpu_init();
+        if (!__builtin_cpu_supports("bmi2")) return -1;
+        occupancy_pext(b, &o);
+#else
+        return -1;
+#endif
+    }
+    memcpy(rows, o.rows, sizeof(o.rows));
+    memcpy(cols, o.cols, sizeof(o.cols));
+    return 0;
+}
+
+/**
+ * @see ia.h
+ */
+int ia_test_capture_gain(const Board* b, int from, int to) {
+    int d = geo_direction_entre(from, to);
+    return d < 0 ? -1 : capture_gain(b, from, to, d);
+}
+
+/**
+ * @see ia.h
+ */
+int ia_test_see(const Board* b, int from, int to) {
+    int d = geo_direction_entre(from, to);
+    return d < 0 ? INT32_MIN : see_exchange(b, from, to, d, 0);
+}
+
+/**
+ * @see ia.h
+ */
+int ia_test_king_moves_to_goal(const Board* b, int from, int goal, int limit) {
+    Occupancy o;
+    board_occupancy(b, &o);
+    return king_moves_to_goal(&o, from, goal, limit);
+}
+
+/**
+ * @see ia.h
+ */
+bool ia_test_king_wins_next(const Board* b, bool blueToPlay) {
+    return king_wins_next(b, blueToPlay);
+}
+
+/**
+ * @see ia.h
+ */
+void ia_test_stop_multipv_at(int depth, int lines) {
+    g_test_stop_depth = depth;
+    g_test_stop_lines = lines;
+}
+#endif
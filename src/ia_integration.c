@@ -5,12 +5,38 @@
  *
  * ia_integration.c sert de pont entre la logique de l'IA (ia.c) et l'état
  * du jeu géré par l'interface GTK (plateau.c, jeu.c). Il contient les
- * fonctions pour "photographier" l'état actuel du plateau et pour
- * simuler un clic sur l'interface afin de jouer le coup choisi par l'IA.
+ * fonctions pour "photographier" l'état actuel du plateau, lancer la
+ * recherche dans un thread dédié, puis simuler un clic sur l'interface
+ * depuis la boucle principale afin de jouer le coup choisi par l'IA.
  */
 #include "ia.h"
 #include "config.h"
 #include "jeu.h" 
+#include "latence.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/**
+ * @struct IaJob
+ * @brief Une recherche confiée au thread de l'IA, et son résultat.
+ */
+typedef struct {
+    Board board;         /**< Copie de la position à analyser. */
+    bool blueToPlay;     /**< Camp pour lequel l'IA joue. */
+    unsigned generation; /**< Génération au lancement (détecte les recherches annulées). */
+    bool timed;          /**< true si la partie se joue à la pendule. */
+    MoveBudget budget;   /**< Temps accordé au coup (si `timed`). */
+    gint64 started_us;   /**< Début de la réflexion (horloge monotone). */
+    Move move;           /**< Coup trouvé par la recherche. */
+} IaJob;
+
+static pthread_t ia_worker;              /**< Thread de la recherche en cours. */
+static bool ia_worker_running = false;   /**< true tant que `ia_worker` n'a pas été rejoint. */
+static unsigned ia_generation = 0;       /**< Incrémentée à chaque annulation (thread GTK uniquement). */
+static int64_t ia_clock_ms = 0;          /**< Temps restant à la pendule de l'IA (négatif après un dépassement). */
+static bool ia_clock_started = false;    /**< true une fois la pendule de l'IA lancée. */
 
 /**
  * @brief Prend une "photo" de l'état du plateau GTK pour le donner à l'IA.
@@ -24,43 +50,136 @@
 static void snapshot_board(Board* b) {
     for (int r=0; r<SIZE; r++)
         for (int c=0; c<SIZE; c++)
-            b->pion[r][c] = plateau[r][c]->pion;
+            b->pion[r][c] = (int8_t)plateau[r][c]->pion;
 }
 
 /**
- * @see ia.h
+ * @brief Joue le coup de l'IA en simulant la sélection puis le clic sur l'interface.
+ * @param m Le coup à jouer.
  */
-void ia_play_blue(void) {
-    ia_init_once();
-    if (config.mode == LOCAL) return;
-
-    Board b; snapshot_board(&b);
-    if (check_winner(&b) != 0) return;
-
-    Move m = search_best_move(&b, true);
-    if (m.r1<0) return;
-
+static void play_move_on_ui(Move m) {
     Case* from = plateau[m.r1][m.c1];
     Case* to   = plateau[m.r2][m.c2];
     select_case(from);
     on_cell_clicked_tcp(to->button, to);
 }
 
+/**
+ * @brief Reçoit le résultat de la recherche dans la boucle principale GTK.
+ *
+ * Appelée via `g_main_context_invoke` par le thread de l'IA. Le résultat
+ * est ignoré si la recherche a été annulée entre-temps.
+ * @param user_data Le `IaJob` terminé.
+ * @return G_SOURCE_REMOVE pour une exécution unique.
+ */
+static gboolean ia_apply_result(gpointer user_data) {
+    IaJob *job = (IaJob *)user_data;
+
+    if (job->generation == ia_generation && ia_worker_running) {
+        pthread_join(ia_worker, NULL);
+        ia_worker_running = false;
+        latency_record(LAT_THINK, g_get_monotonic_time() - job->started_us);
+        if (job->timed) {
+            // La pendule tourne de la demande du coup jusqu'à ce qu'il soit joué.
+            ia_clock_ms -= (g_get_monotonic_time() - job->started_us) / 1000;
+            ia_clock_ms += config.increment_ms;
+        }
+        if (!game_over && job->move.r1 >= 0) play_move_on_ui(job->move);
+    }
+
+    free(job);
+    return G_SOURCE_REMOVE;
+}
+
+/**
+ * @brief Corps du thread de l'IA : recherche puis renvoie le coup au thread GTK.
+ * @param arg Le `IaJob` à traiter.
+ * @return NULL.
+ */
+static void *ia_worker_main(void *arg) {
+    IaJob *job = (IaJob *)arg;
+    ia_set_move_budget(job->timed ? &job->budget : NULL);
+    job->move = search_best_move(&job->board, job->blueToPlay);
+    g_main_context_invoke(NULL, ia_apply_result, job);
+    return NULL;
+}
+
+/**
+ * @brief Lance la recherche de l'IA pour un camp dans un thread dédié.
+ * @param blueToPlay true pour le camp bleu, false pour le camp rouge.
+ */
+static void ia_play_side(bool blueToPlay) {
+    ia_init_once();
+    if (config.mode == LOCAL || ia_worker_running) return;
+
+    IaJob *job = malloc(sizeof(IaJob));
+    if (!job) return;
+    snapshot_board(&job->board);
+    if (check_winner(&job->board) != 0) { free(job); return; }
+    job->blueToPlay = blueToPlay;
+    job->generation = ia_generation;
+    job->started_us = g_get_monotonic_time();
+    job->timed = config.clock_ms > 0;
+    if (job->timed) {
+        if (!ia_clock_started) {
+            ia_clock_ms = config.clock_ms;
+            ia_clock_started = true;
+        }
+        // Un dépassement n'est jamais rendu : la pendule reste à zéro.
+        job->budget = ia_allocate_time(ia_clock_ms > 0 ? ia_clock_ms : 0, config.increment_ms, tour);
+    }
+    job->move = (Move){ -1,-1,-1,-1 };
+
+    ia_reset_stop();
+    if (pthread_create(&ia_worker, NULL, ia_worker_main, job) != 0) {
+        fprintf(stderr, "Erreur : impossible de lancer le thread de l'IA\n");
+        free(job);
+        return;
+    }
+    ia_worker_running = true;
+}
+
+/**
+ * @see ia.h
+ */
+void ia_play_blue(void) {
+    ia_play_side(true);
+}
+
 /**
  * @see ia.h
  */
 void ia_play_red(void) {
-    ia_init_once();
-    if (config.mode == LOCAL) return;
+    ia_play_side(false);
+}
+
+/**
+ * @see ia.h
+ */
+void ia_note_position(void) {
+    Board b;
+    snapshot_board(&b);
+    ia_history_push(&b, tour % 2 != 0);
+}
 
-    Board b; snapshot_board(&b);
-    if (check_winner(&b) != 0) return;
+/**
+ * @see ia.h
+ */
+void ia_persist_tt(void) {
+    if (!config.ai || !config.tt_path[0]) return;
+    int n = ia_tt_save(config.tt_path, TT_SAVE_MIN_DEPTH);
+    if (n < 0) fprintf(stderr, "Erreur : impossible d'écrire la TT dans %s\n", config.tt_path);
+    else printf("TT sauvegardée : %d entrées dans %s\n", n, config.tt_path);
+}
 
-    Move m = search_best_move(&b, false);
-    if (m.r1<0) return;
+/**
+ * @see ia.h
+ */
+void ia_cancel_search(void) {
+    ia_generation++;
+    if (!ia_worker_running) return;
 
-    Case* from = plateau[m.r1][m.c1];
-    Case* to   = plateau[m.r2][m.c2];
-    select_case(from);
-    on_cell_clicked_tcp(to->button, to);
+    ia_stop_search();
+    pthread_join(ia_worker, NULL);
+    ia_worker_running = false;
 }
@@ -14,6 +14,8 @@
 #include "config.h"
 #include "plateau.h"
 #include "reseau_integration.h"
+#include "ia.h"
+#include "geometrie.h"
 
 #include <gtk/gtk.h>
 int game_over = 0;
@@ -39,6 +41,8 @@ static inline int in_bounds(int r, int c)
 void endgame(int fatal, int color)
 {
     game_over = 1;
+    ia_cancel_search();
+    ia_persist_tt();
     gtk_widget_set_sensitive(config.window, FALSE);
     if (fatal)
     {
@@ -152,6 +156,16 @@ void clear_case(Case *cell)
     }
 }
 
+/**
+ * @brief Retourne la case graphique correspondant à un indice de geometrie.h.
+ * @param i Indice de la case (ligne * SIZE + colonne).
+ * @return La case du plateau.
+ */
+static inline Case *case_at(int i)
+{
+    return plateau[CASE_LIGNE(i)][CASE_COL(i)];
+}
+
 /**
  * @see jeu.h
  */
@@ -162,85 +176,29 @@ void select_case(Case *cell)
         printf("%s\n", "case founie incorrect, impossible de sélectionner");
         return;
     }
-    selected = cell;
-    gtk_widget_add_css_class(selected->button, "selected"); // passe la case cliquée en sélectionnée
-
-    // parsing des coordonnées
-    char lettre = selected->id[0];
-    char chiffre = selected->id[1];
-
-    // changement du label des cases jouables à partir de la case sélectionnée
-    int start = chiffre - '0';              // conversion string en int
-    for (int i = start + 1; i <= SIZE; i++) // HAUT
+    int idx = geo_index_depuis_id(cell->id);
+    if (idx < 0)
     {
-        char id[10];
-        sprintf(id, "%c%d", lettre, i);
-        Case *temp = get_case_by_id(id);
-        if (!temp)
-        {
-            printf("%s\n", "case founie incorrect, erreur boucle haut fonction de sélection");
-        }
-
-        if (temp->pion) // arrêt de recherche à la première case contenant un pion
-        {
-            break;
-        }
-        gtk_button_set_label(GTK_BUTTON(temp->button), "•"); // case jouable affichée
-        gtk_widget_add_css_class(temp->button, "haut");      // direction du pion si case jouée
-    }
-
-    for (int i = start - 1; i > 0; i--) // BAS
-    {
-        char id[10];
-        sprintf(id, "%c%d", lettre, i);
-        Case *temp = get_case_by_id(id);
-        if (!temp)
-        {
-            printf("%s\n", "case founie incorrect, erreur boucle bas fonction de sélection");
-        }
-
-        if (temp->pion)
-        {
-            break;
-        }
-        gtk_button_set_label(GTK_BUTTON(temp->button), "•");
-        gtk_widget_add_css_class(temp->button, "bas");
-    }
-
-    for (char i = lettre + 1; i <= 'I'; i++) // DROITE
-    {
-        char id[10];
-        sprintf(id, "%c%c", i, chiffre);
-        Case *temp = get_case_by_id(id);
-        if (!temp)
-        {
-            printf("%s\n", "case founie incorrect, erreur boucle droite fonction de sélection");
-        }
-
-        if (temp->pion)
-        {
-            break;
-        }
-        gtk_button_set_label(GTK_BUTTON(temp->button), "•");
-        gtk_widget_add_css_class(temp->button, "droite");
+        printf("%s\n", "identifiant de case incorrect, impossible de sélectionner");
+        return;
     }
+    selected = cell;
+    gtk_widget_add_css_class(selected->button, "selected"); // passe la case cliquée en sélectionnée
 
-    for (char i = lettre - 1; i >= 'A'; i--) // GAUCHE
+    // changement du label des cases jouables à partir de la case sélectionnée, direction par direction
+    const Rayons *ray = &geo_rayons[idx];
+    for (int d = 0; d < NB_DIRECTIONS; d++)
     {
-        char id[10];
-        sprintf(id, "%c%c", i, chiffre);
-        Case *temp = get_case_by_id(id);
-        if (!temp)
-        {
-            printf("%s\n", "case founie incorrect, erreur boucle gauche fonction de sélection");
-        }
-
-        if (temp->pion)
+        for (int k = 0; k < ray->longueur[d]; k++)
         {
-            break;
+            Case *temp = case_at(ray->cases[d][k]);
+            if (temp->pion) // arrêt de recherche à la première case contenant un pion
+            {
+                break;
+            }
+            gtk_button_set_label(GTK_BUTTON(temp->button), "•");              // case jouable affichée
+            gtk_widget_add_css_class(temp->button, geo_noms_directions[d]); // direction du pion si case jouée
         }
-        gtk_button_set_label(GTK_BUTTON(temp->button), "•");
-        gtk_widget_add_css_class(temp->button, "gauche");
     }
 }
 
@@ -250,139 +208,26 @@ void select_case(Case *cell)
 void unselect_case()
 {
     // même logique que pour la fonction sélectionner, sauf qu'on retire tous les labels donnés lors de la sélection
-    char lettre = selected->id[0];
-    char chiffre = selected->id[1];
-
-    int start = chiffre - '0';
-    for (int i = start + 1; i <= SIZE; i++) // HAUT
-    {
-        char id[10];
-        sprintf(id, "%c%d", lettre, i);
-        Case *temp = get_case_by_id(id);
-        if (!temp)
-        {
-            printf("%s\n", "case founie incorrect, erreur boucle haut fonction de déselection");
-        }
-
-        if (temp->pion)
-        {
-            break;
-        }
-        else if (strcmp(id, "A9") == 0)
-        {
-            Case *ville1 = get_case_by_id("A9");
-            gtk_button_set_label(GTK_BUTTON(ville1->button), "市");
-            gtk_widget_remove_css_class(ville1->button, "haut");
-        }
-        else if (strcmp(id, "I1") == 0)
-        {
-            Case *ville2 = get_case_by_id("I1");
-            gtk_button_set_label(GTK_BUTTON(ville2->button), "市");
-            gtk_widget_remove_css_class(ville2->button, "haut");
-        }
-        else
-        {
-            gtk_button_set_label(GTK_BUTTON(temp->button), "");
-            gtk_widget_remove_css_class(temp->button, "haut");
-        }
-    }
-
-    for (int i = start - 1; i > 0; i--) // BAS
-    {
-        char id[10];
-        sprintf(id, "%c%d", lettre, i);
-        Case *temp = get_case_by_id(id);
-        if (!temp)
-        {
-            printf("%s\n", "case founie incorrect, erreur boucle bas fonction de déselection");
-        }
-
-        if (temp->pion)
-        {
-            break;
-        }
-        else if (strcmp(id, "A9") == 0)
-        {
-            Case *ville1 = get_case_by_id("A9");
-            gtk_button_set_label(GTK_BUTTON(ville1->button), "市");
-            gtk_widget_remove_css_class(ville1->button, "haut");
-        }
-        else if (strcmp(id, "I1") == 0)
-        {
-            Case *ville2 = get_case_by_id("I1");
-            gtk_button_set_label(GTK_BUTTON(ville2->button), "市");
-            gtk_widget_remove_css_class(ville2->button, "haut");
-        }
-        else
-        {
-            gtk_button_set_label(GTK_BUTTON(temp->button), "");
-            gtk_widget_remove_css_class(temp->button, "bas");
-        }
-    }
-
-    for (char i = lettre + 1; i <= 'I'; i++) // DROITE
+    int idx = geo_index_depuis_id(selected->id);
+    const Rayons *ray = &geo_rayons[idx];
+    for (int d = 0; d < NB_DIRECTIONS; d++)
     {
-        char id[10];
-        sprintf(id, "%c%c", i, chiffre);
-        Case *temp = get_case_by_id(id);
-        if (!temp)
-        {
-            printf("%s\n", "case founie incorrect, erreur boucle droite fonction de déselection");
-        }
-
-        if (temp->pion)
-        {
-            break;
-        }
-        else if (strcmp(id, "A9") == 0)
-        {
-            Case *ville1 = get_case_by_id("A9");
-            gtk_button_set_label(GTK_BUTTON(ville1->button), "市");
-            gtk_widget_remove_css_class(ville1->button, "haut");
-        }
-        else if (strcmp(id, "I1") == 0)
-        {
-            Case *ville2 = get_case_by_id("I1");
-            gtk_button_set_label(GTK_BUTTON(ville2->button), "市");
-            gtk_widget_remove_css_class(ville2->button, "haut");
-        }
-        else
-        {
-            gtk_button_set_label(GTK_BUTTON(temp->button), "");
-            gtk_widget_remove_css_class(temp->button, "droite");
-        }
-    }
-
-    for (char i = lettre - 1; i >= 'A'; i--) // GAUCHE
-    {
-        char id[10];
-        sprintf(id, "%c%c", i, chiffre);
-        Case *temp = get_case_by_id(id);
-        if (!temp)
-        {
-            printf("%s\n", "case founie incorrect, erreur boucle gauche fonction de déselection");
-        }
-
-        if (temp->pion)
-        {
-            break;
-        }
-        else if (strcmp(id, "A9") == 0)
-        {
-            Case *ville1 = get_case_by_id("A9");
-            gtk_button_set_label(GTK_BUTTON(ville1->button), "市");
-            gtk_widget_remove_css_class(ville1->button, "haut");
-        }
-        else if (strcmp(id, "I1") == 0)
-        {
-            Case *ville2 = get_case_by_id("I1");
-            gtk_button_set_label(GTK_BUTTON(ville2->button), "市");
-            gtk_widget_remove_css_class(ville2->button, "haut");
-        }
-        else
+        for (int k = 0; k < ray->longueur[d]; k++)
         {
-            gtk_button_set_label(GTK_BUTTON(temp->button), "");
-            gtk_widget_remove_css_class(temp->button, "gauche");
+            Case *temp = case_at(ray->cases[d][k]);
+            if (temp->pion)
+            {
+                break;
+            }
+            if (strcmp(temp->id, "A9") == 0 || strcmp(temp->id, "I1") == 0)
+            {
+                gtk_button_set_label(GTK_BUTTON(temp->button), "市"); // les villes gardent leur symbole
+            }
+            else
+            {
+                gtk_button_set_label(GTK_BUTTON(temp->button), "");
+            }
+            gtk_widget_remove_css_class(temp->button, geo_noms_directions[d]);
         }
     }
 
@@ -396,233 +241,57 @@ void unselect_case()
  */
 void capture(Case *cell, char *mouvement)
 {
-    bool ack = true;
-    Case *victim_case;
-    Case *guard_case;
-
-    // récupération de coordonnées
-    char lettre = cell->id[0];
-    char chiffre = cell->id[1];
-    if (strcmp(mouvement, "haut") == 0)
+    int idx = geo_index_depuis_id(cell->id);
+    int d = geo_direction(mouvement);
+    if (idx < 0 || d < 0)
     {
-        int tmp1 = (chiffre - '0') + 1;
-        int tmp2 = (chiffre - '0') + 2;
-        if (tmp1 > 9) // si coordonnée de la victime en dehors du plateau, alors fin de fonction
-        {
-            return;
-        }
-        else if (tmp2 > 9)
-        {
-            ack = false; // pas de garde
-        }
-
-        char victim[10];
-        sprintf(victim, "%c%d", lettre, tmp1);
-
-        victim_case = get_case_by_id(victim);
-        if (!victim_case)
-        {
-            printf("%s\n", "erreur de fonction capture, victim haut");
-            return;
-        }
-
-        if (ack)
-        {
-            char guard[10];
-            sprintf(guard, "%c%d", lettre, tmp2);
-
-            guard_case = get_case_by_id(guard);
-            if (!guard_case)
-            {
-                printf("%s\n", "erreur de fonction capture, guard haut");
-                return;
-            }
-        }
+        printf("%s\n", "erreur de fonction capture, case ou direction incorrecte");
+        return;
     }
-    else if (strcmp(mouvement, "bas") == 0)
-    {
-        int tmp1 = (chiffre - '0') - 1;
-        int tmp2 = (chiffre - '0') - 2;
-        if (tmp1 < 1)
-        {
-            return;
-        }
-        else if (tmp2 < 1)
-        {
-            ack = false;
-        }
-
-        char victim[10];
-        sprintf(victim, "%c%d", lettre, tmp1);
-        victim_case = get_case_by_id(victim);
-        if (!victim_case)
-        {
-            printf("%s\n", "erreur de fonction capture, victim bas");
-            return;
-        }
 
-        if (ack)
-        {
-            char guard[10];
-            sprintf(guard, "%c%d", lettre, tmp2);
-            guard_case = get_case_by_id(guard);
-            if (!guard_case)
-            {
-                printf("%s\n", "erreur de fonction capture, guard bas");
-                return;
-            }
-        }
-    }
-    else if (strcmp(mouvement, "droite") == 0)
+    int i_victim = geo_voisin[idx][d];
+    if (i_victim < 0) // si la victime est en dehors du plateau, alors fin de fonction
     {
-        int tmp1 = lettre + 1;
-        int tmp2 = lettre + 2;
-        if (tmp1 > 'I')
-        {
-            return;
-        }
-        else if (tmp2 > 'I')
-        {
-            ack = false;
-        }
-
-        char victim[10];
-        sprintf(victim, "%c%c", tmp1, chiffre);
-        victim_case = get_case_by_id(victim);
-        if (!victim_case)
-        {
-            printf("%s\n", "erreur de fonction capture, victim droite");
-            return;
-        }
-
-        if (ack)
-        {
-            char guard[10];
-            sprintf(guard, "%c%c", tmp2, chiffre);
-            guard_case = get_case_by_id(guard);
-            if (!guard_case)
-            {
-                printf("%s\n", "erreur de fonction capture, guard droite");
-                return;
-            }
-        }
+        return;
     }
-    else if (strcmp(mouvement, "gauche") == 0)
+    Case *victim_case = case_at(i_victim);
+    Case *guard_case = geo_voisin2[idx][d] >= 0 ? case_at(geo_voisin2[idx][d]) : NULL; // NULL : pas de garde
+
+    // vérifications
+    if ((cell->pion == SOLDAT_BLEU) || (cell->pion == ROI_BLEU))
     {
-        int tmp1 = lettre - 1;
-        int tmp2 = lettre - 2;
-        if (tmp1 < 'A')
+        if (guard_case && (guard_case->pion == SOLDAT_ROUGE || guard_case->pion == ROI_ROUGE))
         {
             return;
         }
-        else if (tmp2 < 'A')
-        {
-            ack = false;
-        }
-
-        char victim[10];
-        sprintf(victim, "%c%c", tmp1, chiffre);
-        victim_case = get_case_by_id(victim);
-        if (!victim_case)
+        if (victim_case->pion == SOLDAT_ROUGE)
         {
-            printf("%s\n", "erreur de fonction capture, victim gauche");
-            return;
+            clear_case(victim_case);
+            dead_red_count += 1;
+            check_dead_count();
         }
-        if (ack)
+        else if (victim_case->pion == ROI_ROUGE)
         {
-            char guard[10];
-            sprintf(guard, "%c%c", tmp2, chiffre);
-            guard_case = get_case_by_id(guard);
-            if (!guard_case)
-            {
-                printf("%s\n", "erreur de fonction capture, guard gauche");
-                return;
-            }
+            clear_case(victim_case);
+            endgame(1, 2);
         }
     }
-    // vérifications
-    if ((cell->pion == SOLDAT_BLEU) || (cell->pion == ROI_BLEU))
+    else if ((cell->pion == SOLDAT_ROUGE) || (cell->pion == ROI_ROUGE))
     {
-        if (ack)
+        if (guard_case && (guard_case->pion == SOLDAT_BLEU || guard_case->pion == ROI_BLEU))
         {
-            if (guard_case->pion == SOLDAT_ROUGE || guard_case->pion == ROI_ROUGE)
-            {
-                return;
-            }
-            else
-            {
-                if (victim_case->pion == SOLDAT_ROUGE)
-                {
-                    clear_case(victim_case);
-                    dead_red_count += 1;
-                    check_dead_count();
-                    return;
-                }
-                else if (victim_case->pion == ROI_ROUGE)
-                {
-                    clear_case(victim_case);
-                    endgame(1, 2);
-                    return;
-                }
-            }
-        }
-        else
-        {
-            if (victim_case->pion == SOLDAT_ROUGE)
-            {
-                clear_case(victim_case);
-                dead_red_count += 1;
-                check_dead_count();
-                return;
-            }
-            else if (victim_case->pion == ROI_ROUGE)
-            {
-                clear_case(victim_case);
-                endgame(1, 2);
-                return;
-            }
+            return;
         }
-    }
-    else if ((cell->pion == SOLDAT_ROUGE) || (cell->pion == ROI_ROUGE))
-    {
-        if (ack)
+        if (victim_case->pion == SOLDAT_BLEU)
         {
-            if (guard_case->pion == SOLDAT_BLEU || guard_case->pion == ROI_BLEU)
-            {
-                return;
-            }
-            else
-            {
-                if (victim_case->pion == SOLDAT_BLEU)
-                {
-                    clear_case(victim_case);
-                    dead_blue_count += 1;
-                    check_dead_count();
-                    return;
-                }
-                else if (victim_case->pion == ROI_BLEU)
-                {
-                    clear_case(victim_case);
-                    endgame(1, 1);
-                    return;
-                }
-            }
+            clear_case(victim_case);
+            dead_blue_count += 1;
+            check_dead_count();
         }
-        else
+        else if (victim_case->pion == ROI_BLEU)
         {
-            if (victim_case->pion == SOLDAT_BLEU)
-            {
-                clear_case(victim_case);
-                dead_blue_count += 1;
-                check_dead_count();
-                return;
-            }
-            else if (victim_case->pion == ROI_BLEU)
-            {
-                clear_case(victim_case);
-                endgame(1, 1);
-                return;
-            }
+            clear_case(victim_case);
+            endgame(1, 1);
         }
     }
 }
@@ -672,128 +341,22 @@ void prise_check(Case *cell, Case *near_case, Case *far_case)
  */
 void prise(Case *cell)
 {
-    bool ack = false; // si au moins 2 cases au dessus de la case jouée
-    Case *near_case;
-    Case *far_case;
-
-    char lettre = cell->id[0]; // parsing des coordonnées de la case jouée
-    char chiffre = cell->id[1];
-
-    void check_up()
+    int idx = geo_index_depuis_id(cell->id);
+    if (idx < 0)
     {
-        int tmp1 = (chiffre - '0') + 1;
-        int tmp2 = (chiffre - '0') + 2;
-        if (tmp2 <= 9)
-        {
-            ack = true;
-        }
-
-        if (ack)
-        {
-            char near[10];
-            char far[10];
-            sprintf(near, "%c%d", lettre, tmp1);
-            sprintf(far, "%c%d", lettre, tmp2);
-
-            near_case = get_case_by_id(near);
-            far_case = get_case_by_id(far);
-            if (!near_case || !far_case)
-            {
-                printf("%s\n", "erreur de fonction prise, check haut");
-            }
-
-            prise_check(cell, near_case, far_case);
-        }
-    }
-    void check_down()
-    {
-        int tmp1 = (chiffre - '0') - 1;
-        int tmp2 = (chiffre - '0') - 2;
-        if (tmp2 >= 1)
-        {
-            ack = true;
-        }
-
-        if (ack)
-        {
-            char near[10];
-            char far[10];
-            sprintf(near, "%c%d", lettre, tmp1);
-            sprintf(far, "%c%d", lettre, tmp2);
-
-            near_case = get_case_by_id(near);
-            far_case = get_case_by_id(far);
-            if (!near_case || !far_case)
-            {
-                printf("%s\n", "erreur de fonction prise, check haut");
-            }
-
-            prise_check(cell, near_case, far_case);
-        }
-    }
-
-    void check_right()
-    {
-        char tmp1 = lettre + 1;
-        char tmp2 = lettre + 2;
-        if (tmp2 <= 'I')
-        {
-            ack = true;
-        }
-
-        if (ack)
-        {
-            char near[10];
-            char far[10];
-            sprintf(near, "%c%c", tmp1, chiffre);
-            sprintf(far, "%c%c", tmp2, chiffre);
-
-            near_case = get_case_by_id(near);
-            far_case = get_case_by_id(far);
-            if (!near_case || !far_case)
-            {
-                printf("%s\n", "erreur de fonction prise, check haut");
-            }
-
-            prise_check(cell, near_case, far_case);
-        }
+        printf("%s\n", "erreur de fonction prise, case incorrecte");
+        return;
     }
 
-    void check_left()
+    // pour chaque direction ayant au moins 2 cases devant la case jouée
+    for (int d = 0; d < NB_DIRECTIONS; d++)
     {
-        char tmp1 = lettre - 1;
-        char tmp2 = lettre - 2;
-        if (tmp2 >= 'A')
+        if (geo_voisin2[idx][d] < 0)
         {
-            ack = true;
-        }
-
-        if (ack)
-        {
-            char near[10];
-            char far[10];
-            sprintf(near, "%c%c", tmp1, chiffre);
-            sprintf(far, "%c%c", tmp2, chiffre);
-
-            near_case = get_case_by_id(near);
-            far_case = get_case_by_id(far);
-            if (!near_case || !far_case)
-            {
-                printf("%s\n", "erreur de fonction prise, check haut");
-            }
-
-            prise_check(cell, near_case, far_case);
+            continue;
         }
+        prise_check(cell, case_at(geo_voisin[idx][d]), case_at(geo_voisin2[idx][d]));
     }
-
-    check_up();
-    ack = false;
-    check_down();
-    ack = false;
-    check_right();
-    ack = false;
-    check_left();
-    return;
 }
 
 /**
@@ -985,14 +548,14 @@ void on_cell_clicked_tcp(GtkWidget *button, gpointer user_data)
 
     if (!selected) // logique si une première case n'est pas encore selectionnée
     {
-        if (tour % 2 != 0 && config.mode == CLIENT)
+        if (tour % 2 != 0 && network_plays_blue())
         {
             if (cell->pion == SOLDAT_BLEU || cell->pion == ROI_BLEU)
             {
                 select_case(cell);
             }
         }
-        else if (tour % 2 == 0 && config.mode == SERVER)
+        else if (tour % 2 == 0 && !network_plays_blue())
         {
             if (cell->pion == SOLDAT_ROUGE || cell->pion == ROI_ROUGE)
             {
@@ -1090,7 +653,10 @@ void on_cell_clicked_tcp(GtkWidget *button, gpointer user_data)
     cell->pion = selected_pion;
     gtk_button_set_label(GTK_BUTTON(cell->button), selected_button_label);
     g_free(selected_button_label);
-    send_move_to_network(selected_id, cell->id);
+    if (send_move_to_network(selected_id, cell->id) < 0)
+    {
+        return; // coup refusé par l'arbitre : la partie est abandonnée
+    }
 
     // application des règles
 
@@ -1121,6 +687,7 @@ void on_cell_clicked_tcp(GtkWidget *button, gpointer user_data)
 
     // incrémenter le compteur de tour
     tour += 1;
+    ia_note_position();
     char buffer[100];
     snprintf(buffer, sizeof(buffer), "%d", tour);
     char result[120] = "Tour : ";
@@ -7,6 +7,7 @@
  * interface graphique. Il est conçu pour être testable de manière unitaire.
  */
 #include "jeu_logique.h"
+#include "geometrie.h"
 #include <string.h>
 #include <stdio.h>
 
@@ -14,7 +15,7 @@
  * @var board_init
  * @brief L'état initial du plateau, utilisé pour initialiser une nouvelle partie.
  */
-static int board_init[SIZE][SIZE] = {
+static const int8_t board_init[SIZE][SIZE] = {
     {EMPTY, EMPTY, SOLDAT_BLEU, SOLDAT_BLEU, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY},
     {EMPTY, ROI_BLEU, SOLDAT_BLEU, SOLDAT_BLEU, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY},
     {SOLDAT_BLEU, SOLDAT_BLEU, SOLDAT_BLEU, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY},
@@ -71,29 +72,26 @@ void logique_init_game(GameState *state) {
  */
 void logique_capture(GameState *state, int r, int c, const char* mouvement) {
     if (state->game_over_status != 0) return;
+    if (!in_bounds(r, c)) return;
 
-    int dr = 0, dc = 0;
-    if (strcmp(mouvement, "haut") == 0) dr = -1;
-    else if (strcmp(mouvement, "bas") == 0) dr = 1;
-    else if (strcmp(mouvement, "gauche") == 0) dc = -1;
-    else if (strcmp(mouvement, "droite") == 0) dc = 1;
-
-    int r_victim = r + dr;
-    int c_victim = c + dc;
-    if (!in_bounds(r_victim, c_victim)) return;
+    int d = geo_direction(mouvement);
+    if (d < 0) return;
 
+    int8_t *cases = &state->pion[0][0];
     int attaquant = state->pion[r][c];
-    int victime = state->pion[r_victim][c_victim];
+
+    int i_victim = geo_voisin[CASE_IDX(r, c)][d];
+    if (i_victim < 0) return;
+    int victime = cases[i_victim];
 
     // La capture n'est possible que sur un pion adverse
     if (victime == EMPTY || (is_blue(attaquant) == is_blue(victime))) return;
 
     // Vérification de la protection par un garde
-    int r_guard = r + 2 * dr;
-    int c_guard = c + 2 * dc;
+    int i_guard = geo_voisin2[CASE_IDX(r, c)][d];
     bool est_garde = false;
-    if (in_bounds(r_guard, c_guard)) {
-        int garde = state->pion[r_guard][c_guard];
+    if (i_guard >= 0) {
+        int garde = cases[i_guard];
         // S'il y a une pièce derrière la victime et qu'elle est ennemie de l'attaquant
         if (garde != EMPTY && (is_blue(attaquant) != is_blue(garde))) {
             est_garde = true;
@@ -102,7 +100,7 @@ void logique_capture(GameState *state, int r, int c, const char* mouvement) {
 
     // Si la victime n'est pas gardée, on la capture
     if (!est_garde) {
-        state->pion[r_victim][c_victim] = EMPTY;
+        cases[i_victim] = EMPTY;
         if (is_red(victime)) {
             if (victime == ROI_ROUGE) state->game_over_status = 2; // Bleu gagne
             else state->dead_red_count++;
@@ -122,20 +120,19 @@ void logique_capture(GameState *state, int r, int c, const char* mouvement) {
  *
  * @param state Pointeur vers l'état du jeu.
  * @param attaquant Le type de la pièce qui attaque.
- * @param r_near Ligne de la case adjacente (victime potentielle).
- * @param c_near Colonne de la case adjacente.
- * @param r_far Ligne de la case deux cases plus loin (allié potentiel).
- * @param c_far Colonne de la case deux cases plus loin.
+ * @param i_near Indice de la case adjacente (victime potentielle), -1 hors plateau.
+ * @param i_far Indice de la case deux cases plus loin (allié potentiel), -1 hors plateau.
  */
-static void logique_internal_prise_check(GameState *state, int attaquant, int r_near, int c_near, int r_far, int c_far) {
-    if (!in_bounds(r_near, c_near) || !in_bounds(r_far, c_far)) return;
+static void logique_internal_prise_check(GameState *state, int attaquant, int i_near, int i_far) {
+    if (i_near < 0 || i_far < 0) return;
 
-    int victime = state->pion[r_near][c_near];
-    int allie = state->pion[r_far][c_far];
+    int8_t *cases = &state->pion[0][0];
+    int victime = cases[i_near];
+    int allie = cases[i_far];
 
     // Condition du sandwich : attaquant et allié sont de la même couleur, victime est de couleur opposée
     if (victime != EMPTY && allie != EMPTY && (is_blue(attaquant) == is_blue(allie)) && (is_blue(attaquant) != is_blue(victime))) {
-        state->pion[r_near][c_near] = EMPTY;
+        cases[i_near] = EMPTY;
         if (is_red(victime)) {
             if (victime == ROI_ROUGE) state->game_over_status = 2; // Bleu gagne
             else state->dead_red_count++;
@@ -151,14 +148,15 @@ static void logique_internal_prise_check(GameState *state, int attaquant, int r_
  */
 void logique_prise(GameState *state, int r, int c) {
     if (state->game_over_status != 0) return;
+    if (!in_bounds(r, c)) return;
     int attaquant = state->pion[r][c];
     if (attaquant == EMPTY) return;
 
-    // Vérifie les 4 directions pour une prise en sandwich
-    logique_internal_prise_check(state, attaquant, r - 1, c, r - 2, c); // Haut
-    logique_internal_prise_check(state, attaquant, r + 1, c, r + 2, c); // Bas
-    logique_internal_prise_check(state, attaquant, r, c - 1, r, c - 2); // Gauche
-    logique_internal_prise_check(state, attaquant, r, c + 1, r, c + 2); // Droite
+    // Vérifie les 4 directions (haut, bas, gauche, droite) pour une prise en sandwich
+    int i = CASE_IDX(r, c);
+    for (int d = 0; d < NB_DIRECTIONS; d++) {
+        logique_internal_prise_check(state, attaquant, geo_voisin[i][d], geo_voisin2[i][d]);
+    }
 }
 
 
@@ -203,4 +201,74 @@ void logique_verifier_conditions_fin(GameState *state) {
     if (state->tour > 64) {
         logique_calculer_scores(state);
     }
-}
\ No newline at end of file
+}
+
+/**
+ * @see jeu_logique.h
+ */
+bool logique_coup_legal(const GameState *state, int from, int to) {
+    if (state->game_over_status != 0) return false;
+    if (from < 0 || from >= NB_CASES || to < 0 || to >= NB_CASES) return false;
+    int d = geo_direction_entre(from, to);
+    if (d < 0) return false;
+
+    const int8_t *cases = &state->pion[0][0];
+    int pion = cases[from];
+    if (pion == EMPTY || is_blue(pion) != (state->tour % 2 != 0)) return false;
+
+    // Le rayon s'arrête à la première pièce : la destination doit le précéder.
+    const Rayons *ray = &geo_rayons[from];
+    for (int k = 0; k < ray->longueur[d]; k++) {
+        int i = ray->cases[d][k];
+        if (cases[i] != EMPTY) return false;
+        if (i == to) return true;
+    }
+    return false;
+}
+
+/**
+ * @see jeu_logique.h
+ */
+int logique_coups_legaux(const GameState *state, uint8_t coups[][2]) {
+    if (state->game_over_status != 0) return 0;
+    const int8_t *cases = &state->pion[0][0];
+    bool bleus = state->tour % 2 != 0;
+    int n = 0;
+    for (int from = 0; from < NB_CASES; from++) {
+        if (cases[from] == EMPTY || is_blue(cases[from]) != bleus) continue;
+        const Rayons *ray = &geo_rayons[from];
+        for (int d = 0; d < NB_DIRECTIONS; d++) {
+            for (int k = 0; k < ray->longueur[d] && cases[ray->cases[d][k]] == EMPTY; k++) {
+                coups[n][0] = (uint8_t)from;
+                coups[n][1] = ray->cases[d][k];
+                n++;
+            }
+        }
+    }
+    return n;
+}
+
+/**
+ * @see jeu_logique.h
+ */
+int logique_jouer_coup(GameState *state, int from, int to) {
+    if (!logique_coup_legal(state, from, to)) return -1;
+
+    int r1 = CASE_LIGNE(from), c1 = CASE_COL(from);
+    int r2 = CASE_LIGNE(to), c2 = CASE_COL(to);
+    int pion = state->pion[r1][c1];
+    Direction d = (Direction)geo_direction_entre(from, to);
+
+    // Une ville quittée reprend la couleur de son camp, comme dans l'interface.
+    state->pion[r1][c1] = EMPTY;
+    if (r1 == 0 && c1 == 0) state->couleur[r1][c1] = 2;
+    else if (r1 == SIZE-1 && c1 == SIZE-1) state->couleur[r1][c1] = 1;
+    state->pion[r2][c2] = (int8_t)pion;
+    state->couleur[r2][c2] = is_blue(pion) ? 2 : 1;
+
+    logique_capture(state, r2, c2, geo_noms_directions[d]);
+    logique_prise(state, r2, c2);
+    state->tour++;
+    logique_verifier_conditions_fin(state);
+    return 0;
+}
@@ -0,0 +1,290 @@
+/**
+ * @file journal.c
+ * @brief Journal binaire des parties : écriture en ajout seul et relecture.
+ * @authors Groupe 8
+ *
+ * Les instantanés reprennent le codage des trames STATE de `protocole.h`,
+ * précédé de deux octets d'étiquette. Un coup commence toujours par un
+ * indice de case (< 81), ce qui le distingue des autres enregistrements.
+ */
+
+#include "journal.h"
+#include "geometrie.h"
+#include "protocole.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define JOURNAL_TAG_SNAPSHOT 0xFE /**< Étiquette d'un instantané. */
+#define JOURNAL_TAG_END      0xFF /**< Étiquette de fin de partie, suivie du résultat. */
+#define JOURNAL_STATE_SIZE   (PROTO_HEADER_SIZE + PROTO_STATE_SIZE) /**< Trame STATE d'un instantané. */
+#define JOURNAL_SNAPSHOT_SIZE (2 + JOURNAL_STATE_SIZE + 4) /**< Instantané : étiquette, position, CRC. */
+
+/**
+ * @struct JournalHeader
+ * @brief En-tête d'un journal, couvert par le CRC du premier segment.
+ */
+typedef struct {
+    uint32_t magic;    /**< JOURNAL_MAGIC. */
+    uint16_t version;  /**< JOURNAL_VERSION. */
+    uint16_t interval; /**< JOURNAL_SNAPSHOT_INTERVAL à l'écriture. */
+    uint32_t game_id;  /**< Identifiant de la partie. */
+    uint32_t reserved; /**< Alignement, toujours 0. */
+    int64_t created;   /**< Date de création (secondes Unix). */
+} JournalHeader;
+
+/**
+ * @brief Date courante sur l'horloge monotone.
+ * @return La date en microsecondes.
+ */
+static int64_t journal_now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/**
+ * @brief Poursuit un CRC32 (polynôme réfléchi 0xEDB88320) sur des octets.
+ *
+ * Le calcul bit à bit suffit : un instantané couvre moins d'un kilo-octet.
+ * @param crc Le registre courant (0xFFFFFFFF au départ, à inverser à la fin).
+ * @param p Les octets.
+ * @param n Leur nombre.
+ * @return Le registre mis à jour.
+ */
+static uint32_t crc32_update(uint32_t crc, const uint8_t *p, size_t n) {
+    for (size_t i=0; i<n; i++) {
+        crc ^= p[i];
+        for (int k=0; k<8; k++) crc = (crc >> 1) ^ (0xEDB88320u & -(crc & 1));
+    }
+    return crc;
+}
+
+/**
+ * @brief Écrit tous les octets en attente d'un journal.
+ * @param j Le journal.
+ * @return 0 si succès, -1 en cas d'erreur.
+ */
+static int journal_write_out(Journal *j) {
+    int done = 0;
+    while (done < j->len) {
+        ssize_t n = write(j->fd, j->buf + done, (size_t)(j->len - done));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return -1;
+        done += (int)n;
+    }
+    if (j->len > 0) j->unsynced = true;
+    j->len = 0;
+    return 0;
+}
+
+/**
+ * @brief Ajoute des octets au tampon d'un journal, sans les compter dans le CRC.
+ * @param j Le journal.
+ * @param data Les octets.
+ * @param n Leur nombre (au plus JOURNAL_BUF_SIZE).
+ * @return 0 si succès, -1 si l'écriture du tampon plein a échoué.
+ */
+static int journal_put(Journal *j, const void *data, int n) {
+    if (j->len + n > JOURNAL_BUF_SIZE && journal_write_out(j) < 0) return -1;
+    memcpy(j->buf + j->len, data, (size_t)n);
+    j->len += n;
+    return 0;
+}
+
+/**
+ * @brief Ajoute des octets au tampon d'un journal et au CRC du segment.
+ * @param j Le journal.
+ * @param data Les octets.
+ * @param n Leur nombre.
+ * @return 0 si succès, -1 en cas d'erreur.
+ */
+static int journal_append(Journal *j, const void *data, int n) {
+    if (journal_put(j, data, n) < 0) return -1;
+    j->crc = crc32_update(j->crc, data, (size_t)n);
+    return 0;
+}
+
+/**
+ * @brief Enregistre un instantané de la position et clôt le segment par son CRC.
+ * @param j Le journal.
+ * @param s La position.
+ * @return 0 si succès, -1 en cas d'erreur.
+ */
+static int journal_snapshot(Journal *j, const GameState *s) {
+    uint8_t rec[2 + JOURNAL_STATE_SIZE] = { JOURNAL_TAG_SNAPSHOT, 0 };
+    ProtoMsg st = { .type = PROTO_STATE, .seq = (uint32_t)j->plies, .u.state = *s };
+    if (proto_encode(&st, rec + 2, JOURNAL_STATE_SIZE) != JOURNAL_STATE_SIZE ||
+        journal_append(j, rec, sizeof(rec)) < 0) return -1;
+
+    uint32_t crc = ~j->crc;
+    j->crc = 0xFFFFFFFFu;
+    return journal_put(j, &crc, sizeof(crc));
+}
+
+/**
+ * @see journal.h
+ */
+int journal_open(Journal *j, const char *path, uint32_t game_id, JournalSync sync, int sync_interval_ms) {
+    j->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (j->fd < 0) return -1;
+    j->sync = sync;
+    j->sync_interval_ms = sync_interval_ms;
+    j->last_sync_us = journal_now_us();
+    j->unsynced = false;
+    j->crc = 0xFFFFFFFFu;
+    j->plies = 0;
+    j->len = 0;
+
+    JournalHeader h;
+    memset(&h, 0, sizeof(h));
+    h.magic = JOURNAL_MAGIC;
+    h.version = JOURNAL_VERSION;
+    h.interval = JOURNAL_SNAPSHOT_INTERVAL;
+    h.game_id = game_id;
+    h.created = (int64_t)time(NULL);
+    return journal_append(j, &h, sizeof(h));
+}
+
+/**
+ * @see journal.h
+ */
+int journal_move(Journal *j, const GameState *after, int from, int to) {
+    uint8_t rec[2] = { (uint8_t)from, (uint8_t)to };
+    if (journal_append(j, rec, sizeof(rec)) < 0) return -1;
+    j->plies++;
+    if (j->plies % JOURNAL_SNAPSHOT_INTERVAL == 0) return journal_snapshot(j, after);
+    return 0;
+}
+
+/**
+ * @see journal.h
+ */
+int journal_end(Journal *j, const GameState *final) {
+    uint8_t rec[2] = { JOURNAL_TAG_END, (uint8_t)final->game_over_status };
+    if (journal_append(j, rec, sizeof(rec)) < 0) return -1;
+    return journal_snapshot(j, final);
+}
+
+/**
+ * @see journal.h
+ */
+int journal_flush(Journal *j) {
+    if (journal_write_out(j) < 0) return -1;
+    if (!j->unsynced || j->sync == JOURNAL_SYNC_NEVER) return 0;
+
+    int64_t now = journal_now_us();
+    if (j->sync == JOURNAL_SYNC_INTERVAL && now - j->last_sync_us < (int64_t)j->sync_interval_ms * 1000) return 0;
+    if (fdatasync(j->fd) < 0) return -1;
+    j->last_sync_us = now;
+    j->unsynced = false;
+    return 0;
+}
+
+/**
+ * @see journal.h
+ */
+int journal_close(Journal *j) {
+    int ret = journal_write_out(j);
+    if (ret == 0 && j->unsynced && j->sync != JOURNAL_SYNC_NEVER) ret = fdatasync(j->fd);
+    if (close(j->fd) < 0) ret = -1;
+    j->fd = -1;
+    return ret < 0 ? -1 : 0;
+}
+
+/**
+ * @see journal.h
+ */
+int journal_replay(const char *path, int ply, GameState *out, JournalInfo *info) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return -1;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(JournalHeader)) {
+        close(fd);
+        return -1;
+    }
+    size_t size = (size_t)st.st_size;
+    const uint8_t *data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) return -1;
+
+    JournalHeader h;
+    memcpy(&h, data, sizeof(h));
+    if (h.magic != JOURNAL_MAGIC || h.version != JOURNAL_VERSION) {
+        munmap((void *)data, size);
+        return -1;
+    }
+    int target = ply < 0 ? INT_MAX : ply;
+
+    // Premier passage : vérification des segments et choix de l'instantané de départ.
+    logique_init_game(out);
+    size_t pos = sizeof(h), segment = 0, start = sizeof(h);
+    int plies = 0, start_ply = 0, status = -1;
+    bool truncated = false, corrupted = false;
+    while (pos < size) {
+        uint8_t tag = data[pos];
+        if (tag < NB_CASES || tag == JOURNAL_TAG_END) {
+            if (pos + 2 > size || (tag < NB_CASES && data[pos + 1] >= NB_CASES)) {
+                truncated = true;
+                break;
+            }
+            if (tag == JOURNAL_TAG_END) status = data[pos + 1];
+            else plies++;
+            pos += 2;
+            continue;
+        }
+        if (tag != JOURNAL_TAG_SNAPSHOT || pos + JOURNAL_SNAPSHOT_SIZE > size) {
+            truncated = true;
+            break;
+        }
+
+        size_t crc_pos = pos + JOURNAL_SNAPSHOT_SIZE - 4;
+        uint32_t stored;
+        memcpy(&stored, data + crc_pos, sizeof(stored));
+        ProtoMsg msg;
+        if (~crc32_update(0xFFFFFFFFu, data + segment, crc_pos - segment) != stored ||
+            proto_decode(data + pos + 2, JOURNAL_STATE_SIZE, &msg) != JOURNAL_STATE_SIZE ||
+            msg.type != PROTO_STATE || msg.seq != (uint32_t)plies) {
+            corrupted = true;
+            break;
+        }
+        if (plies <= target) {
+            *out = msg.u.state;
+            start_ply = plies;
+            start = pos + JOURNAL_SNAPSHOT_SIZE;
+        }
+        pos = segment = pos + JOURNAL_SNAPSHOT_SIZE;
+    }
+
+    // Second passage : les coups qui suivent l'instantané, rejoués avec les règles.
+    size_t end = pos;
+    int done = start_ply;
+    for (pos = start; !corrupted && done < target && pos < end; pos += 2) {
+        uint8_t tag = data[pos];
+        if (tag == JOURNAL_TAG_END) continue;
+        if (tag >= NB_CASES) break; // instantané suivant : au-delà de la cible
+        if (logique_jouer_coup(out, tag, data[pos + 1]) < 0) {
+            truncated = true;
+            plies = done;
+            break;
+        }
+        done++;
+    }
+    munmap((void *)data, size);
+    if (corrupted) return -1;
+
+    if (info) {
+        info->game_id = h.game_id;
+        info->created = h.created;
+        info->plies = plies;
+        info->status = status;
+        info->truncated = truncated;
+    }
+    return done;
+}
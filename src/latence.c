@@ -0,0 +1,135 @@
+/**
+ * @file latence.c
+ * @brief Histogrammes de latence log-linéaires.
+ * @authors Groupe 8
+ *
+ * Une valeur v < 2^(LAT_SUB_BITS+1) a son propre intervalle. Au-delà, si
+ * son bit de poids fort est le bit e, l'intervalle est choisi par les
+ * LAT_SUB_BITS bits qui suivent ce bit : les intervalles de [2^e, 2^(e+1))
+ * ont tous une largeur de 2^(e - LAT_SUB_BITS).
+ */
+
+#include "latence.h"
+
+#include <time.h>
+
+/** @brief Un histogramme par étape. */
+static LatencyHistogram stages[LAT_STAGES] = {
+    [0 ... LAT_STAGES - 1] = { .min = UINT64_MAX },
+};
+
+/** @brief Noms des étapes, dans l'ordre de `LatencyStage`. */
+static const char *stage_names[LAT_STAGES] = {
+    "aller-retour", "file", "application", "réflexion IA", "envoi", "réponse",
+};
+
+/**
+ * @brief Intervalle d'une valeur.
+ * @param v La valeur.
+ * @return L'indice de l'intervalle, borné au dernier.
+ */
+static int bucket_of(uint64_t v) {
+    if (v < (1u << (LAT_SUB_BITS + 1))) return (int)v;
+    int msb = 63 - __builtin_clzll(v);
+    if (msb >= LAT_MAX_BITS) return LAT_BUCKETS - 1;
+    int shift = msb - LAT_SUB_BITS;
+    return ((shift + 1) << LAT_SUB_BITS) + (int)(v >> shift) - (1 << LAT_SUB_BITS);
+}
+
+/**
+ * @brief Plus grande valeur d'un intervalle.
+ * @param i L'indice de l'intervalle.
+ * @return La borne supérieure (incluse).
+ */
+static uint64_t bucket_upper(int i) {
+    int shift = (i >> LAT_SUB_BITS) - 1;
+    if (shift <= 0) return (uint64_t)i;
+    uint64_t mantissa = (uint64_t)(i & ((1 << LAT_SUB_BITS) - 1)) + (1u << LAT_SUB_BITS);
+    return ((mantissa + 1) << shift) - 1;
+}
+
+/**
+ * @see latence.h
+ */
+void lat_hist_reset(LatencyHistogram *h) {
+    for (int i=0; i<LAT_BUCKETS; i++) atomic_store_explicit(&h->counts[i], 0, memory_order_relaxed);
+    atomic_store(&h->total, 0);
+    atomic_store(&h->sum, 0);
+    atomic_store(&h->min, UINT64_MAX);
+    atomic_store(&h->max, 0);
+}
+
+/**
+ * @see latence.h
+ */
+void lat_hist_record(LatencyHistogram *h, int64_t us) {
+    uint64_t v = us > 0 ? (uint64_t)us : 0;
+    atomic_fetch_add_explicit(&h->counts[bucket_of(v)], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&h->total, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&h->sum, v, memory_order_relaxed);
+
+    uint64_t cur = atomic_load_explicit(&h->min, memory_order_relaxed);
+    while (v < cur && !atomic_compare_exchange_weak(&h->min, &cur, v)) {}
+    cur = atomic_load_explicit(&h->max, memory_order_relaxed);
+    while (v > cur && !atomic_compare_exchange_weak(&h->max, &cur, v)) {}
+}
+
+/**
+ * @see latence.h
+ */
+uint64_t lat_hist_percentile(const LatencyHistogram *h, double pct) {
+    uint64_t total = atomic_load(&h->total);
+    if (total == 0) return 0;
+
+    uint64_t rank = (uint64_t)(pct / 100.0 * (double)total + 0.5);
+    if (rank < 1) rank = 1;
+    if (rank > total) rank = total;
+
+    uint64_t seen = 0, max = atomic_load(&h->max);
+    for (int i=0; i<LAT_BUCKETS; i++) {
+        seen += atomic_load_explicit(&h->counts[i], memory_order_relaxed);
+        if (seen >= rank) {
+            uint64_t upper = bucket_upper(i);
+            return upper < max ? upper : max;
+        }
+    }
+    return max;
+}
+
+/**
+ * @see latence.h
+ */
+int64_t latency_now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/**
+ * @see latence.h
+ */
+void latency_record(LatencyStage stage, int64_t us) {
+    if (stage >= 0 && stage < LAT_STAGES) lat_hist_record(&stages[stage], us);
+}
+
+/**
+ * @see latence.h
+ */
+void latency_dump(FILE *out) {
+    fprintf(out, "%-14s %8s %9s %9s %9s %9s %9s %9s\n",
+            "Latences (µs)", "n", "moyenne", "p50", "p90", "p99", "p99.9", "max");
+    for (int s=0; s<LAT_STAGES; s++) {
+        const LatencyHistogram *h = &stages[s];
+        uint64_t n = atomic_load(&h->total);
+        if (n == 0) continue;
+        fprintf(out, "%-14s %8llu %9llu %9llu %9llu %9llu %9llu %9llu\n", stage_names[s],
+                (unsigned long long)n,
+                (unsigned long long)(atomic_load(&h->sum) / n),
+                (unsigned long long)lat_hist_percentile(h, 50),
+                (unsigned long long)lat_hist_percentile(h, 90),
+                (unsigned long long)lat_hist_percentile(h, 99),
+                (unsigned long long)lat_hist_percentile(h, 99.9),
+                (unsigned long long)atomic_load(&h->max));
+    }
+    fflush(out);
+}
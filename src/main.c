@@ -13,13 +13,13 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
-#include <pthread.h>
 #include "ia.h"
 
 #include "config.h"
 #include "plateau.h"
 #include "reseau.h"
 #include "reseau_integration.h"
+#include "jeu.h"
 
 
 /**
@@ -82,6 +82,11 @@ static void activate(GtkApplication *app, gpointer user_data)
 
     GtkWidget *grid = gtk_grid_new();
     init_plateau(grid);
+    if (config.mode != LOCAL)
+    {
+        ia_history_clear(); // l'IA mémorise les positions pour éviter les répétitions
+        ia_note_position();
+    }
     GtkWidget *grid_box = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 0);
     gtk_widget_set_halign(grid_box, GTK_ALIGN_CENTER);
     gtk_widget_set_valign(grid_box, GTK_ALIGN_CENTER);
@@ -102,20 +107,6 @@ static void activate(GtkApplication *app, gpointer user_data)
 }
 
 
-/**
- * @brief network_thread_func est exécutée par le processus d'écoute réseau.
- *
- * Elle lance une boucle infinie pour recevoir les mouvements
- * de l'adversaire sur le réseau.
- * @param arg Arguments pour le processus.
- * @return NULL.
- */
-static void *network_thread_func(void *arg)
-{
-    (void)arg;
-    network_listen_loop(); // boucle de réception réseau
-    return NULL;
-}
 
 /**
  * Affiche comment utiliser le programme en cas d'arguments incorrects.
@@ -130,7 +121,103 @@ static void print_usage()
     fprintf(stderr, "      -ia : L'IA jouera pour le serveur.\n\n");
     fprintf(stderr, "  ./game -c [-ia] <adresse:port>\n");
     fprintf(stderr, "      Se connecter à un serveur à <adresse:port>.\n");
-    fprintf(stderr, "      -ia : L'IA jouera pour le client.\n");
+    fprintf(stderr, "      -ia : L'IA jouera pour le client.\n\n");
+    fprintf(stderr, "  Option : -tt <fichier>\n");
+    fprintf(stderr, "      Avec -ia, charge la table de transposition au démarrage\n");
+    fprintf(stderr, "      et la sauvegarde en fin de partie.\n");
+    fprintf(stderr, "  Option : -temps <secondes>[+<incrément>]\n");
+    fprintf(stderr, "      Avec -ia, joue à la pendule : temps total de l'IA pour la partie,\n");
+    fprintf(stderr, "      et secondes ajoutées après chacun de ses coups.\n");
+    fprintf(stderr, "  Option : -journal <fichier>\n");
+    fprintf(stderr, "      Avec -s ou -c, enregistre les coups de la partie (relecture : ./journal).\n");
+}
+
+/**
+ * @brief Retire une option "<nom> <fichier>" des arguments et mémorise le fichier.
+ * @param argc Pointeur vers le nombre d'arguments (mis à jour).
+ * @param argv Tableau des arguments (modifié sur place).
+ * @param name Le nom de l'option (ex: "-tt").
+ * @param path Le tampon recevant le fichier.
+ * @param size La taille du tampon.
+ * @return 0 si succès, -1 si l'option est incomplète.
+ */
+static int extract_path_option(int *argc, char **argv, const char *name, char *path, size_t size)
+{
+    for (int i = 1; i < *argc; i++)
+    {
+        if (strcmp(argv[i], name) != 0)
+        {
+            continue;
+        }
+        if (i + 1 >= *argc)
+        {
+            return -1;
+        }
+        strncpy(path, argv[i + 1], size - 1);
+        path[size - 1] = '\0';
+        for (int j = i; j + 2 < *argc; j++)
+        {
+            argv[j] = argv[j + 2];
+        }
+        *argc -= 2;
+        return 0;
+    }
+    return 0;
+}
+
+/**
+ * @brief Retire l'option "-temps <secondes>[+<incrément>]" des arguments et règle la pendule de l'IA.
+ * @param argc Pointeur vers le nombre d'arguments (mis à jour).
+ * @param argv Tableau des arguments (modifié sur place).
+ * @return 0 si succès, -1 si l'option est incomplète ou invalide.
+ */
+static int extract_clock_option(int *argc, char **argv)
+{
+    char value[32] = "";
+    if (extract_path_option(argc, argv, "-temps", value, sizeof(value)) < 0)
+    {
+        return -1;
+    }
+    if (!value[0])
+    {
+        return 0;
+    }
+
+    char *end;
+    double total = strtod(value, &end);
+    double increment = 0;
+    if (*end == '+')
+    {
+        increment = strtod(end + 1, &end);
+    }
+    if (*end != '\0' || total <= 0 || increment < 0 || total > 86400 || increment > 3600)
+    {
+        fprintf(stderr, "Erreur: Temps invalide. Attendu: <secondes>[+<incrément>]\n");
+        return -1;
+    }
+    config.clock_ms = (int)(total * 1000);
+    config.increment_ms = (int)(increment * 1000);
+    return 0;
+}
+
+/**
+ * @brief Charge la table de transposition de l'IA si un fichier est configuré.
+ */
+static void load_tt_if_configured()
+{
+    if (!config.ai || !config.tt_path[0])
+    {
+        return;
+    }
+    int n = ia_tt_load(config.tt_path);
+    if (n < 0)
+    {
+        printf("Pas de TT utilisable dans %s, démarrage à froid.\n", config.tt_path);
+    }
+    else
+    {
+        printf("TT chargée : %d entrées depuis %s\n", n, config.tt_path);
+    }
 }
 
 /**
@@ -145,18 +232,31 @@ static void start_server_game()
            config.port, config.ai ? "Oui" : "Non");
 
     printf("%s\n", "En attente de client...");
+    load_tt_if_configured();
     int sock = net_wait_for_client();
     printf("%s\n", "client connecté");
     network_init(sock, 1); // 1 = serveur (rouge)
+    if (network_handshake() < 0)
+    {
+        network_stop();
+        return;
+    }
 
     GtkApplication *app = gtk_application_new("org.example.krojanty.serv", G_APPLICATION_DEFAULT_FLAGS);
     g_signal_connect(app, "activate", G_CALLBACK(activate), NULL);
 
-    pthread_t net_thread;
-    pthread_create(&net_thread, NULL, network_thread_func, NULL);
-    pthread_detach(net_thread);
+    if (network_start() < 0)
+    {
+        fprintf(stderr, "Erreur : impossible de lancer la boucle réseau\n");
+    }
 
     int status = g_application_run(G_APPLICATION(app), 0, NULL);
+    network_stop();     // fenêtre fermée : arrêt du thread réseau
+    ia_cancel_search(); // et de la recherche éventuelle
+    if (!game_over)
+    {
+        ia_persist_tt(); // partie abandonnée : la TT est tout de même conservée
+    }
     g_object_unref(app);
     (void)status;
     return;
@@ -185,23 +285,37 @@ static void start_client_game()
     printf("Lancement du CLIENT vers %s:%d. IA active: %s\n",
            config.address, config.port, config.ai ? "Oui" : "Non");
 
+    load_tt_if_configured();
     int sock = net_connect_to_server();
     printf("%s\n", "connexion reussie");
-    network_init(sock, 0); // 0 = client (bleu)
+    network_init(sock, 0); // couleur attribuée par le serveur lors de la poignée de main
+    if (network_handshake() < 0)
+    {
+        network_stop();
+        return;
+    }
+    printf("Vous jouez les %s\n", network_plays_blue() ? "bleus" : "rouges");
 
     GtkApplication *app = gtk_application_new("org.example.krojanty.cli", G_APPLICATION_DEFAULT_FLAGS);
     g_signal_connect(app, "activate", G_CALLBACK(activate), NULL);
 
-    pthread_t net_thread;
-    pthread_create(&net_thread, NULL, network_thread_func, NULL);
-    pthread_detach(net_thread);
+    if (network_start() < 0)
+    {
+        fprintf(stderr, "Erreur : impossible de lancer la boucle réseau\n");
+    }
 
-    if (config.ai)
+    if (config.ai && network_plays_blue())
     {
         g_timeout_add_seconds(2, ia_blue_timeout, NULL);
     }
 
     int status = g_application_run(G_APPLICATION(app), 0, NULL);
+    network_stop();     // fenêtre fermée : arrêt du thread réseau
+    ia_cancel_search(); // et de la recherche éventuelle
+    if (!game_over)
+    {
+        ia_persist_tt(); // partie abandonnée : la TT est tout de même conservée
+    }
     g_object_unref(app);
     (void)status;
 
@@ -215,6 +329,14 @@ int main(int argc, char **argv)
 {
     config.mode = ERROR;
 
+    if (extract_path_option(&argc, argv, "-tt", config.tt_path, sizeof(config.tt_path)) < 0 ||
+        extract_path_option(&argc, argv, "-journal", config.journal_path, sizeof(config.journal_path)) < 0 ||
+        extract_clock_option(&argc, argv) < 0)
+    {
+        print_usage();
+        return 1;
+    }
+
     // vérification des arguments
     if (argc < 2)
     {
@@ -0,0 +1,256 @@
+/**
+ * @file protocole.c
+ * @brief Codage et décodage des trames du protocole réseau.
+ * @authors Groupe 8
+ *
+ * Tous les entiers sont écrits en gros-boutiste, octet par octet, pour ne
+ * dépendre ni de l'alignement ni de l'architecture.
+ */
+
+#include "protocole.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+/**
+ * @brief Écrit un entier de 16 bits en gros-boutiste.
+ * @param p La destination.
+ * @param v La valeur.
+ */
+static void put16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)(v >> 8);
+    p[1] = (uint8_t)v;
+}
+
+/**
+ * @brief Écrit un entier de 32 bits en gros-boutiste.
+ * @param p La destination.
+ * @param v La valeur.
+ */
+static void put32(uint8_t *p, uint32_t v) {
+    put16(p, (uint16_t)(v >> 16));
+    put16(p + 2, (uint16_t)v);
+}
+
+/**
+ * @brief Lit un entier de 16 bits en gros-boutiste.
+ * @param p La source.
+ * @return La valeur.
+ */
+static uint16_t get16(const uint8_t *p) {
+    return (uint16_t)(p[0] << 8 | p[1]);
+}
+
+/**
+ * @brief Lit un entier de 32 bits en gros-boutiste.
+ * @param p La source.
+ * @return La valeur.
+ */
+static uint32_t get32(const uint8_t *p) {
+    return (uint32_t)get16(p) << 16 | get16(p + 2);
+}
+
+/**
+ * @brief Taille du contenu attendue pour un type de trame.
+ * @param type Le type.
+ * @return La taille, ou -1 si le type est inconnu.
+ */
+static int payload_size(uint8_t type) {
+    switch (type) {
+        case PROTO_HELLO:  return 4;
+        case PROTO_MOVE:   return 2;
+        case PROTO_RESIGN: return 0;
+        case PROTO_CLOCK:  return 8;
+        case PROTO_PING:
+        case PROTO_PONG:   return 8;
+        case PROTO_STATE:  return PROTO_STATE_SIZE;
+        case PROTO_ERROR:  return 1;
+        case PROTO_WATCH:  return 4;
+        case PROTO_SESSION: return 12;
+        case PROTO_RESUME: return 16;
+        default:           return -1;
+    }
+}
+
+/**
+ * @see protocole.h
+ */
+int proto_encode(const ProtoMsg *m, uint8_t *out, int cap) {
+    int size = payload_size(m->type);
+    if (size < 0 || PROTO_HEADER_SIZE + size > cap) return -1;
+
+    uint8_t *p = out + PROTO_HEADER_SIZE;
+    switch (m->type) {
+        case PROTO_HELLO:
+            put16(p, PROTO_MAGIC);
+            p[2] = m->u.hello.version;
+            p[3] = m->u.hello.role;
+            break;
+        case PROTO_MOVE:
+            if (m->u.move.from >= SIZE * SIZE || m->u.move.to >= SIZE * SIZE) return -1;
+            p[0] = m->u.move.from;
+            p[1] = m->u.move.to;
+            break;
+        case PROTO_CLOCK:
+            put32(p, m->u.clock.blue_ms);
+            put32(p + 4, m->u.clock.red_ms);
+            break;
+        case PROTO_PING:
+        case PROTO_PONG:
+            put32(p, (uint32_t)(m->u.ping >> 32));
+            put32(p + 4, (uint32_t)m->u.ping);
+            break;
+        case PROTO_STATE: {
+            const GameState *s = &m->u.state;
+            memcpy(p, s->pion, SIZE * SIZE);
+            memcpy(p + SIZE * SIZE, s->couleur, SIZE * SIZE);
+            p += 2 * SIZE * SIZE;
+            p[0] = (uint8_t)s->dead_red_count;
+            p[1] = (uint8_t)s->dead_blue_count;
+            p[2] = (uint8_t)s->tour;
+            p[3] = (uint8_t)s->game_over_status;
+            break;
+        }
+        case PROTO_ERROR:
+            p[0] = m->u.error;
+            break;
+        case PROTO_WATCH:
+            put32(p, m->u.game);
+            break;
+        case PROTO_RESUME:
+            put32(p + 12, m->u.session.plies);
+            // fall through
+        case PROTO_SESSION:
+            put32(p, m->u.session.game);
+            put32(p + 4, (uint32_t)(m->u.session.token >> 32));
+            put32(p + 8, (uint32_t)m->u.session.token);
+            break;
+        default:
+            break;
+    }
+
+    put16(out, (uint16_t)size);
+    out[2] = m->type;
+    out[3] = m->flags;
+    put32(out + 4, m->seq);
+    return PROTO_HEADER_SIZE + size;
+}
+
+/**
+ * @see protocole.h
+ */
+int proto_decode(const uint8_t *in, int len, ProtoMsg *m) {
+    if (len < PROTO_HEADER_SIZE) return 0;
+    int size = get16(in);
+    if (size > PROTO_MAX_PAYLOAD || size != payload_size(in[2])) return -1;
+    if (len < PROTO_HEADER_SIZE + size) return 0;
+
+    const uint8_t *p = in + PROTO_HEADER_SIZE;
+    m->type = in[2];
+    m->flags = in[3];
+    m->seq = get32(in + 4);
+    switch (m->type) {
+        case PROTO_HELLO:
+            if (get16(p) != PROTO_MAGIC) return -1;
+            m->u.hello.version = p[2];
+            m->u.hello.role = p[3];
+            break;
+        case PROTO_MOVE:
+            if (p[0] >= SIZE * SIZE || p[1] >= SIZE * SIZE) return -1;
+            m->u.move.from = p[0];
+            m->u.move.to = p[1];
+            break;
+        case PROTO_CLOCK:
+            m->u.clock.blue_ms = get32(p);
+            m->u.clock.red_ms = get32(p + 4);
+            break;
+        case PROTO_PING:
+        case PROTO_PONG:
+            m->u.ping = (uint64_t)get32(p) << 32 | get32(p + 4);
+            break;
+        case PROTO_STATE: {
+            GameState *s = &m->u.state;
+            memcpy(s->pion, p, SIZE * SIZE);
+            memcpy(s->couleur, p + SIZE * SIZE, SIZE * SIZE);
+            p += 2 * SIZE * SIZE;
+            s->dead_red_count = p[0];
+            s->dead_blue_count = p[1];
+            s->tour = p[2];
+            s->game_over_status = p[3];
+            break;
+        }
+        case PROTO_ERROR:
+            m->u.error = p[0];
+            break;
+        case PROTO_WATCH:
+            m->u.game = get32(p);
+            break;
+        case PROTO_SESSION:
+        case PROTO_RESUME:
+            m->u.session.game = get32(p);
+            m->u.session.token = (uint64_t)get32(p + 4) << 32 | get32(p + 8);
+            m->u.session.plies = m->type == PROTO_RESUME ? get32(p + 12) : 0;
+            break;
+        default:
+            break;
+    }
+    return PROTO_HEADER_SIZE + size;
+}
+
+/**
+ * @see protocole.h
+ */
+void proto_reader_init(ProtoReader *r) {
+    r->len = 0;
+    r->next_seq = 0;
+}
+
+/**
+ * @see protocole.h
+ */
+int proto_reader_next(ProtoReader *r, ProtoMsg *m) {
+    int n = proto_decode(r->buf, r->len, m);
+    if (n < 0) return -PROTO_ERR_MALFORMED;
+    if (n == 0) return 0;
+    bool resync = m->type == PROTO_STATE && (m->flags & PROTO_FLAG_BROADCAST);
+    if (!resync && m->seq != r->next_seq) return -PROTO_ERR_SEQUENCE;
+    if (resync) r->next_seq = m->seq;
+
+    r->next_seq++;
+    r->len -= n;
+    memmove(r->buf, r->buf + n, r->len);
+    return 1;
+}
+
+/**
+ * @see protocole.h
+ */
+void proto_writer_init(ProtoWriter *w) {
+    w->len = 0;
+    w->next_seq = 0;
+}
+
+/**
+ * @see protocole.h
+ */
+int proto_writer_push(ProtoWriter *w, const ProtoMsg *m) {
+    ProtoMsg framed = *m;
+    framed.seq = w->next_seq;
+    int n = proto_encode(&framed, w->buf + w->len, PROTO_BUF_SIZE - w->len);
+    if (n < 0) return -1;
+    w->len += n;
+    w->next_seq++;
+    return 0;
+}
+
+/**
+ * @see protocole.h
+ */
+void proto_writer_consume(ProtoWriter *w, int n) {
+    if (n >= w->len) {
+        w->len = 0;
+        return;
+    }
+    w->len -= n;
+    memmove(w->buf, w->buf + n, w->len);
+}
@@ -12,11 +12,16 @@
 #include "reseau.h"
 #include "config.h"
 
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
 #include <string.h>
 #include <unistd.h>
 #include <arpa/inet.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 
 /**
  * @see reseau.h
@@ -95,22 +100,166 @@ int net_connect_to_server()
 /**
  * @see reseau.h
  */
-int net_send_move(int sock, const char *move)
+int net_connect_timeout(int timeout_ms)
 {
-    int len = strlen(move);
-    if (len != 4)
+    struct sockaddr_in serv_addr;
+    memset(&serv_addr, 0, sizeof(serv_addr));
+    serv_addr.sin_family = AF_INET;
+    serv_addr.sin_port = htons(config.port);
+    if (inet_pton(AF_INET, config.address, &serv_addr.sin_addr) <= 0)
+        return -1;
+
+    int sock = socket(AF_INET, SOCK_STREAM, 0);
+    if (sock < 0)
+        return -1;
+    if (net_set_nonblocking(sock) < 0)
+    {
+        close(sock);
+        return -1;
+    }
+    if (connect(sock, (struct sockaddr *)&serv_addr, sizeof(serv_addr)) < 0)
+    {
+        // Connexion en cours : le socket devient inscriptible une fois établie (ou refusée).
+        struct pollfd pfd = { .fd = sock, .events = POLLOUT };
+        int err = 0;
+        socklen_t len = sizeof(err);
+        if (errno != EINPROGRESS || poll(&pfd, 1, timeout_ms) <= 0 ||
+            getsockopt(sock, SOL_SOCKET, SO_ERROR, &err, &len) < 0 || err != 0)
+        {
+            close(sock);
+            return -1;
+        }
+    }
+    return sock;
+}
+
+/**
+ * @see reseau.h
+ */
+int net_set_nonblocking(int sock)
+{
+    int flags = fcntl(sock, F_GETFL, 0);
+    if (flags < 0 || fcntl(sock, F_SETFL, flags | O_NONBLOCK) < 0)
         return -1;
-    return send(sock, move, 4, 0);
+    return 0;
+}
+
+/**
+ * @see reseau.h
+ */
+int net_tune_socket(int sock, char *report, int len)
+{
+    int on = 1;
+    int r = 0;
+    if (setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on)) < 0)
+        r = -1;
+    if (setsockopt(sock, SOL_SOCKET, SO_KEEPALIVE, &on, sizeof(on)) < 0)
+        r = -1;
+
+    int nodelay = 0, keepalive = 0, sndbuf = 0, rcvbuf = 0;
+    socklen_t sz = sizeof(int);
+    getsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &nodelay, &sz);
+    sz = sizeof(int);
+    getsockopt(sock, SOL_SOCKET, SO_KEEPALIVE, &keepalive, &sz);
+    sz = sizeof(int);
+    getsockopt(sock, SOL_SOCKET, SO_SNDBUF, &sndbuf, &sz);
+    sz = sizeof(int);
+    getsockopt(sock, SOL_SOCKET, SO_RCVBUF, &rcvbuf, &sz);
+    snprintf(report, len, "TCP_NODELAY=%d SO_KEEPALIVE=%d SO_SNDBUF=%d SO_RCVBUF=%d",
+             nodelay != 0, keepalive != 0, sndbuf, rcvbuf);
+    return r;
 }
 
 /**
  * @see reseau.h
  */
-int net_recv_move(int sock, char *buffer)
+int net_send_all(int sock, const void *data, int len)
 {
-    int n = recv(sock, buffer, 4, MSG_WAITALL);
-    if (n <= 0)
+    const char *p = data;
+    int sent = 0;
+    while (sent < len)
+    {
+        ssize_t n = send(sock, p + sent, len - sent, MSG_NOSIGNAL);
+        if (n > 0)
+        {
+            sent += (int)n;
+            continue;
+        }
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        {
+            struct pollfd pfd = { .fd = sock, .events = POLLOUT };
+            if (poll(&pfd, 1, NET_SEND_TIMEOUT_MS) > 0)
+                continue;
+        }
         return -1;
-    buffer[4] = '\0';
+    }
     return 0;
 }
+
+/**
+ * @see reseau.h
+ */
+int net_send_available(int sock, const void *data, int len)
+{
+    for (;;)
+    {
+        ssize_t n = send(sock, data, len, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (n >= 0)
+            return (int)n;
+        if (errno == EINTR)
+            continue;
+        if (errno == EAGAIN || errno == EWOULDBLOCK)
+            return 0;
+        return -1;
+    }
+}
+
+/**
+ * @see reseau.h
+ */
+int net_recv_frame(int sock, ProtoReader *r, ProtoMsg *m, int timeout_ms)
+{
+    for (;;)
+    {
+        int got = proto_reader_next(r, m);
+        if (got > 0)
+            return 0;
+        if (got < 0)
+            return -1;
+
+        struct pollfd pfd = { .fd = sock, .events = POLLIN };
+        int ready = poll(&pfd, 1, timeout_ms);
+        if (ready < 0 && errno == EINTR)
+            continue;
+        if (ready <= 0)
+            return -1;
+        ssize_t n = recv(sock, r->buf + r->len, PROTO_BUF_SIZE - r->len, 0);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return -1;
+        r->len += (int)n;
+    }
+}
+
+/**
+ * @see reseau.h
+ */
+int net_recv_available(int sock, char *buffer, int len)
+{
+    for (;;)
+    {
+        ssize_t n = recv(sock, buffer, len, 0);
+        if (n > 0)
+            return (int)n;
+        if (n == 0)
+            return -1; // fermeture par le pair
+        if (errno == EINTR)
+            continue;
+        if (errno == EAGAIN || errno == EWOULDBLOCK)
+            return 0;
+        return -1;
+    }
+}
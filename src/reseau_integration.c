@@ -5,8 +5,32 @@
  *
  * Il fait le lien entre les données brutes reçues du réseau et leur
  * application concrète sur le plateau de jeu. Il gère la boucle d'écoute
- * réseau dans un processus séparé et assure que les mouvements reçus sont
- * appliqués de manière sûre à l'interface GTK via `g_idle_add`.
+ * réseau (epoll, socket non bloquant) dans un thread séparé et assure que
+ * les mouvements reçus sont appliqués de manière sûre à l'interface GTK :
+ * le thread réseau les dépose dans une file sans verrou (`file_coups.h`)
+ * et réveille, par un eventfd, une source GTK unique qui vide la file dans
+ * l'ordre d'arrivée. La perte de la connexion passe par le même canal et
+ * n'est donc traitée qu'après les coups déjà reçus.
+ *
+ * La boucle réseau reste dans son propre thread plutôt que dans une source
+ * GLib : une reprise après coupure s'y déroule (connexions et attentes
+ * successives) sans figer l'interface, et les réponses aux PING ne sont
+ * pas retardées par un dessin ou un coup de l'IA appliqué dans la boucle
+ * GTK, ce qui fausserait l'aller-retour mesuré.
+ *
+ * Les échanges suivent le protocole de `protocole.h`. Le thread de
+ * l'interface et le thread réseau écrivent tous deux sur le socket (coups
+ * joués, réponses aux PING) : l'écrivain de la connexion est protégé par
+ * un mutex, et les trames produites par un même lot de réception partent
+ * en un seul envoi. Aucun envoi n'attend : ce que le socket n'accepte pas
+ * tout de suite reste dans l'écrivain, et la boucle réseau l'envoie quand
+ * epoll signale le socket inscriptible (EPOLLOUT).
+ *
+ * Face à un serveur de parties, qui envoie une trame SESSION après HELLO,
+ * une connexion coupée n'arrête pas la partie : le thread réseau se
+ * reconnecte et envoie RESUME. Les coups manqués passent par la file comme
+ * les autres, suivis d'un marqueur qui fait appliquer la position du
+ * serveur par l'interface.
  */
 
 #include "reseau.h"
@@ -15,16 +39,57 @@
 #include "jeu.h"
 #include "ia.h"
 #include "config.h"
+#include "geometrie.h"
+#include "protocole.h"
+#include "file_coups.h"
+#include "latence.h"
+#include "journal.h"
+#include <glib-unix.h>
+#include <signal.h>
 #include <string.h>
 #include <stdio.h>
-#include <ctype.h>
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 
 // Variables globales pour gérer l'état réseau
 int net_socket = -1; /**< Socket utilisé pour la communication. */
 int is_network = 0;  /**< 1 si la partie est en réseau, 0 sinon. */
-int is_server = 0;   /**< 1 si le joueur est le serveur (rouge), 0 si client (bleu). */
+int is_server = 0;   /**< 1 si le joueur local joue les rouges, 0 s'il joue les bleus. */
 extern int tour;
 
+static int net_epoll_fd = -1;           /**< Instance epoll de la boucle réseau. */
+static int net_wakeup_fd = -1;          /**< eventfd réveillant la boucle pour l'arrêter. */
+static pthread_t net_thread;            /**< Thread de la boucle réseau. */
+static bool net_thread_running = false; /**< true tant que `net_thread` n'a pas été rejoint. */
+
+static ProtoReader net_reader;          /**< Trames reçues, lues par un seul thread à la fois. */
+static ProtoWriter net_writer;          /**< Trames à envoyer. */
+static pthread_mutex_t net_write_lock = PTHREAD_MUTEX_INITIALIZER; /**< Protège `net_writer`, `net_want_write` et les envois. */
+static bool net_want_write = false;     /**< true si epoll surveille EPOLLOUT (trames en attente d'un socket plein). */
+
+static MoveQueue net_moves;             /**< Coups reçus, pas encore appliqués à l'interface. */
+static int net_ui_fd = -1;              /**< eventfd réveillant la source GTK qui vide `net_moves`. */
+static guint net_ui_source = 0;         /**< Source GTK surveillant `net_ui_fd`. */
+static _Atomic(const char *) net_lost_reason = NULL; /**< Message de fin si la connexion est perdue. */
+static guint net_ping_source = 0;       /**< Minuterie des PING. */
+static guint net_dump_source = 0;       /**< Source GTK du signal SIGUSR1 (affichage des latences). */
+static int64_t net_last_received_us = 0; /**< Réception du dernier coup adverse appliqué (0 : déjà répondu). */
+static GameState net_state;             /**< Arbitre : la partie rejouée par les règles, sans interface. */
+static Journal net_journal;             /**< Journal de la partie, si `config.journal_path` est renseigné. */
+static bool net_journaled = false;      /**< true tant que `net_journal` est ouvert. */
+
+static uint32_t net_session_game = 0;   /**< Partie attribuée par le serveur (thread réseau). */
+static uint64_t net_session_token = 0;  /**< Jeton de reprise, 0 sans trame SESSION (thread réseau). */
+static _Atomic uint32_t net_plies = 0;  /**< Coups connus du client : envoyés et reçus. */
+static atomic_bool net_finished = false; /**< true quand l'arbitre a constaté la fin de la partie. */
+static atomic_bool net_resync_pending = false; /**< true de la reprise jusqu'à l'application de `net_resync_state`. */
+static GameState net_resync_state;      /**< Position envoyée par le serveur lors de la dernière reprise. */
+
 /**
  * @see reseau_integration.h
  */
@@ -33,6 +98,192 @@ void network_init(int sock, int server_mode)
     net_socket = sock;
     is_network = 1;
     is_server = server_mode;
+    proto_reader_init(&net_reader);
+    proto_writer_init(&net_writer);
+    logique_init_game(&net_state);
+    net_session_token = 0;
+    atomic_store(&net_plies, 0);
+    atomic_store(&net_finished, false);
+    atomic_store(&net_resync_pending, false);
+
+    if (config.journal_path[0])
+    {
+        net_journaled = journal_open(&net_journal, config.journal_path, 0, JOURNAL_SYNC_ALWAYS, 0) == 0;
+        if (!net_journaled)
+            fprintf(stderr, "Attention : journal %s impossible à créer\n", config.journal_path);
+    }
+
+    if (sock >= 0)
+    {
+        char report[128];
+        if (net_tune_socket(sock, report, sizeof(report)) < 0)
+            fprintf(stderr, "Attention : options du socket non appliquées\n");
+        printf("Socket : %s\n", report);
+    }
+}
+
+/**
+ * @brief Enregistre un coup accepté par l'arbitre : fin de partie éventuelle et journal.
+ *
+ * Le journal est écrit et synchronisé avant que le coup ne soit envoyé ou
+ * affiché. En cas d'erreur, il est fermé et la partie continue sans lui.
+ * @param from La case de départ.
+ * @param to La case d'arrivée.
+ */
+static void network_record_move(int from, int to)
+{
+    if (net_state.game_over_status != 0)
+        atomic_store(&net_finished, true); // plus de reprise possible
+    if (!net_journaled)
+        return;
+    if (journal_move(&net_journal, &net_state, from, to) < 0 || journal_flush(&net_journal) < 0)
+    {
+        fprintf(stderr, "Attention : écriture du journal %s impossible, journal arrêté\n", config.journal_path);
+        journal_close(&net_journal);
+        net_journaled = false;
+    }
+}
+
+/**
+ * @brief Ajoute une trame à l'écrivain de la connexion, sans l'envoyer.
+ * @param m La trame.
+ * @return 0 si succès, -1 si l'écrivain est plein.
+ */
+static int network_queue(const ProtoMsg *m)
+{
+    pthread_mutex_lock(&net_write_lock);
+    int r = proto_writer_push(&net_writer, m);
+    pthread_mutex_unlock(&net_write_lock);
+    return r;
+}
+
+/**
+ * @brief Envoie les trames en attente, `net_write_lock` étant pris.
+ *
+ * Une fois la boucle réseau lancée, l'envoi n'attend jamais : le reste est
+ * gardé dans l'écrivain et EPOLLOUT est surveillé jusqu'à ce qu'il parte.
+ * Avant (poignée de main) et après elle, l'envoi est bloquant.
+ * @return 0 si succès, -1 en cas d'erreur d'envoi.
+ */
+static int network_flush_locked(void)
+{
+    if (net_writer.len == 0)
+        return 0;
+    if (net_epoll_fd < 0)
+    {
+        int r = net_send_all(net_socket, net_writer.buf, net_writer.len);
+        net_writer.len = 0; // en cas d'erreur, la connexion est de toute façon perdue
+        return r;
+    }
+
+    int n = net_send_available(net_socket, net_writer.buf, net_writer.len);
+    if (n < 0)
+    {
+        net_writer.len = 0;
+        return -1;
+    }
+    proto_writer_consume(&net_writer, n);
+    bool want = net_writer.len > 0;
+    if (want != net_want_write)
+    {
+        struct epoll_event ev = { .events = EPOLLIN | EPOLLRDHUP | (want ? EPOLLOUT : 0), .data.fd = net_socket };
+        if (epoll_ctl(net_epoll_fd, EPOLL_CTL_MOD, net_socket, &ev) < 0)
+            return -1;
+        net_want_write = want;
+    }
+    return 0;
+}
+
+/**
+ * @brief Envoie en une fois toutes les trames en attente.
+ * @return 0 si succès, -1 en cas d'erreur d'envoi.
+ */
+static int network_flush(void)
+{
+    pthread_mutex_lock(&net_write_lock);
+    int r = network_flush_locked();
+    pthread_mutex_unlock(&net_write_lock);
+    return r;
+}
+
+/**
+ * @brief Envoie un coup du joueur local et le compte parmi les coups connus.
+ *
+ * Le coup n'est pas envoyé si une reprise vient de remplacer la connexion :
+ * la position du serveur, pas encore appliquée, ne le contient pas.
+ * @param m La trame MOVE.
+ * @return 0 si succès, -1 si le coup n'a pas pu être envoyé.
+ */
+static int network_send_move(const ProtoMsg *m)
+{
+    pthread_mutex_lock(&net_write_lock);
+    int r = -1;
+    if (net_socket >= 0 && !atomic_load(&net_resync_pending) && proto_writer_push(&net_writer, m) == 0)
+    {
+        atomic_fetch_add(&net_plies, 1);
+        r = network_flush_locked();
+    }
+    pthread_mutex_unlock(&net_write_lock);
+    return r;
+}
+
+/**
+ * @see reseau_integration.h
+ */
+int network_handshake(void)
+{
+    ProtoMsg hello = { .type = PROTO_HELLO, .u.hello = { PROTO_VERSION, PROTO_ROLE_ANY } };
+    ProtoMsg reply;
+
+    if (is_server)
+    {
+        if (net_recv_frame(net_socket, &net_reader, &reply, NET_HANDSHAKE_TIMEOUT_MS) < 0 ||
+            reply.type != PROTO_HELLO)
+        {
+            fprintf(stderr, "Erreur : le client n'a pas envoyé de trame HELLO\n");
+            return -1;
+        }
+        if (reply.u.hello.version != PROTO_VERSION)
+        {
+            fprintf(stderr, "Erreur : version %d du protocole non prise en charge\n", reply.u.hello.version);
+            ProtoMsg err = { .type = PROTO_ERROR, .u.error = PROTO_ERR_VERSION };
+            network_queue(&err);
+            network_flush();
+            return -1;
+        }
+        hello.u.hello.role = PROTO_ROLE_BLUE; // l'hôte joue les rouges
+        if (network_queue(&hello) < 0 || network_flush() < 0)
+            return -1;
+        return 0;
+    }
+
+    if (network_queue(&hello) < 0 || network_flush() < 0 ||
+        net_recv_frame(net_socket, &net_reader, &reply, -1) < 0)
+    {
+        fprintf(stderr, "Erreur : pas de réponse à la trame HELLO\n");
+        return -1;
+    }
+    if (reply.type == PROTO_ERROR)
+    {
+        fprintf(stderr, "Erreur : connexion refusée par le pair (code %d)\n", reply.u.error);
+        return -1;
+    }
+    if (reply.type != PROTO_HELLO || reply.u.hello.version != PROTO_VERSION ||
+        (reply.u.hello.role != PROTO_ROLE_BLUE && reply.u.hello.role != PROTO_ROLE_RED))
+    {
+        fprintf(stderr, "Erreur : réponse HELLO invalide\n");
+        return -1;
+    }
+    is_server = reply.u.hello.role == PROTO_ROLE_RED;
+    return 0;
+}
+
+/**
+ * @see reseau_integration.h
+ */
+int network_plays_blue(void)
+{
+    return !is_server;
 }
 
 
@@ -46,96 +297,159 @@ int network_is_active()
 }
 
 /**
- * @see reseau_integration.h
+ * @brief Termine la partie dans l'interface après la perte de la connexion.
+ *
+ * Appelée par `network_ui_drain`, après les coups déjà reçus, ou par
+ * `send_move_to_network` quand l'arbitre refuse le coup local.
+ * @param reason Le message à afficher.
  */
-void send_move_to_network(const char *src_id, const char *dst_id)
+static void network_lost_ui(const char *reason)
 {
-    if (!is_network || net_socket < 0)
+    if (game_over)
+    {
         return;
+    }
+
+    game_over = 1;
+    ia_cancel_search();
+    ia_persist_tt();
+    gtk_widget_set_sensitive(config.window, FALSE);
+    gtk_label_set_text(GTK_LABEL(config.couleur_label), reason);
+}
+
+/**
+ * @see reseau_integration.h
+ */
+int send_move_to_network(const char *src_id, const char *dst_id)
+{
+    if (!is_network)
+        return 0;
 
     char move[5];
     snprintf(move, sizeof(move), "%s%s", src_id, dst_id); // ex: A1A3
-    net_send_move(net_socket, move);
+    int from = geo_index_depuis_id(src_id), to = geo_index_depuis_id(dst_id);
+    ProtoMsg msg = { .type = PROTO_MOVE, .u.move = { (uint8_t)from, (uint8_t)to } };
+    if (atomic_load(&net_resync_pending))
+    {
+        // La position de reprise, appliquée juste après, annulera le coup affiché.
+        fprintf(stderr, "Attention : coup %s non envoyé, reprise de la partie en cours\n", move);
+        return 0;
+    }
+    if (logique_jouer_coup(&net_state, from, to) < 0)
+    {
+        // L'arbitre ne suivrait plus le plateau : la partie est abandonnée
+        // plutôt que de refuser ensuite les coups légaux de l'adversaire.
+        fprintf(stderr, "Erreur : coup %s refusé par l'arbitre, abandon de la partie\n", move);
+        ProtoMsg resign = { .type = PROTO_RESIGN };
+        if (network_queue(&resign) == 0)
+            network_flush();
+        atomic_store(&net_finished, true);
+        atomic_store(&net_lost_reason, "Coup refusé par l'arbitre");
+        network_lost_ui("Coup refusé par l'arbitre");
+        return -1;
+    }
+    network_record_move(from, to);
+    int64_t start = latency_now_us();
+    if (from < 0 || to < 0 || network_send_move(&msg) < 0)
+    {
+        fprintf(stderr, "Erreur : envoi du coup %s impossible\n", move);
+        return 0; // la perte de la connexion est signalée par la boucle réseau
+    }
+    latency_record(LAT_SEND, latency_now_us() - start);
+    if (net_last_received_us > 0)
+    {
+        latency_record(LAT_TURNAROUND, start - net_last_received_us);
+        net_last_received_us = 0;
+    }
 
     printf("%s%s\n", "envoie : ", move);
+    return 0;
 }
 
 /**
- * @brief apply_network_move_ui applique un coup reçu du réseau à l'interface utilisateur.
- *
- * Elle est appelée de manière asynchrone par GTK (`g_idle_add`)
- * pour garantir qu'elle s'exécute dans le processus principal de l'interface
- * graphique, évitant ainsi les problèmes de concurrence.
+ * @brief Affiche le tour courant et lance l'IA si c'est au joueur local de jouer.
  *
- * @param user_data Pointeur vers une structure `MoveData` contenant le coup.
- * @return FALSE pour que la fonction ne soit exécutée qu'une seule fois.
+ * Appelée après chaque coup reçu, et après l'application d'une position de reprise.
  */
-gboolean apply_network_move_ui(gpointer user_data)
+static void network_turn_ui(void)
 {
-    MoveData *data = (MoveData *)user_data;
+    char buffer[100];
+    snprintf(buffer, sizeof(buffer), "%d", tour);
+    char result[120] = "Tour : ";
+    strcat(result, buffer);
+    gtk_label_set_text(GTK_LABEL(config.tour_label), result);
 
-    Case *cellsrc = get_case_by_id(data->src_id);
-    if (!cellsrc)
+    if (tour == 65)
     {
-        fprintf(stderr, "Source invalide : %s\n", data->src_id);
-        free(data);
-        return FALSE;
+        endgame(0, 0);
+        return;
     }
 
-    select_case(cellsrc);
-
-    Case *celldst = get_case_by_id(data->dst_id);
-    if (!celldst)
+    const char *texte = gtk_label_get_text(GTK_LABEL(config.couleur_label));
+    if (tour % 2 != 0 &&
+        (strcmp(texte, "Tour des rouges (serveur)") == 0 || strcmp(texte, "Tour des bleus (client)") == 0))
     {
-        fprintf(stderr, "Destination invalide : %s\n", data->dst_id);
-        unselect_case();
-        free(data);
-        return FALSE;
+        gtk_label_set_text(GTK_LABEL(config.couleur_label), "Tour des bleus (client)");
     }
-
-    const char *label = gtk_button_get_label(GTK_BUTTON(celldst->button));
-    if (!label || strcmp(label, "•") != 0)
+    else if (strcmp(texte, "Tour des rouges (serveur)") == 0 || strcmp(texte, "Tour des bleus (client)") == 0)
     {
-        printf("déplacement du pion interdit !\n");
-        unselect_case();
-        free(data);
-        return FALSE;
+        gtk_label_set_text(GTK_LABEL(config.couleur_label), "Tour des rouges (serveur)");
     }
 
-    int selected_color = selected->couleur;
-    int selected_pion = selected->pion;
-    const char *str = gtk_button_get_label(GTK_BUTTON(selected->button));
-    char *selected_button_label = strdup(str);
-
-    char *mouvement = NULL;
-    if (gtk_widget_has_css_class(celldst->button, "haut"))
-    {
-        mouvement = "haut";
-    }
-    else if (gtk_widget_has_css_class(celldst->button, "bas"))
-    {
-        mouvement = "bas";
-    }
-    else if (gtk_widget_has_css_class(celldst->button, "droite"))
+    // Lancer l’IA si activée
+    if (config.ai)
     {
-        mouvement = "droite";
+        if (is_server && tour % 2 == 0)
+        {
+            ia_play_red();
+        }
+        else if (!is_server && tour % 2 != 0)
+        {
+            ia_play_blue();
+        }
     }
-    else if (gtk_widget_has_css_class(celldst->button, "gauche"))
+}
+
+/**
+ * @brief apply_network_move_ui applique un coup reçu du réseau à l'interface utilisateur.
+ *
+ * Elle est appelée par la source GTK qui vide la file des coups, dans le
+ * thread de l'interface graphique, évitant ainsi les problèmes de concurrence.
+ * Le coup a été validé au préalable par `logique_jouer_coup` sur `net_state`.
+ *
+ * @param src_id Identifiant de la case de départ (ex: "A1").
+ * @param dst_id Identifiant de la case d'arrivée.
+ */
+static void apply_network_move_ui(const char *src_id, const char *dst_id)
+{
+    Case *cellsrc = get_case_by_id(src_id);
+    Case *celldst = get_case_by_id(dst_id);
+    int d = geo_direction_entre(geo_index_depuis_id(src_id), geo_index_depuis_id(dst_id));
+    if (!cellsrc || !celldst || d < 0)
     {
-        mouvement = "gauche";
+        fprintf(stderr, "Coup invalide : %s%s\n", src_id, dst_id);
+        return;
     }
 
-    selected->pion = EMPTY;
-    gtk_button_set_label(GTK_BUTTON(selected->button), "");
+    // Le coup a déjà été validé sur `net_state` : il est appliqué directement,
+    // sans passer par la sélection et ses cases jouables.
+    int src_color = cellsrc->couleur;
+    int src_pion = cellsrc->pion;
+    const char *str = gtk_button_get_label(GTK_BUTTON(cellsrc->button));
+    char *src_label = strdup(str);
+    char *mouvement = (char *)geo_noms_directions[d];
 
-    if (strcmp(selected->id, "A9") == 0)
+    cellsrc->pion = EMPTY;
+    gtk_button_set_label(GTK_BUTTON(cellsrc->button), "");
+
+    if (strcmp(cellsrc->id, "A9") == 0)
     {
         Case *ville1 = get_case_by_id("A9");
         gtk_button_set_label(GTK_BUTTON(ville1->button), "市");
         gtk_widget_remove_css_class(ville1->button, "haut");
         set_cell_color(ville1, 2);
     }
-    else if (strcmp(selected->id, "I1") == 0)
+    else if (strcmp(cellsrc->id, "I1") == 0)
     {
         Case *ville2 = get_case_by_id("I1");
         gtk_button_set_label(GTK_BUTTON(ville2->button), "市");
@@ -143,12 +457,10 @@ gboolean apply_network_move_ui(gpointer user_data)
         set_cell_color(ville2, 1);
     }
 
-    unselect_case();
-
-    set_cell_color(celldst, selected_color);
-    celldst->pion = selected_pion;
-    gtk_button_set_label(GTK_BUTTON(celldst->button), selected_button_label);
-    g_free(selected_button_label);
+    set_cell_color(celldst, src_color);
+    celldst->pion = src_pion;
+    gtk_button_set_label(GTK_BUTTON(celldst->button), src_label);
+    g_free(src_label);
 
     // Règles de jeu
     capture(celldst, mouvement);
@@ -159,106 +471,656 @@ gboolean apply_network_move_ui(gpointer user_data)
     if (verif_ville_bleu && verif_ville_bleu->pion == ROI_ROUGE)
     {
         endgame(1, 2);
-        free(data);
-        return FALSE;
+        return;
     }
 
     Case *verif_ville_rouge = get_case_by_id("I1");
     if (verif_ville_rouge && verif_ville_rouge->pion == ROI_BLEU)
     {
         endgame(1, 1);
-        free(data);
-        return FALSE;
+        return;
     }
 
     // Incrément du tour
     tour += 1;
-    char buffer[100];
-    snprintf(buffer, sizeof(buffer), "%d", tour);
-    char result[120] = "Tour : ";
-    strcat(result, buffer);
-    gtk_label_set_text(GTK_LABEL(config.tour_label), result);
+    ia_note_position();
+    network_turn_ui();
+}
 
-    if (tour == 65)
+/**
+ * @brief Refuse un coup illégal de l'adversaire : trame ERROR, puis fin de la partie.
+ * @param m Le coup refusé.
+ */
+static void network_reject_move(QueuedMove m)
+{
+    char src_id[3], dst_id[3];
+    geo_id_depuis_index(m.from, src_id);
+    geo_id_depuis_index(m.to, dst_id);
+    fprintf(stderr, "Erreur : coup illégal reçu : %s%s\n", src_id, dst_id);
+
+    ProtoMsg err = { .type = PROTO_ERROR, .u.error = PROTO_ERR_ILLEGAL };
+    if (network_queue(&err) == 0)
+        network_flush();
+    atomic_store(&net_lost_reason, "Coup illégal de l'adversaire");
+    network_lost_ui("Coup illégal de l'adversaire");
+}
+
+/**
+ * @brief Compare deux positions champ par champ (le remplissage de la structure n'est pas comparable).
+ * @param a La première position.
+ * @param b La seconde position.
+ * @return true si elles sont identiques.
+ */
+static bool network_same_state(const GameState *a, const GameState *b)
+{
+    return memcmp(a->pion, b->pion, sizeof(a->pion)) == 0 && memcmp(a->couleur, b->couleur, sizeof(a->couleur)) == 0 &&
+           a->dead_red_count == b->dead_red_count && a->dead_blue_count == b->dead_blue_count &&
+           a->tour == b->tour && a->game_over_status == b->game_over_status;
+}
+
+/**
+ * @brief Redessine tout le plateau à partir d'une position.
+ * @param s La position.
+ */
+static void network_load_board(const GameState *s)
+{
+    static const char *symbols[] = { "", "♖", "♜", "♔", "♚" }; // indexés par pion, comme dans init_plateau
+    for (int r = 0; r < SIZE; r++)
     {
-        endgame(0, 0);
-        free(data);
-        return FALSE;
+        for (int c = 0; c < SIZE; c++)
+        {
+            Case *cell = plateau[r][c];
+            int pion = s->pion[r][c];
+            bool city = (r == 0 && c == 0) || (r == SIZE - 1 && c == SIZE - 1);
+            cell->pion = pion >= EMPTY && pion <= ROI_BLEU ? pion : EMPTY;
+            gtk_button_set_label(GTK_BUTTON(cell->button), cell->pion == EMPTY && city ? "市" : symbols[cell->pion]);
+            set_cell_color(cell, s->couleur[r][c]);
+        }
     }
+}
 
-    const char *texte = gtk_label_get_text(GTK_LABEL(config.couleur_label));
-    if (tour % 2 != 0 &&
-        (strcmp(texte, "Tour des rouges (serveur)") == 0 || strcmp(texte, "Tour des bleus (client)") == 0))
+/**
+ * @brief Applique à l'interface la position reçue lors d'une reprise.
+ *
+ * Les coups manqués ont déjà été rejoués sur `net_state` ; si la position
+ * du serveur diffère encore (coup local perdu avec la connexion), elle fait
+ * foi et le journal, qui ne peut pas revenir en arrière, est arrêté. Le
+ * plateau n'est redessiné que si l'affichage ne correspond plus.
+ */
+static void network_resync_ui(void)
+{
+    GameState s = net_resync_state;
+    atomic_store(&net_resync_pending, false);
+
+    if (!network_same_state(&s, &net_state))
     {
-        gtk_label_set_text(GTK_LABEL(config.couleur_label), "Tour des bleus (client)");
+        fprintf(stderr, "Attention : position du serveur différente, la partie reprend depuis celle-ci\n");
+        net_state = s;
+        if (net_journaled)
+        {
+            fprintf(stderr, "Attention : journal %s arrêté à la reprise\n", config.journal_path);
+            journal_close(&net_journal);
+            net_journaled = false;
+        }
     }
-    else if (strcmp(texte, "Tour des rouges (serveur)") == 0 || strcmp(texte, "Tour des bleus (client)") == 0)
+    else if (s.tour == tour)
     {
-        gtk_label_set_text(GTK_LABEL(config.couleur_label), "Tour des rouges (serveur)");
+        printf("Partie reprise\n");
+        return; // rien de manqué : une recherche de l'IA en cours reste valable
     }
+    printf("Partie reprise au tour %d\n", s.tour);
 
-    // Lancer l’IA si activée
-    if (config.ai)
+    ia_cancel_search();
+    if (selected)
+        unselect_case();
+    network_load_board(&s);
+    tour = s.tour;
+    dead_red_count = s.dead_red_count;
+    dead_blue_count = s.dead_blue_count;
+    check_dead_count();
+    ia_note_position();
+    if (s.game_over_status != 0)
+    {
+        atomic_store(&net_finished, true);
+        endgame(s.tour > 64 ? 0 : 1, s.game_over_status == 1 ? 1 : 2);
+        return;
+    }
+    network_turn_ui();
+}
+
+/**
+ * @brief Source GTK réveillée par le thread réseau : applique les coups en attente.
+ *
+ * Les coups sont appliqués dans leur ordre d'arrivée, puis la perte de la
+ * connexion éventuelle est traitée. Les coups rejoués par une reprise ne
+ * sont pas animés : le marqueur qui les suit redessine le plateau.
+ * @param fd L'eventfd de réveil.
+ * @param condition Inutilisé.
+ * @param user_data Inutilisé.
+ * @return G_SOURCE_CONTINUE : la source reste active jusqu'à `network_stop`.
+ */
+static gboolean network_ui_drain(int fd, GIOCondition condition, gpointer user_data)
+{
+    (void)condition;
+    (void)user_data;
+    uint64_t count;
+    if (read(fd, &count, sizeof(count)) < 0 && errno != EAGAIN)
     {
-        if (config.mode == SERVER && tour % 2 == 0)
+        perror("eventfd");
+    }
+
+    QueuedMove m;
+    while (move_queue_pop(&net_moves, &m))
+    {
+        if (game_over)
         {
-            ia_play_red();
+            continue; // coups arrivés après la fin de la partie
         }
-        else if (config.mode == CLIENT && tour % 2 != 0)
+        if (m.flags & MOVE_QUEUE_RESYNC)
         {
-            ia_play_blue();
+            network_resync_ui();
+            continue;
+        }
+        if (logique_jouer_coup(&net_state, m.from, m.to) < 0)
+        {
+            if (!(m.flags & MOVE_QUEUE_REPLAY))
+                network_reject_move(m);
+            continue; // un coup rejoué refusé sera corrigé par la position du serveur
+        }
+        network_record_move(m.from, m.to);
+        if (m.flags & MOVE_QUEUE_REPLAY)
+        {
+            continue;
         }
+
+        char src_id[3], dst_id[3];
+        geo_id_depuis_index(m.from, src_id);
+        geo_id_depuis_index(m.to, dst_id);
+        printf("reçu : %s%s\n", src_id, dst_id);
+
+        int64_t start = latency_now_us();
+        latency_record(LAT_QUEUE, start - m.received_us);
+        net_last_received_us = m.received_us;
+        apply_network_move_ui(src_id, dst_id);
+        latency_record(LAT_APPLY, latency_now_us() - start);
+    }
+
+    const char *reason = atomic_load(&net_lost_reason);
+    if (reason)
+    {
+        network_lost_ui(reason);
     }
+    return G_SOURCE_CONTINUE;
+}
 
-    free(data);
-    return FALSE;
+/**
+ * @brief Envoie un PING daté, dont le PONG donnera l'aller-retour.
+ * @param user_data Inutilisé.
+ * @return G_SOURCE_CONTINUE tant que la connexion est active.
+ */
+static gboolean network_ping_timeout(gpointer user_data)
+{
+    (void)user_data;
+    if (atomic_load(&net_lost_reason))
+    {
+        net_ping_source = 0;
+        return G_SOURCE_REMOVE;
+    }
+    ProtoMsg ping = { .type = PROTO_PING, .u.ping = (uint64_t)latency_now_us() };
+    if (network_queue(&ping) == 0)
+        network_flush(); // une erreur sera signalée par la boucle réseau
+    return G_SOURCE_CONTINUE;
 }
 
 /**
- * @see reseau_integration.h
+ * @brief Affiche les histogrammes de latence à la réception de SIGUSR1.
+ * @param user_data Inutilisé.
+ * @return G_SOURCE_CONTINUE.
  */
-void apply_network_move(const char *move)
+static gboolean network_dump_latencies(gpointer user_data)
 {
-    printf("reçu : %s\n", move);
+    (void)user_data;
+    latency_dump(stdout);
+    return G_SOURCE_CONTINUE;
+}
 
-    if (strlen(move) != 4 ||
-        !isalpha(move[0]) || !isdigit(move[1]) ||
-        !isalpha(move[2]) || !isdigit(move[3]))
+/**
+ * @brief Réveille la source GTK qui vide la file des coups (thread réseau).
+ */
+static void network_notify_ui(void)
+{
+    uint64_t one = 1;
+    if (write(net_ui_fd, &one, sizeof(one)) != sizeof(one))
     {
-        fprintf(stderr, "Erreur : format de move invalide : %s\n", move);
-        return;
+        perror("eventfd");
     }
+}
 
-    MoveData *data = malloc(sizeof(MoveData));
-    strncpy(data->src_id, move, 2);
-    data->src_id[2] = '\0';
-    strncpy(data->dst_id, move + 2, 2);
-    data->dst_id[2] = '\0';
+/**
+ * @brief Traite une trame reçue par la boucle réseau.
+ * @param m La trame.
+ * @param[out] reason Message à afficher si la partie doit s'arrêter.
+ * @param[out] queued Passe à true si un coup a été ajouté à la file.
+ * @return true si la connexion continue.
+ */
+static bool network_handle_frame(const ProtoMsg *m, const char **reason, bool *queued)
+{
+    switch (m->type)
+    {
+    case PROTO_MOVE:
+    {
+        QueuedMove move = { m->u.move.from, m->u.move.to, latency_now_us(), 0 };
+        if (move_queue_push(&net_moves, move) < 0)
+        {
+            fprintf(stderr, "Erreur : trop de coups en attente, connexion abandonnée\n");
+            return false;
+        }
+        atomic_fetch_add(&net_plies, 1);
+        *queued = true;
+        return true;
+    }
+    case PROTO_SESSION:
+        net_session_game = m->u.session.game;
+        net_session_token = m->u.session.token;
+        printf("Partie %08x : reprise possible après une coupure\n", (unsigned)net_session_game);
+        return true;
+    case PROTO_PING:
+    {
+        ProtoMsg pong = { .type = PROTO_PONG, .u.ping = m->u.ping };
+        network_queue(&pong);
+        return true;
+    }
+    case PROTO_PONG:
+        latency_record(LAT_RTT, latency_now_us() - (int64_t)m->u.ping);
+        return true;
+    case PROTO_CLOCK:
+        return true; // informative : la partie n'en dépend pas
+    case PROTO_RESIGN:
+        printf("L'adversaire abandonne\n");
+        *reason = "Abandon de l'adversaire";
+        return false;
+    case PROTO_ERROR:
+        fprintf(stderr, "Erreur signalée par l'adversaire (code %d)\n", m->u.error);
+        return false;
+    default:
+    {
+        fprintf(stderr, "Erreur : trame de type %d inattendue\n", m->type);
+        ProtoMsg err = { .type = PROTO_ERROR, .u.error = PROTO_ERR_MALFORMED };
+        network_queue(&err);
+        return false;
+    }
+    }
+}
 
-    g_idle_add(apply_network_move_ui, data);
+/**
+ * @brief Traite les trames complètes déjà présentes dans le lecteur de la connexion.
+ * @param[out] reason Message à afficher si la partie doit s'arrêter.
+ * @param[out] queued Passe à true si un coup a été ajouté à la file.
+ * @return true si la connexion continue.
+ */
+static bool network_handle_frames(const char **reason, bool *queued)
+{
+    ProtoMsg msg;
+    int got;
+    while ((got = proto_reader_next(&net_reader, &msg)) > 0)
+    {
+        if (!network_handle_frame(&msg, reason, queued))
+            return false;
+    }
+    if (got < 0)
+    {
+        fprintf(stderr, "Erreur : trame invalide reçue (code %d)\n", -got);
+        ProtoMsg err = { .type = PROTO_ERROR, .u.error = (uint8_t)-got };
+        network_queue(&err);
+        return false;
+    }
+    return true;
 }
 
 /**
- * @see reseau_integration.h
+ * @brief Tente une fois de reprendre la partie sur une nouvelle connexion.
+ *
+ * Envoie HELLO (PROTO_ROLE_RESUME) et RESUME, puis lit la réponse : HELLO,
+ * les coups manqués, déposés dans la file avec MOVE_QUEUE_REPLAY, et la
+ * position du serveur, signalée à l'interface par un marqueur
+ * MOVE_QUEUE_RESYNC. La nouvelle connexion remplace alors l'ancienne.
+ * @return 0 si la partie reprend, -1 si la tentative peut être renouvelée,
+ * -2 si le serveur refuse la reprise.
  */
-void network_listen_loop()
+static int network_try_resume(void)
 {
-    if (!is_network || net_socket < 0)
+    int sock = net_connect_timeout(NET_RESUME_RETRY_MS);
+    if (sock < 0)
+        return -1;
+
+    ProtoWriter w;
+    ProtoReader r;
+    proto_writer_init(&w);
+    proto_reader_init(&r);
+    ProtoMsg hello = { .type = PROTO_HELLO, .u.hello = { PROTO_VERSION, PROTO_ROLE_RESUME } };
+    ProtoMsg resume = { .type = PROTO_RESUME,
+                        .u.session = { net_session_game, net_session_token, atomic_load(&net_plies) } };
+    ProtoMsg m;
+    proto_writer_push(&w, &hello);
+    proto_writer_push(&w, &resume);
+    if (net_send_all(sock, w.buf, w.len) < 0 || net_recv_frame(sock, &r, &m, NET_RESUME_RETRY_MS) < 0)
     {
-        printf("pas en réseau, fonction network listen loop\n");
-        return;
+        close(sock);
+        return -1;
+    }
+    int role = is_server ? PROTO_ROLE_RED : PROTO_ROLE_BLUE;
+    if (m.type != PROTO_HELLO || m.u.hello.version != PROTO_VERSION || m.u.hello.role != role)
+    {
+        if (m.type == PROTO_ERROR)
+            fprintf(stderr, "Erreur : reprise refusée par le serveur (code %d)\n", m.u.error);
+        else
+            fprintf(stderr, "Erreur : réponse invalide à la demande de reprise\n");
+        close(sock);
+        return -2;
     }
 
-    while (1)
+    bool queued = false;
+    for (;;)
     {
-        char buffer[5];
-        if (net_recv_move(net_socket, buffer) == 0)
+        if (net_recv_frame(sock, &r, &m, NET_RESUME_RETRY_MS) < 0)
         {
-            apply_network_move(buffer);
+            close(sock);
+            return -1;
         }
-        else
+        if (m.type == PROTO_STATE)
+            break;
+        QueuedMove move = { m.u.move.from, m.u.move.to, latency_now_us(), MOVE_QUEUE_REPLAY };
+        if (m.type != PROTO_MOVE || move_queue_push(&net_moves, move) < 0)
         {
-            continue;
+            fprintf(stderr, "Erreur : reprise interrompue (trame de type %d)\n", m.type);
+            close(sock);
+            if (queued)
+                network_notify_ui();
+            return -2;
+        }
+        queued = true;
+    }
+
+    QueuedMove marker = { 0, 0, latency_now_us(), MOVE_QUEUE_RESYNC };
+    if (move_queue_push(&net_moves, marker) < 0)
+    {
+        fprintf(stderr, "Erreur : trop de coups en attente, reprise abandonnée\n");
+        close(sock);
+        network_notify_ui();
+        return -2;
+    }
+
+    // Dès ce point, les coups joués par l'interface attendent la position du serveur.
+    pthread_mutex_lock(&net_write_lock);
+    net_resync_state = m.u.state;
+    atomic_store(&net_plies, (uint32_t)(m.u.state.tour - 1));
+    atomic_store(&net_resync_pending, true);
+    epoll_ctl(net_epoll_fd, EPOLL_CTL_DEL, net_socket, NULL);
+    close(net_socket);
+    net_socket = sock;
+    proto_writer_init(&net_writer);
+    net_writer.next_seq = w.next_seq;
+    net_want_write = false;
+    struct epoll_event sock_ev = { .events = EPOLLIN | EPOLLRDHUP, .data.fd = sock };
+    int added = epoll_ctl(net_epoll_fd, EPOLL_CTL_ADD, sock, &sock_ev); // avant tout envoi de l'interface
+    pthread_mutex_unlock(&net_write_lock);
+
+    net_reader = r; // les octets déjà reçus à la suite de STATE
+    char report[128];
+    net_tune_socket(sock, report, sizeof(report));
+    if (added < 0)
+    {
+        perror("epoll_ctl");
+        network_notify_ui();
+        return -2;
+    }
+    network_notify_ui();
+    return 0;
+}
+
+/**
+ * @brief Reprend la partie après une coupure, en réessayant pendant NET_RESUME_WINDOW_MS.
+ *
+ * Sans trame SESSION (partie entre deux clients) ou après la fin de la
+ * partie, il n'y a rien à reprendre. Une tentative a lieu toutes les
+ * NET_RESUME_RETRY_MS ; une demande d'arrêt l'interrompt.
+ * @return 0 si la partie reprend, -1 sinon.
+ */
+static int network_resume(void)
+{
+    if (net_session_token == 0 || atomic_load(&net_finished))
+        return -1;
+    printf("Connexion perdue, reprise de la partie %08x...\n", (unsigned)net_session_game);
+
+    gint64 deadline = g_get_monotonic_time() + (gint64)NET_RESUME_WINDOW_MS * 1000;
+    for (;;)
+    {
+        gint64 start = g_get_monotonic_time();
+        // Une reprise précédente doit avoir été appliquée avant d'en recevoir une autre.
+        if (!atomic_load(&net_resync_pending))
+        {
+            int r = network_try_resume();
+            if (r == 0)
+                return 0;
+            if (r < -1)
+                return -1;
+        }
+
+        gint64 now = g_get_monotonic_time();
+        if (now >= deadline)
+        {
+            fprintf(stderr, "Erreur : reprise impossible en %d s\n", NET_RESUME_WINDOW_MS / 1000);
+            return -1;
+        }
+        int wait = (int)((start + (gint64)NET_RESUME_RETRY_MS * 1000 - now) / 1000);
+        struct pollfd pfd = { .fd = net_wakeup_fd, .events = POLLIN };
+        if (poll(&pfd, 1, wait > 0 ? wait : 0) > 0)
+            return -1; // arrêt demandé : l'eventfd reste lisible pour la boucle
+    }
+}
+
+/**
+ * @brief Corps du thread réseau : attend les données du socket ou la demande d'arrêt.
+ *
+ * Les octets reçus sont découpés en trames, une trame pouvant arriver en
+ * plusieurs morceaux ; les réponses produites par un lot de trames sont
+ * envoyées ensemble, et l'interface est réveillée une fois par lot. Une
+ * connexion fermée par le réseau est reprise par `network_resume` si le
+ * serveur l'autorise.
+ * @param arg Inutilisé.
+ * @return NULL.
+ */
+static void *network_loop_main(void *arg)
+{
+    (void)arg;
+    gint64 frame_deadline = 0;
+    const char *reason = "Adversaire déconnecté";
+    bool lost = false, dropped = false;
+    bool buffered = true; // des trames ont pu arriver avec la poignée de main (SESSION)
+
+    while (!lost)
+    {
+        if (!buffered)
+        {
+            // Sans trame commencée, le thread dort jusqu'aux prochaines données.
+            int timeout = -1;
+            if (net_reader.len > 0)
+            {
+                gint64 left = (frame_deadline - g_get_monotonic_time()) / 1000;
+                timeout = left > 0 ? (int)left : 0;
+            }
+
+            struct epoll_event events[2];
+            int n = epoll_wait(net_epoll_fd, events, 2, timeout);
+            if (n < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                perror("epoll_wait");
+                lost = true;
+                break;
+            }
+            if (n == 0)
+            {
+                fprintf(stderr, "Erreur : trame incomplète reçue, connexion abandonnée\n");
+                lost = true;
+                break;
+            }
+
+            bool stop = false, readable = false;
+            for (int i = 0; i < n; i++)
+            {
+                if (events[i].data.fd == net_wakeup_fd)
+                    stop = true;
+                else
+                    readable = true; // EPOLLHUP/EPOLLERR sont signalés par la lecture, EPOLLOUT par l'envoi final
+            }
+            if (stop)
+                break;
+            if (!readable)
+                continue;
+        }
+
+        bool queued = false;
+        if (buffered)
+        {
+            buffered = false;
+            lost = !network_handle_frames(&reason, &queued);
+            frame_deadline = g_get_monotonic_time() + (gint64)NET_FRAME_TIMEOUT_MS * 1000;
+        }
+        while (!lost)
+        {
+            int r = net_recv_available(net_socket, (char *)net_reader.buf + net_reader.len,
+                                       PROTO_BUF_SIZE - net_reader.len);
+            if (r < 0)
+            {
+                printf("Connexion avec l'adversaire perdue\n");
+                lost = dropped = true;
+                break;
+            }
+            if (r == 0)
+                break;
+            if (net_reader.len == 0)
+                frame_deadline = g_get_monotonic_time() + (gint64)NET_FRAME_TIMEOUT_MS * 1000;
+            net_reader.len += r;
+            if (!network_handle_frames(&reason, &queued))
+                lost = true;
+            else if (net_reader.len > 0)
+                frame_deadline = g_get_monotonic_time() + (gint64)NET_FRAME_TIMEOUT_MS * 1000;
         }
+        if (network_flush() < 0 && !lost)
+            lost = dropped = true;
+        if (queued)
+            network_notify_ui();
+        if (dropped && network_resume() == 0)
+            buffered = true;
+        if (buffered)
+            lost = dropped = false;
+    }
+
+    if (lost)
+    {
+        atomic_store(&net_lost_reason, reason);
+        network_notify_ui();
+    }
+    return NULL;
+}
+
+/**
+ * @brief Ferme l'instance epoll et les eventfd de la boucle réseau, et retire la source GTK.
+ */
+static void network_close_loop_fds(void)
+{
+    if (net_ui_source)
+        g_source_remove(net_ui_source);
+    if (net_ping_source)
+        g_source_remove(net_ping_source);
+    if (net_dump_source)
+        g_source_remove(net_dump_source);
+    net_ui_source = net_ping_source = net_dump_source = 0;
+    if (net_epoll_fd >= 0)
+        close(net_epoll_fd);
+    if (net_wakeup_fd >= 0)
+        close(net_wakeup_fd);
+    if (net_ui_fd >= 0)
+        close(net_ui_fd);
+    net_epoll_fd = net_wakeup_fd = net_ui_fd = -1;
+}
+
+/**
+ * @see reseau_integration.h
+ */
+int network_start(void)
+{
+    if (!is_network || net_socket < 0 || net_thread_running)
+    {
+        return -1;
+    }
+    if (net_set_nonblocking(net_socket) < 0)
+    {
+        return -1;
+    }
+
+    move_queue_init(&net_moves);
+    atomic_store(&net_lost_reason, NULL);
+    net_want_write = false;
+    net_wakeup_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    net_ui_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    net_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (net_wakeup_fd < 0 || net_ui_fd < 0 || net_epoll_fd < 0)
+    {
+        network_close_loop_fds();
+        return -1;
+    }
+    net_ui_source = g_unix_fd_add(net_ui_fd, G_IO_IN, network_ui_drain, NULL);
+    net_ping_source = g_timeout_add_seconds(NET_PING_INTERVAL_S, network_ping_timeout, NULL);
+    net_dump_source = g_unix_signal_add(SIGUSR1, network_dump_latencies, NULL);
+
+    struct epoll_event sock_ev = { .events = EPOLLIN | EPOLLRDHUP, .data.fd = net_socket };
+    struct epoll_event wake_ev = { .events = EPOLLIN, .data.fd = net_wakeup_fd };
+    if (epoll_ctl(net_epoll_fd, EPOLL_CTL_ADD, net_socket, &sock_ev) < 0 ||
+        epoll_ctl(net_epoll_fd, EPOLL_CTL_ADD, net_wakeup_fd, &wake_ev) < 0 ||
+        pthread_create(&net_thread, NULL, network_loop_main, NULL) != 0)
+    {
+        network_close_loop_fds();
+        return -1;
+    }
+    net_thread_running = true;
+    return 0;
+}
+
+/**
+ * @see reseau_integration.h
+ */
+void network_stop(void)
+{
+    if (net_thread_running)
+    {
+        uint64_t one = 1;
+        if (write(net_wakeup_fd, &one, sizeof(one)) != sizeof(one))
+        {
+            perror("eventfd");
+        }
+        pthread_join(net_thread, NULL);
+        net_thread_running = false;
+        latency_dump(stdout);
+    }
+    network_close_loop_fds();
+
+    // Trames restées dans l'écrivain (socket plein) : dernier envoi, bloquant.
+    if (net_socket >= 0)
+        network_flush();
+
+    if (net_journaled)
+    {
+        if (journal_end(&net_journal, &net_state) < 0 || journal_close(&net_journal) < 0)
+            fprintf(stderr, "Attention : fin du journal %s non enregistrée\n", config.journal_path);
+        net_journaled = false;
+    }
+
+    if (net_socket >= 0)
+    {
+        close(net_socket);
+        net_socket = -1;
     }
 }
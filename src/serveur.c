@@ -0,0 +1,1729 @@
+/**
+ * @file serveur.c
+ * @brief Serveur de parties sans interface : acceptation, appariement, relais des coups et spectateurs.
+ * @authors Groupe 8
+ *
+ * Le thread appelant de `server_run` accepte les connexions, lit leur
+ * première trame et forme les parties ; chaque partie est ensuite confiée à
+ * un thread de traitement, seul à lire ses sockets et à modifier son
+ * `GameState`. Les parties vivent dans un tableau alloué une fois pour
+ * toutes, dont les places libres forment une liste chaînée.
+ *
+ * Les échanges suivent le protocole de `protocole.h`. La trame HELLO d'un
+ * client est vérifiée par le thread d'acceptation, qui ne lit rien au-delà ;
+ * le serveur envoie ensuite à chaque joueur sa trame HELLO. Les trames
+ * produites par un lot de réception (coups relayés, PONG) partent en un
+ * seul envoi par socket.
+ *
+ * Le journal d'une partie est écrit par son thread de traitement à la fin
+ * de chaque lot de réception, avant l'envoi des trames produites : un coup
+ * relayé figure toujours dans le journal.
+ *
+ * Un spectateur est transmis au thread de sa partie par une boîte aux
+ * lettres (liste protégée par un verrou et eventfd surveillé par le
+ * thread). Chaque trame diffusée est codée une seule fois dans une
+ * `SharedFrame` à compteur de références, que les files de tous les
+ * spectateurs partagent ; un `sendmsg` par spectateur envoie toute sa file
+ * d'un coup. Les spectateurs sont servis après les joueurs et sans jamais
+ * attendre : un spectateur dont la file déborde reçoit la position à la
+ * place des trames en retard, et il est déconnecté après
+ * SRV_SPECTATOR_RESYNCS resynchronisations.
+ *
+ * Un joueur déconnecté en cours de partie n'interrompt pas celle-ci : son
+ * socket est fermé, la partie rejoint la liste d'attente de son thread et
+ * les trames qui lui étaient destinées sont abandonnées. Sa demande de
+ * reprise passe par la même boîte aux lettres que les spectateurs ; il
+ * reçoit alors les coups manqués, tirés de l'historique de la partie, puis
+ * la position. Sans reprise dans les SRV_RESUME_TIMEOUT_MS, la partie est
+ * interrompue.
+ */
+
+#define _GNU_SOURCE // accept4
+
+#include "serveur.h"
+#include "jeu_logique.h"
+#include "geometrie.h"
+#include "protocole.h"
+#include "journal.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/random.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <time.h>
+
+// La réponse à une reprise (HELLO, tout l'historique, STATE) tient dans un tampon de sortie.
+_Static_assert(2 * PROTO_HEADER_SIZE + 4 + SRV_HISTORY * (PROTO_HEADER_SIZE + 2) + PROTO_STATE_SIZE <= PROTO_BUF_SIZE,
+               "SRV_HISTORY trop grand pour PROTO_BUF_SIZE");
+
+typedef struct Match Match;
+typedef struct Worker Worker;
+
+/**
+ * @enum ConnKind
+ * @brief Nature d'un objet désigné par un événement epoll d'un thread de traitement.
+ *
+ * C'est le premier membre de chacun de ces objets.
+ */
+typedef enum {
+    CONN_PLAYER,    /**< Un `Player`. */
+    CONN_SPECTATOR, /**< Un `Spectator`. */
+    CONN_INBOX      /**< La boîte aux lettres du `Worker`. */
+} ConnKind;
+
+/**
+ * @struct SharedFrame
+ * @brief Une trame codée une fois et partagée par les files des spectateurs d'une partie.
+ *
+ * Le compteur n'est pas atomique : seul le thread de la partie y touche.
+ */
+typedef struct {
+    int refs;                        /**< Nombre de files (et de pointeurs) qui la retiennent. */
+    int len;                         /**< Taille de la trame. */
+    uint8_t data[PROTO_FRAME_MAX];   /**< Trame codée. */
+} SharedFrame;
+
+/**
+ * @struct Player
+ * @brief Un joueur connecté, et ses tampons d'entrée et de sortie.
+ */
+typedef struct {
+    ConnKind kind;               /**< CONN_PLAYER. */
+    int fd;                      /**< Socket du joueur, -1 pendant une coupure. */
+    int side;                    /**< 0 pour les bleus, 1 pour les rouges. */
+    uint64_t token;              /**< Jeton de reprise (trame SESSION), 0 si la reprise est impossible. */
+    Match *match;                /**< Partie du joueur. */
+    bool want_out;               /**< true si le socket est surveillé en écriture. */
+    ProtoReader in;              /**< Début de trame reçu, pas encore complet. */
+    ProtoWriter out;             /**< Trames que le socket n'a pas encore acceptées. */
+} Player;
+
+/**
+ * @struct Spectator
+ * @brief Un spectateur et sa file de trames partagées à envoyer.
+ */
+typedef struct Spectator {
+    ConnKind kind;               /**< CONN_SPECTATOR. */
+    int fd;                      /**< Socket du spectateur, -1 une fois fermé. */
+    uint32_t game;               /**< Identifiant de la partie demandée. */
+    Match *match;                /**< Partie suivie. */
+    struct Spectator *prev;      /**< Spectateur précédent de la partie. */
+    struct Spectator *next;      /**< Suivant de la partie, de la boîte aux lettres ou des spectateurs à libérer. */
+    SharedFrame *queue[SRV_SPECTATOR_QUEUE]; /**< File circulaire des trames à envoyer. */
+    int head;                    /**< Première trame de la file. */
+    int count;                   /**< Nombre de trames dans la file. */
+    int offset;                  /**< Octets de la première trame déjà envoyés. */
+    int resyncs;                 /**< Resynchronisations subies. */
+    bool want_out;               /**< true si le socket est surveillé en écriture. */
+} Spectator;
+
+/**
+ * @struct Resume
+ * @brief Une demande de reprise, transmise par le thread d'acceptation au thread de la partie.
+ */
+typedef struct Resume {
+    int fd;                      /**< Socket du joueur reconnecté. */
+    uint32_t game;               /**< Identifiant de la partie. */
+    uint64_t token;              /**< Jeton présenté. */
+    uint32_t plies;              /**< Coups déjà connus du joueur. */
+    struct Resume *next;         /**< Demande suivante de la boîte aux lettres. */
+} Resume;
+
+/**
+ * @struct Match
+ * @brief Une place du tableau des parties.
+ */
+struct Match {
+    GameState state;    /**< Position de la partie. */
+    Player players[2];  /**< Bleus puis rouges. */
+    bool live;          /**< true tant que les sockets sont ouverts. */
+    bool ending;        /**< Partie terminée, derniers envois en cours. */
+    int next_free;      /**< Place libre suivante (si la place est libre). */
+    _Atomic uint32_t id;   /**< Identifiant public de la partie, 0 une fois fermée. */
+    uint16_t generation;   /**< Parties formées dans cette place (thread d'acceptation). */
+    Worker *owner;         /**< Thread de traitement de la partie (thread d'acceptation). */
+    Spectator *spectators; /**< Spectateurs de la partie. */
+    uint32_t bseq;         /**< Séquence de la dernière trame diffusée. */
+    SharedFrame *snapshot; /**< Position codée pour `bseq`, NULL si elle reste à coder. */
+    bool journaled;        /**< true si la partie est enregistrée dans `journal`. */
+    Journal journal;       /**< Journal de la partie. */
+    int plies;             /**< Coups joués. */
+    uint8_t history[SRV_HISTORY][2]; /**< Coups joués (départ, arrivée), renvoyés lors d'une reprise. */
+    bool suspended;        /**< true si un joueur est absent : la partie est dans la liste d'attente. */
+    int64_t resume_deadline_us; /**< Fin de l'attente du joueur absent (horloge monotone). */
+    Match *susp_prev;      /**< Partie précédente de la liste d'attente. */
+    Match *susp_next;      /**< Partie suivante de la liste d'attente. */
+    Match *inbox_next;     /**< Partie suivante de la boîte aux lettres. */
+};
+
+/**
+ * @struct Worker
+ * @brief Un thread de traitement et son instance epoll.
+ */
+struct Worker {
+    pthread_t tid;                  /**< Identifiant système. */
+    int epfd;                       /**< Instance epoll des sockets confiés au thread. */
+    int nclosed;                    /**< Parties fermées pendant le lot d'événements courant. */
+    Match *closed[SRV_EVENTS];      /**< Parties à libérer à la fin du lot. */
+    Spectator *dead;                /**< Spectateurs fermés pendant le lot, libérés à sa fin. */
+    ConnKind inbox_kind;            /**< CONN_INBOX : désigne la boîte aux lettres dans epoll. */
+    int inbox_fd;                   /**< eventfd signalant des spectateurs dans la boîte aux lettres. */
+    pthread_mutex_t inbox_lock;     /**< Protège `inbox`, `resumes` et `starts`. */
+    Spectator *inbox;               /**< Spectateurs confiés par le thread d'acceptation. */
+    Resume *resumes;                /**< Reprises confiées par le thread d'acceptation. */
+    Match *starts;                  /**< Parties formées par le thread d'acceptation, sockets pas encore surveillés. */
+    Match *susp_head;               /**< Parties en attente d'un joueur, par échéance croissante. */
+    Match *susp_tail;               /**< Dernière partie en attente. */
+};
+
+/**
+ * @struct Pending
+ * @brief Une connexion dont le thread d'acceptation attend la trame HELLO (puis WATCH ou RESUME).
+ */
+typedef struct Pending {
+    int fd;                  /**< Socket du client, -1 une fois transmis ou fermé. */
+    int64_t deadline_us;     /**< Fin de l'attente des premières trames (horloge monotone). */
+    int expect;              /**< Trame attendue : PROTO_HELLO, puis PROTO_WATCH ou PROTO_RESUME selon le rôle. */
+    ProtoReader in;          /**< Trame en cours de réception. */
+    struct Pending *prev;    /**< Connexion en attente précédente. */
+    struct Pending *next;    /**< Suivante, ou suivante à libérer. */
+} Pending;
+
+/**
+ * @brief État global du serveur.
+ */
+static struct {
+    Match *slab;              /**< Tableau des parties. */
+    int capacity;             /**< Nombre de places du tableau. */
+    int free_head;            /**< Première place libre, -1 si le tableau est plein. */
+    pthread_mutex_t lock;     /**< Protège la liste des places libres. */
+    Worker workers[SRV_MAX_WORKERS]; /**< Threads de traitement. */
+    int nworkers;             /**< Nombre de threads de traitement lancés. */
+    int wakeup_fd;            /**< eventfd d'arrêt, surveillé par tous les threads. */
+    // Thread d'acceptation uniquement
+    int lobby_fd;             /**< Instance epoll du thread d'acceptation. */
+    Pending *lobby;           /**< Connexions dont la première trame est attendue, par échéance croissante. */
+    Pending *lobby_tail;      /**< Dernière connexion en attente. */
+    Pending *lobby_dead;      /**< Connexions retirées pendant le lot courant, libérées à sa fin. */
+    Pending *waiting;         /**< Joueur en attente d'un adversaire. */
+    uint32_t latest;          /**< Identifiant de la dernière partie formée. */
+    const ServerConfig *cfg;  /**< Configuration (répertoire et politique des journaux). */
+    int next_worker;          /**< Thread qui recevra la prochaine partie. */
+} srv = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .wakeup_fd = -1,
+    .lobby_fd = -1,
+};
+
+/**
+ * @brief Compteurs du serveur, mis à jour par tous les threads.
+ */
+static struct {
+    _Atomic uint64_t accepted, refused, started, finished, aborted, moves;
+    _Atomic uint64_t spectators, dropped, resyncs, journal_errors, resumed;
+    atomic_int active, watching;
+} counters;
+
+/**
+ * @brief Date courante sur l'horloge monotone.
+ * @return La date en microsecondes.
+ */
+static int64_t now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+// Tableau des parties
+
+/**
+ * @brief Réserve une place libre du tableau des parties.
+ * @return La place, ou NULL si le tableau est plein.
+ */
+static Match *slab_alloc(void) {
+    pthread_mutex_lock(&srv.lock);
+    Match *m = NULL;
+    if (srv.free_head >= 0) {
+        m = &srv.slab[srv.free_head];
+        srv.free_head = m->next_free;
+    }
+    pthread_mutex_unlock(&srv.lock);
+    return m;
+}
+
+/**
+ * @brief Rend une place au tableau des parties.
+ * @param m La place, dont les sockets sont déjà fermés.
+ */
+static void slab_free(Match *m) {
+    pthread_mutex_lock(&srv.lock);
+    m->next_free = srv.free_head;
+    srv.free_head = (int)(m - srv.slab);
+    pthread_mutex_unlock(&srv.lock);
+}
+
+/**
+ * @brief Envoie au mieux une trame ERROR, première trame du serveur, puis ferme la connexion.
+ * @param fd Le socket.
+ * @param code Un `ProtoError`.
+ */
+static void reject_connection(int fd, int code) {
+    uint8_t buf[PROTO_FRAME_MAX];
+    ProtoMsg err = { .type = PROTO_ERROR, .u.error = (uint8_t)code };
+    int n = proto_encode(&err, buf, sizeof(buf));
+    if (n > 0 && send(fd, buf, n, MSG_NOSIGNAL) < 0) {
+        // Rien à faire : la connexion est fermée de toute façon.
+    }
+    close(fd);
+}
+
+// Journaux
+
+/**
+ * @brief Abandonne le journal d'une partie après une erreur ; la partie continue.
+ * @param m La partie.
+ */
+static void match_journal_fail(Match *m) {
+    fprintf(stderr, "Partie %08x : journal abandonné (%s)\n", (unsigned)atomic_load(&m->id), strerror(errno));
+    journal_close(&m->journal);
+    m->journaled = false;
+    atomic_fetch_add(&counters.journal_errors, 1);
+}
+
+/**
+ * @brief Ouvre le journal d'une nouvelle partie, si le serveur en écrit.
+ * @param m La partie.
+ * @param id Son identifiant.
+ */
+static void match_journal_open(Match *m, uint32_t id) {
+    m->journaled = false;
+    const ServerConfig *cfg = srv.cfg;
+    if (!cfg->journal_dir) return;
+
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%lld-%08x.krj", cfg->journal_dir, (long long)time(NULL), (unsigned)id);
+    if (journal_open(&m->journal, path, id, cfg->journal_sync, cfg->journal_sync_ms) < 0) {
+        fprintf(stderr, "Erreur : journal %s impossible à créer (%s)\n", path, strerror(errno));
+        atomic_fetch_add(&counters.journal_errors, 1);
+        return;
+    }
+    m->journaled = true;
+}
+
+/**
+ * @brief Enregistre la fin d'une partie et ferme son journal.
+ * @param m La partie.
+ */
+static void match_journal_close(Match *m) {
+    if (!m->journaled) return;
+    if (journal_end(&m->journal, &m->state) < 0 || journal_close(&m->journal) < 0) {
+        fprintf(stderr, "Partie %08x : fin du journal perdue (%s)\n", (unsigned)atomic_load(&m->id), strerror(errno));
+        atomic_fetch_add(&counters.journal_errors, 1);
+    }
+    m->journaled = false;
+}
+
+// Joueurs
+
+/**
+ * @brief Choisit les événements surveillés sur le socket d'un joueur.
+ * @param w Le thread propriétaire.
+ * @param p Le joueur.
+ * @param out true pour surveiller aussi l'écriture.
+ */
+static void player_watch(Worker *w, Player *p, bool out) {
+    if (p->want_out == out) return;
+    struct epoll_event ev = { .events = EPOLLIN | EPOLLRDHUP | (out ? EPOLLOUT : 0), .data.ptr = p };
+    epoll_ctl(w->epfd, EPOLL_CTL_MOD, p->fd, &ev);
+    p->want_out = out;
+}
+/**
+ * @brief Envoie autant que possible du tampon de sortie d'un joueur.
+ * @param p Le joueur.
+ * @return false si la connexion est en erreur.
+ */
+static bool player_flush(Player *p) {
+    if (p->fd < 0) return true;
+    while (p->out.len > 0) {
+        ssize_t n = send(p->fd, p->out.buf, p->out.len, MSG_NOSIGNAL);
+        if (n > 0) {
+            proto_writer_consume(&p->out, (int)n);
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return true;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Ajoute une trame à envoyer à un joueur ; un joueur absent la manque.
+ * @param p Le joueur.
+ * @param msg La trame.
+ * @return 0 si succès (ou joueur absent), -1 si son tampon de sortie est plein.
+ */
+static int player_send(Player *p, const ProtoMsg *msg) {
+    if (p->fd < 0) return 0; // renvoyée par l'historique ou la position à la reprise
+    return proto_writer_push(&p->out, msg);
+}
+
+/**
+ * @brief Envoie les trames en attente d'un joueur et surveille l'écriture s'il en reste.
+ * @param w Le thread propriétaire.
+ * @param p Le joueur.
+ * @return false si la connexion est en erreur.
+ */
+static bool player_commit(Worker *w, Player *p) {
+    if (!player_flush(p)) return false;
+    if (p->out.len > 0 && p->fd >= 0) player_watch(w, p, true);
+    return true;
+}
+
+// Spectateurs
+
+/**
+ * @brief Code une trame dans une nouvelle `SharedFrame`.
+ * @param msg La trame (séquence et drapeaux compris).
+ * @return La trame partagée, retenue une fois, ou NULL en cas d'erreur.
+ */
+static SharedFrame *shared_frame_new(const ProtoMsg *msg) {
+    SharedFrame *f = malloc(sizeof(SharedFrame));
+    if (!f) return NULL;
+    f->len = proto_encode(msg, f->data, sizeof(f->data));
+    if (f->len < 0) {
+        free(f);
+        return NULL;
+    }
+    f->refs = 1;
+    return f;
+}
+
+/**
+ * @brief Relâche une `SharedFrame`, libérée quand plus personne ne la retient.
+ * @param f La trame, ou NULL.
+ */
+static void shared_frame_unref(SharedFrame *f) {
+    if (f && --f->refs == 0) free(f);
+}
+
+/**
+ * @brief Position courante d'une partie, codée au plus une fois par trame diffusée.
+ * @param m La partie.
+ * @return La trame STATE (retenue par la partie), ou NULL en cas d'erreur.
+ */
+static SharedFrame *match_snapshot(Match *m) {
+    if (!m->snapshot) {
+        ProtoMsg st = { .type = PROTO_STATE, .flags = PROTO_FLAG_BROADCAST, .seq = m->bseq, .u.state = m->state };
+        m->snapshot = shared_frame_new(&st);
+    }
+    return m->snapshot;
+}
+
+/**
+ * @brief Choisit les événements surveillés sur le socket d'un spectateur.
+ * @param w Le thread propriétaire.
+ * @param s Le spectateur.
+ * @param out true pour surveiller aussi l'écriture.
+ */
+static void spectator_watch(Worker *w, Spectator *s, bool out) {
+    if (s->want_out == out) return;
+    struct epoll_event ev = { .events = EPOLLIN | EPOLLRDHUP | (out ? EPOLLOUT : 0), .data.ptr = s };
+    epoll_ctl(w->epfd, EPOLL_CTL_MOD, s->fd, &ev);
+    s->want_out = out;
+}
+
+/**
+ * @brief Ferme un spectateur et le retire de sa partie ; il sera libéré à la fin du lot d'événements.
+ * @param w Le thread propriétaire.
+ * @param s Le spectateur.
+ */
+static void spectator_drop(Worker *w, Spectator *s) {
+    if (s->fd < 0) return;
+    Match *m = s->match;
+    if (s->prev) s->prev->next = s->next;
+    else m->spectators = s->next;
+    if (s->next) s->next->prev = s->prev;
+
+    epoll_ctl(w->epfd, EPOLL_CTL_DEL, s->fd, NULL);
+    close(s->fd);
+    s->fd = -1;
+    for (int i=0; i<s->count; i++) shared_frame_unref(s->queue[(s->head + i) % SRV_SPECTATOR_QUEUE]);
+    s->count = 0;
+    atomic_fetch_sub(&counters.watching, 1);
+    s->next = w->dead;
+    w->dead = s;
+}
+
+/**
+ * @brief Envoie autant que possible de la file d'un spectateur, en un appel par tour.
+ * @param s Le spectateur.
+ * @return false si la connexion est en erreur.
+ */
+static bool spectator_flush(Spectator *s) {
+    while (s->count > 0) {
+        struct iovec iov[SRV_SPECTATOR_QUEUE];
+        for (int i=0; i<s->count; i++) {
+            SharedFrame *f = s->queue[(s->head + i) % SRV_SPECTATOR_QUEUE];
+            int skip = i == 0 ? s->offset : 0;
+            iov[i].iov_base = f->data + skip;
+            iov[i].iov_len = (size_t)(f->len - skip);
+        }
+        struct msghdr msg = { .msg_iov = iov, .msg_iovlen = (size_t)s->count };
+        ssize_t n = sendmsg(s->fd, &msg, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return true;
+        if (n <= 0) return false;
+
+        // Retire les trames entièrement envoyées.
+        while (n > 0) {
+            SharedFrame *f = s->queue[s->head];
+            int left = f->len - s->offset;
+            if (n < left) {
+                s->offset += (int)n;
+                break;
+            }
+            n -= left;
+            s->offset = 0;
+            shared_frame_unref(f);
+            s->head = (s->head + 1) % SRV_SPECTATOR_QUEUE;
+            s->count--;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Envoie la file d'un spectateur et surveille l'écriture s'il en reste ; le ferme en cas d'erreur.
+ * @param w Le thread propriétaire.
+ * @param s Le spectateur.
+ */
+static void spectator_commit(Worker *w, Spectator *s) {
+    if (!spectator_flush(s)) {
+        spectator_drop(w, s);
+        return;
+    }
+    spectator_watch(w, s, s->count > 0);
+}
+
+/**
+ * @brief Remplace les trames en retard d'un spectateur par la position courante.
+ *
+ * Une trame déjà partiellement envoyée est gardée pour que le flux reste
+ * lisible. Au-delà de SRV_SPECTATOR_RESYNCS resynchronisations, le
+ * spectateur est déconnecté.
+ * @param w Le thread propriétaire.
+ * @param s Le spectateur.
+ */
+static void spectator_resync(Worker *w, Spectator *s) {
+    SharedFrame *snap = match_snapshot(s->match);
+    if (!snap || ++s->resyncs > SRV_SPECTATOR_RESYNCS) {
+        atomic_fetch_add(&counters.dropped, 1);
+        spectator_drop(w, s);
+        return;
+    }
+    int keep = s->offset > 0 ? 1 : 0;
+    for (int i=keep; i<s->count; i++) shared_frame_unref(s->queue[(s->head + i) % SRV_SPECTATOR_QUEUE]);
+    s->count = keep;
+    snap->refs++;
+    s->queue[(s->head + s->count) % SRV_SPECTATOR_QUEUE] = snap;
+    s->count++;
+    atomic_fetch_add(&counters.resyncs, 1);
+}
+
+/**
+ * @brief Ajoute une trame partagée à la file d'un spectateur, ou le resynchronise si elle est pleine.
+ * @param w Le thread propriétaire.
+ * @param s Le spectateur.
+ * @param f La trame.
+ */
+static void spectator_push(Worker *w, Spectator *s, SharedFrame *f) {
+    if (s->count == SRV_SPECTATOR_QUEUE) {
+        spectator_resync(w, s);
+        return;
+    }
+    f->refs++;
+    s->queue[(s->head + s->count) % SRV_SPECTATOR_QUEUE] = f;
+    s->count++;
+}
+
+/**
+ * @brief Lit et ignore ce qu'envoie un spectateur, pour détecter sa déconnexion.
+ * @param w Le thread propriétaire.
+ * @param s Le spectateur.
+ */
+static void spectator_read(Worker *w, Spectator *s) {
+    uint8_t scratch[256];
+    for (;;) {
+        ssize_t n = recv(s->fd, scratch, sizeof(scratch), 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+        if (n <= 0) {
+            spectator_drop(w, s);
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Traite un événement epoll concernant un spectateur.
+ * @param w Le thread propriétaire.
+ * @param s Le spectateur.
+ * @param events Les événements signalés.
+ */
+static void spectator_event(Worker *w, Spectator *s, uint32_t events) {
+    if (s->fd < 0) return; // fermé plus tôt dans le même lot
+    if (events & (EPOLLOUT | EPOLLERR)) {
+        spectator_commit(w, s);
+        if (s->fd < 0) return;
+    }
+    if (events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) spectator_read(w, s);
+}
+
+/**
+ * @brief Rattache à sa partie un spectateur confié par le thread d'acceptation.
+ *
+ * Le spectateur reçoit la position courante, puis les trames diffusées.
+ * @param w Le thread propriétaire de la partie.
+ * @param s Le spectateur.
+ */
+static void spectator_attach(Worker *w, Spectator *s) {
+    Match *m = &srv.slab[s->game & 0xFFFF];
+    // La partie a pu se terminer, et sa place resservir, depuis l'aiguillage.
+    if (atomic_load(&m->id) != s->game || m->ending) {
+        reject_connection(s->fd, PROTO_ERR_NO_GAME);
+        free(s);
+        return;
+    }
+
+    s->match = m;
+    s->prev = NULL;
+    s->next = m->spectators;
+    if (s->next) s->next->prev = s;
+    m->spectators = s;
+    atomic_fetch_add(&counters.spectators, 1);
+    atomic_fetch_add(&counters.watching, 1);
+
+    struct epoll_event ev = { .events = EPOLLIN | EPOLLRDHUP, .data.ptr = s };
+    SharedFrame *snap = match_snapshot(m);
+    if (!snap || epoll_ctl(w->epfd, EPOLL_CTL_ADD, s->fd, &ev) < 0) {
+        spectator_drop(w, s);
+        return;
+    }
+    spectator_push(w, s, snap);
+    spectator_commit(w, s);
+}
+
+/**
+ * @brief Réveille un thread de traitement dont la boîte aux lettres a reçu un dépôt.
+ * @param w Le thread.
+ */
+static void worker_notify(Worker *w) {
+    uint64_t one = 1;
+    if (write(w->inbox_fd, &one, sizeof(one)) < 0) {
+        // Rien à faire : le compteur de l'eventfd est déjà non nul.
+    }
+}
+
+/**
+ * @brief Dépose un spectateur dans la boîte aux lettres d'un thread de traitement.
+ * @param w Le thread de la partie demandée.
+ * @param s Le spectateur.
+ */
+static void worker_post(Worker *w, Spectator *s) {
+    pthread_mutex_lock(&w->inbox_lock);
+    s->next = w->inbox;
+    w->inbox = s;
+    pthread_mutex_unlock(&w->inbox_lock);
+    worker_notify(w);
+}
+
+/**
+ * @brief Dépose une demande de reprise dans la boîte aux lettres d'un thread de traitement.
+ * @param w Le thread de la partie demandée.
+ * @param r La demande.
+ */
+static void worker_post_resume(Worker *w, Resume *r) {
+    pthread_mutex_lock(&w->inbox_lock);
+    r->next = w->resumes;
+    w->resumes = r;
+    pthread_mutex_unlock(&w->inbox_lock);
+    worker_notify(w);
+}
+
+/**
+ * @brief Dépose une partie formée dans la boîte aux lettres de son thread de traitement.
+ * @param w Le thread choisi.
+ * @param m La partie, dont les sockets ne sont encore dans aucun epoll.
+ */
+static void worker_post_match(Worker *w, Match *m) {
+    pthread_mutex_lock(&w->inbox_lock);
+    m->inbox_next = w->starts;
+    w->starts = m;
+    pthread_mutex_unlock(&w->inbox_lock);
+    worker_notify(w);
+}
+
+/**
+ * @brief Diffuse une trame aux spectateurs d'une partie.
+ *
+ * La trame est codée une fois, avec la séquence de diffusion suivante, et
+ * placée dans la file de chaque spectateur ; l'envoi a lieu à la fin du lot.
+ * @param w Le thread propriétaire.
+ * @param m La partie, dont la position inclut déjà la trame.
+ * @param msg La trame reçue d'un joueur.
+ */
+static void match_broadcast(Worker *w, Match *m, const ProtoMsg *msg) {
+    m->bseq++;
+    shared_frame_unref(m->snapshot);
+    m->snapshot = NULL;
+    if (!m->spectators) return;
+
+    ProtoMsg framed = *msg;
+    framed.flags = PROTO_FLAG_BROADCAST;
+    framed.seq = m->bseq;
+    SharedFrame *f = shared_frame_new(&framed);
+    for (Spectator *s = m->spectators, *next; s; s = next) {
+        next = s->next;
+        if (f) spectator_push(w, s, f);
+        else spectator_resync(w, s);
+    }
+    shared_frame_unref(f);
+}
+
+/**
+ * @brief Envoie les files des spectateurs d'une partie qui n'attendent pas déjà l'écriture.
+ * @param w Le thread propriétaire.
+ * @param m La partie.
+ */
+static void match_flush_spectators(Worker *w, Match *m) {
+    for (Spectator *s = m->spectators, *next; s; s = next) {
+        next = s->next;
+        if (s->count > 0 && !s->want_out) spectator_commit(w, s);
+    }
+}
+
+// Parties
+
+/**
+ * @brief Retire une partie de la liste d'attente de son thread.
+ * @param w Le thread propriétaire.
+ * @param m La partie (sans effet si elle n'attend personne).
+ */
+static void match_unsuspend(Worker *w, Match *m) {
+    if (!m->suspended) return;
+    if (m->susp_prev) m->susp_prev->susp_next = m->susp_next;
+    else w->susp_head = m->susp_next;
+    if (m->susp_next) m->susp_next->susp_prev = m->susp_prev;
+    else w->susp_tail = m->susp_prev;
+    m->suspended = false;
+}
+
+/**
+ * @brief Ajoute une partie en fin de liste d'attente, avec une échéance de SRV_RESUME_TIMEOUT_MS.
+ *
+ * L'échéance étant la même pour toutes, la liste reste triée.
+ * @param w Le thread propriétaire.
+ * @param m La partie (sans effet si elle attend déjà).
+ */
+static void match_suspend(Worker *w, Match *m) {
+    if (m->suspended) return;
+    m->resume_deadline_us = now_us() + (int64_t)SRV_RESUME_TIMEOUT_MS * 1000;
+    m->susp_prev = w->susp_tail;
+    m->susp_next = NULL;
+    if (w->susp_tail) w->susp_tail->susp_next = m;
+    else w->susp_head = m;
+    w->susp_tail = m;
+    m->suspended = true;
+}
+
+/**
+ * @brief Ferme les sockets d'une partie ; sa place sera libérée à la fin du lot d'événements.
+ * @param w Le thread propriétaire.
+ * @param m La partie.
+ * @param finished true si la partie s'est terminée selon les règles.
+ */
+static void match_close(Worker *w, Match *m, bool finished) {
+    if (!m->live) return;
+    match_unsuspend(w, m);
+    for (int k=0; k<2; k++) {
+        if (m->players[k].fd < 0) continue; // joueur absent
+        epoll_ctl(w->epfd, EPOLL_CTL_DEL, m->players[k].fd, NULL);
+        close(m->players[k].fd);
+    }
+    // Dernier envoi au mieux : le coup final est peut-être encore en file.
+    while (m->spectators) {
+        Spectator *s = m->spectators;
+        (void)spectator_flush(s);
+        spectator_drop(w, s);
+    }
+    shared_frame_unref(m->snapshot);
+    m->snapshot = NULL;
+    match_journal_close(m);
+    atomic_store(&m->id, 0);
+    m->live = false;
+    atomic_fetch_add(finished ? &counters.finished : &counters.aborted, 1);
+    atomic_fetch_sub(&counters.active, 1);
+    w->closed[w->nclosed++] = m;
+}
+
+/**
+ * @brief Termine une partie dont le résultat est connu, une fois les derniers coups envoyés.
+ *
+ * Les joueurs dont le tampon de sortie est vide ne sont plus surveillés ;
+ * la partie est fermée dès que les deux tampons sont vides.
+ * @param w Le thread propriétaire.
+ * @param m La partie.
+ */
+static void match_finish(Worker *w, Match *m) {
+    m->ending = true;
+    bool pending = false;
+    for (int k=0; k<2; k++) {
+        Player *p = &m->players[k];
+        if (p->fd < 0) continue; // joueur absent : il ne recevra pas la fin
+        if (p->out.len == 0) {
+            epoll_ctl(w->epfd, EPOLL_CTL_DEL, p->fd, NULL);
+        } else {
+            struct epoll_event ev = { .events = EPOLLOUT, .data.ptr = p };
+            epoll_ctl(w->epfd, EPOLL_CTL_MOD, p->fd, &ev);
+            pending = true;
+        }
+    }
+    if (!pending) match_close(w, m, true);
+}
+
+/**
+ * @brief Signale une erreur de protocole à un joueur et interrompt sa partie.
+ * @param w Le thread propriétaire.
+ * @param p Le joueur fautif.
+ * @param code Un `ProtoError`.
+ */
+static void match_error(Worker *w, Player *p, int code) {
+    ProtoMsg err = { .type = PROTO_ERROR, .u.error = (uint8_t)code };
+    if (proto_writer_push(&p->out, &err) == 0) player_flush(p); // au mieux : la partie est fermée
+    match_close(w, p->match, false);
+}
+
+/**
+ * @brief Traite la perte de la connexion d'un joueur.
+ *
+ * En cours de partie, un joueur qui a un jeton garde sa place : son socket
+ * est fermé et la partie attend sa reprise. Sinon la partie est fermée.
+ * @param w Le thread propriétaire.
+ * @param p Le joueur.
+ */
+static void player_lost(Worker *w, Player *p) {
+    Match *m = p->match;
+    if (p->fd < 0) return;
+    if (m->ending || m->state.game_over_status != 0 || p->token == 0) {
+        match_close(w, m, m->ending);
+        return;
+    }
+    epoll_ctl(w->epfd, EPOLL_CTL_DEL, p->fd, NULL);
+    close(p->fd);
+    p->fd = -1;
+    p->want_out = false;
+    proto_reader_init(&p->in);
+    proto_writer_init(&p->out);
+    match_suspend(w, m);
+}
+
+/**
+ * @brief Joue un coup reçu d'un joueur et le relaie à son adversaire et aux spectateurs.
+ *
+ * Un coup joué hors de son tour, ou refusé par les règles, interrompt la partie.
+ * @param w Le thread propriétaire.
+ * @param p Le joueur.
+ * @param msg La trame MOVE.
+ * @return true si la partie continue.
+ */
+static bool match_play(Worker *w, Player *p, const ProtoMsg *msg) {
+    Match *m = p->match;
+    bool own_turn = (m->state.tour % 2 != 0) == (p->side == 0);
+
+    if (!own_turn || logique_jouer_coup(&m->state, msg->u.move.from, msg->u.move.to) < 0) {
+        char from[3], to[3];
+        geo_id_depuis_index(msg->u.move.from, from);
+        geo_id_depuis_index(msg->u.move.to, to);
+        fprintf(stderr, "Partie %d : coup %s%s refusé\n", (int)(m - srv.slab), from, to);
+        match_error(w, p, own_turn ? PROTO_ERR_ILLEGAL : PROTO_ERR_TURN);
+        return false;
+    }
+    atomic_fetch_add(&counters.moves, 1);
+    if (m->journaled && journal_move(&m->journal, &m->state, msg->u.move.from, msg->u.move.to) < 0)
+        match_journal_fail(m);
+    if (m->plies < SRV_HISTORY) {
+        m->history[m->plies][0] = msg->u.move.from;
+        m->history[m->plies][1] = msg->u.move.to;
+    }
+    m->plies++;
+
+    Player *opp = &m->players[1 - p->side];
+    if (player_send(opp, msg) < 0) player_lost(w, opp); // l'adversaire ne lit plus : il reprendra
+    if (!m->live) return false;
+    match_broadcast(w, m, msg);
+    return true;
+}
+
+/**
+ * @brief Traite une trame reçue d'un joueur.
+ * @param w Le thread propriétaire.
+ * @param p Le joueur.
+ * @param msg La trame.
+ * @return true si la partie continue.
+ */
+static bool player_frame(Worker *w, Player *p, const ProtoMsg *msg) {
+    Match *m = p->match;
+    Player *opp = &m->players[1 - p->side];
+
+    switch (msg->type) {
+        case PROTO_MOVE:
+            return match_play(w, p, msg);
+        case PROTO_RESIGN:
+        case PROTO_CLOCK:
+            if (player_send(opp, msg) < 0) player_lost(w, opp);
+            if (!m->live) return false;
+            if (msg->type == PROTO_RESIGN) m->state.game_over_status = p->side == 0 ? 1 : 2;
+            match_broadcast(w, m, msg);
+            return true;
+        case PROTO_PING: {
+            ProtoMsg pong = { .type = PROTO_PONG, .u.ping = msg->u.ping };
+            if (proto_writer_push(&p->out, &pong) < 0) {
+                player_lost(w, p); // le joueur ne lit plus
+                return false;
+            }
+            return true;
+        }
+        case PROTO_PONG:
+            return true;
+        case PROTO_ERROR:
+            match_close(w, m, false);
+            return false;
+        default:
+            match_error(w, p, PROTO_ERR_MALFORMED);
+            return false;
+    }
+}
+
+/**
+ * @brief Lit tout ce que le socket d'un joueur a reçu et traite les trames complètes.
+ *
+ * Les trames destinées aux deux joueurs sont envoyées après chaque lecture,
+ * en un appel par socket, puis celles des spectateurs. Une fermeture ou une
+ * erreur de la connexion met la partie en attente de la reprise du joueur ;
+ * une trame invalide l'interrompt.
+ * @param w Le thread propriétaire.
+ * @param p Le joueur.
+ */
+static void player_read(Worker *w, Player *p) {
+    Match *m = p->match;
+    Player *opp = &m->players[1 - p->side];
+    for (;;) {
+        ssize_t n = recv(p->fd, p->in.buf + p->in.len, PROTO_BUF_SIZE - p->in.len, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+        if (n <= 0) {
+            player_lost(w, p);
+            return;
+        }
+        p->in.len += (int)n;
+
+        ProtoMsg msg;
+        int got = 0;
+        // Les trames qui suivent la fin de la partie sont ignorées.
+        while (m->state.game_over_status == 0 && (got = proto_reader_next(&p->in, &msg)) > 0)
+            if (!player_frame(w, p, &msg)) break;
+        if (!m->live) return;
+        if (p->fd >= 0 && got < 0) {
+            match_error(w, p, -got);
+            return;
+        }
+
+        // Le journal d'abord : un coup n'est relayé qu'une fois enregistré.
+        if (m->journaled && journal_flush(&m->journal) < 0) match_journal_fail(m);
+        bool lost = !player_commit(w, p);
+        if (!player_commit(w, opp)) player_lost(w, opp);
+        if (lost) player_lost(w, p);
+        if (!m->live) return;
+        match_flush_spectators(w, m);
+        if (p->fd < 0) return;
+        if (m->state.game_over_status != 0) {
+            match_finish(w, m);
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Traite un événement epoll concernant un joueur.
+ * @param w Le thread propriétaire.
+ * @param p Le joueur.
+ * @param events Les événements signalés.
+ */
+static void player_event(Worker *w, Player *p, uint32_t events) {
+    Match *m = p->match;
+    if (!m->live) return; // partie fermée plus tôt dans le même lot
+
+    if (p->fd < 0) return; // joueur perdu plus tôt dans le même lot
+    if (events & (EPOLLOUT | EPOLLERR)) {
+        if (!player_flush(p)) {
+            player_lost(w, p);
+            return;
+        }
+        if (p->out.len == 0 && m->ending) {
+            epoll_ctl(w->epfd, EPOLL_CTL_DEL, p->fd, NULL);
+            if (m->players[1 - p->side].out.len == 0) match_close(w, m, true);
+            return;
+        }
+        if (p->out.len == 0) player_watch(w, p, false);
+    }
+    if (!m->ending && (events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)))
+        player_read(w, p);
+}
+
+/**
+ * @brief Rend sa place à un joueur reconnecté, si son jeton est celui d'un joueur de la partie.
+ *
+ * L'ancienne connexion du joueur, si le serveur ne l'a pas encore vue
+ * tomber, est remplacée. Le joueur reçoit HELLO, les coups qu'il n'a pas
+ * reçus (si l'historique les contient), puis la position, qui fait foi.
+ * @param w Le thread propriétaire de la partie.
+ * @param r La demande, libérée au retour.
+ */
+static void player_resume(Worker *w, Resume *r) {
+    Match *m = &srv.slab[r->game & 0xFFFF];
+    int k = -1;
+    // La partie a pu se terminer, et sa place resservir, depuis l'aiguillage.
+    if (atomic_load(&m->id) == r->game && !m->ending && m->state.game_over_status == 0)
+        for (int i=0; i<2; i++)
+            if (m->players[i].token != 0 && m->players[i].token == r->token) k = i;
+    if (k < 0) {
+        reject_connection(r->fd, PROTO_ERR_NO_GAME);
+        free(r);
+        return;
+    }
+
+    Player *p = &m->players[k];
+    if (p->fd >= 0) {
+        epoll_ctl(w->epfd, EPOLL_CTL_DEL, p->fd, NULL);
+        close(p->fd);
+    }
+    p->fd = r->fd;
+    p->want_out = false;
+    proto_reader_init(&p->in);
+    p->in.next_seq = 2; // les trames HELLO et RESUME sont déjà lues
+    proto_writer_init(&p->out);
+
+    ProtoMsg hello = { .type = PROTO_HELLO, .u.hello = { PROTO_VERSION, k == 0 ? PROTO_ROLE_BLUE : PROTO_ROLE_RED } };
+    proto_writer_push(&p->out, &hello);
+    if (r->plies <= (uint32_t)m->plies && m->plies <= SRV_HISTORY) {
+        for (int i=(int)r->plies; i<m->plies; i++) {
+            ProtoMsg mv = { .type = PROTO_MOVE, .u.move = { m->history[i][0], m->history[i][1] } };
+            proto_writer_push(&p->out, &mv);
+        }
+    }
+    ProtoMsg st = { .type = PROTO_STATE, .u.state = m->state };
+    proto_writer_push(&p->out, &st);
+    free(r);
+
+    if (m->players[1 - k].fd >= 0) match_unsuspend(w, m);
+    struct epoll_event ev = { .events = EPOLLIN | EPOLLRDHUP, .data.ptr = p };
+    if (epoll_ctl(w->epfd, EPOLL_CTL_ADD, p->fd, &ev) < 0 || !player_commit(w, p)) {
+        player_lost(w, p);
+        return;
+    }
+    atomic_fetch_add(&counters.resumed, 1);
+}
+
+/**
+ * @brief Surveille les sockets d'une partie reçue du thread d'acceptation.
+ *
+ * Si l'un des sockets ne peut être ajouté, la partie est interrompue. Le
+ * lot en cours a été relevé avant l'ajout : aucun de ses événements ne
+ * désigne la partie, dont la place est rendue aussitôt.
+ * @param w Le thread propriétaire.
+ * @param m La partie.
+ */
+static void match_attach(Worker *w, Match *m) {
+    for (int k=0; k<2; k++) {
+        Player *p = &m->players[k];
+        struct epoll_event ev = { .events = EPOLLIN | EPOLLRDHUP | (p->want_out ? EPOLLOUT : 0), .data.ptr = p };
+        if (epoll_ctl(w->epfd, EPOLL_CTL_ADD, p->fd, &ev) == 0) continue;
+
+        for (int j=0; j<2; j++) {
+            if (j < k) epoll_ctl(w->epfd, EPOLL_CTL_DEL, m->players[j].fd, NULL);
+            close(m->players[j].fd);
+        }
+        match_journal_close(m);
+        atomic_store(&m->id, 0);
+        m->live = false;
+        atomic_fetch_add(&counters.aborted, 1);
+        atomic_fetch_sub(&counters.active, 1);
+        slab_free(m);
+        return;
+    }
+}
+
+/**
+ * @brief Traite les dépôts de la boîte aux lettres d'un thread : parties, spectateurs et reprises.
+ *
+ * Les parties passent en premier : un spectateur ou une reprise déposés
+ * après une partie la trouvent surveillée.
+ * @param w Le thread.
+ */
+static void worker_inbox(Worker *w) {
+    uint64_t count;
+    if (read(w->inbox_fd, &count, sizeof(count)) < 0) {
+        // Rien à faire : les listes sont relevées quoi qu'il en soit.
+    }
+    pthread_mutex_lock(&w->inbox_lock);
+    Match *m = w->starts;
+    Spectator *s = w->inbox;
+    Resume *r = w->resumes;
+    w->starts = NULL;
+    w->inbox = NULL;
+    w->resumes = NULL;
+    pthread_mutex_unlock(&w->inbox_lock);
+
+    while (m) {
+        Match *next = m->inbox_next;
+        match_attach(w, m);
+        m = next;
+    }
+
+    while (s) {
+        Spectator *next = s->next;
+        spectator_attach(w, s);
+        s = next;
+    }
+    while (r) {
+        Resume *next = r->next;
+        player_resume(w, r);
+        r = next;
+    }
+}
+
+/**
+ * @brief Délai avant la prochaine échéance de la liste d'attente d'un thread.
+ * @param w Le thread.
+ * @return Le délai pour `epoll_wait`, en millisecondes (-1 si aucune partie n'attend).
+ */
+static int worker_timeout(const Worker *w) {
+    if (!w->susp_head) return -1;
+    int64_t left = w->susp_head->resume_deadline_us - now_us();
+    return left > 0 ? (int)((left + 999) / 1000) : 0;
+}
+
+/**
+ * @brief Interrompt les parties dont le joueur absent n'est pas revenu à temps.
+ *
+ * Au plus les places restantes de `closed` sont traitées ; les suivantes
+ * le seront au prochain lot, dont l'attente est alors nulle.
+ * @param w Le thread.
+ */
+static void worker_expire(Worker *w) {
+    int64_t now = now_us();
+    while (w->susp_head && w->susp_head->resume_deadline_us <= now && w->nclosed < SRV_EVENTS)
+        match_close(w, w->susp_head, false);
+}
+
+/**
+ * @brief Corps d'un thread de traitement.
+ *
+ * Les places des parties fermées pendant un lot, et les spectateurs fermés,
+ * ne sont rendus qu'à la fin du lot : un événement du même lot peut encore
+ * les désigner.
+ * @param arg Le `Worker`.
+ * @return NULL.
+ */
+static void *worker_main(void *arg) {
+    Worker *w = arg;
+    struct epoll_event events[SRV_EVENTS];
+    bool stop = false;
+
+    while (!stop) {
+        int n = epoll_wait(w->epfd, events, SRV_EVENTS, worker_timeout(w));
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            perror("epoll_wait");
+            break;
+        }
+
+        w->nclosed = 0;
+        for (int i=0; i<n; i++) {
+            void *ptr = events[i].data.ptr;
+            if (!ptr) {
+                stop = true; // eventfd d'arrêt
+                continue;
+            }
+            switch (*(ConnKind *)ptr) {
+                case CONN_PLAYER:    player_event(w, ptr, events[i].events); break;
+                case CONN_SPECTATOR: spectator_event(w, ptr, events[i].events); break;
+                case CONN_INBOX:     worker_inbox(w); break;
+            }
+        }
+        worker_expire(w);
+        for (int i=0; i<w->nclosed; i++) slab_free(w->closed[i]);
+        while (w->dead) {
+            Spectator *s = w->dead;
+            w->dead = s->next;
+            free(s);
+        }
+    }
+    return NULL;
+}
+
+// Acceptation et appariement
+
+/**
+ * @brief Forme une partie avec deux connexions et la confie à un thread de traitement.
+ *
+ * Chaque joueur reçoit aussitôt sa trame HELLO, qui lui indique sa couleur,
+ * puis sa trame SESSION avec son jeton de reprise. Les sockets sont
+ * ensuite confiés au thread, qui les ajoute lui-même à son epoll
+ * (`match_attach`) : aucun événement ne peut le faire agir sur une partie
+ * à moitié inscrite.
+ * @param blue Le socket du premier arrivé (bleus), dont la trame HELLO est lue.
+ * @param red Le socket du second (rouges), dont la trame HELLO est lue.
+ * @param w Le thread choisi.
+ * @return L'identifiant de la partie, ou 0 si le tableau est plein (rien n'est fermé).
+ */
+static uint32_t match_start(int blue, int red, Worker *w) {
+    Match *m = slab_alloc();
+    if (!m) return 0;
+
+    logique_init_game(&m->state);
+    m->live = true;
+    m->ending = false;
+    m->owner = w;
+    m->spectators = NULL;
+    m->snapshot = NULL;
+    m->bseq = 0;
+    m->plies = 0;
+    m->suspended = false;
+    if (++m->generation == 0) m->generation = 1;
+    uint32_t id = (uint32_t)m->generation << 16 | (uint32_t)(m - srv.slab);
+    match_journal_open(m, id);
+    // Publié avant que le thread de traitement ne puisse fermer la partie.
+    atomic_store(&m->id, id);
+
+    int fds[2] = { blue, red };
+    uint64_t tokens[2];
+    if (getrandom(tokens, sizeof(tokens), 0) != (ssize_t)sizeof(tokens)) tokens[0] = tokens[1] = 0; // pas de reprise
+    for (int k=0; k<2; k++) {
+        Player *p = &m->players[k];
+        p->kind = CONN_PLAYER;
+        p->fd = fds[k];
+        p->side = k;
+        p->token = tokens[k];
+        p->match = m;
+        proto_reader_init(&p->in);
+        p->in.next_seq = 1; // la trame HELLO est déjà lue
+        proto_writer_init(&p->out);
+
+        ProtoMsg hello = { .type = PROTO_HELLO,
+                           .u.hello = { PROTO_VERSION, k == 0 ? PROTO_ROLE_BLUE : PROTO_ROLE_RED } };
+        proto_writer_push(&p->out, &hello);
+        if (p->token != 0) {
+            ProtoMsg session = { .type = PROTO_SESSION, .u.session = { id, p->token, 0 } };
+            proto_writer_push(&p->out, &session);
+        }
+        if (!player_flush(p)) p->out.len = 0; // l'erreur sera signalée par la lecture
+        p->want_out = p->out.len > 0;
+    }
+
+    atomic_fetch_add(&counters.started, 1);
+    atomic_fetch_add(&counters.active, 1);
+    worker_post_match(w, m);
+    return id;
+}
+
+/**
+ * @brief Thread de traitement d'une partie en cours.
+ * @param id L'identifiant de la partie.
+ * @return Le thread, ou NULL si aucune partie en cours ne porte cet identifiant.
+ */
+static Worker *match_lookup(uint32_t id) {
+    uint32_t slot = id & 0xFFFF;
+    if (id == 0 || slot >= (uint32_t)srv.capacity) return NULL;
+    Match *m = &srv.slab[slot];
+    return atomic_load(&m->id) == id ? m->owner : NULL;
+}
+
+/**
+ * @brief Inscrit une connexion acceptée en attente de sa première trame.
+ * @param fd Le socket.
+ */
+static void lobby_add(int fd) {
+    Pending *p = malloc(sizeof(Pending));
+    if (!p) {
+        close(fd);
+        return;
+    }
+    p->fd = fd;
+    p->deadline_us = now_us() + (int64_t)SRV_HANDSHAKE_TIMEOUT_MS * 1000;
+    p->expect = PROTO_HELLO;
+    proto_reader_init(&p->in);
+
+    struct epoll_event ev = { .events = EPOLLIN | EPOLLRDHUP, .data.ptr = p };
+    if (epoll_ctl(srv.lobby_fd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+        close(fd);
+        free(p);
+        return;
+    }
+    // L'échéance étant la même pour toutes, la liste reste triée.
+    p->prev = srv.lobby_tail;
+    p->next = NULL;
+    if (srv.lobby_tail) srv.lobby_tail->next = p;
+    else srv.lobby = p;
+    srv.lobby_tail = p;
+}
+
+/**
+ * @brief Oublie une connexion en attente, déjà retirée de l'epoll d'acceptation ; elle sera libérée à la fin du lot d'événements.
+ * @param p La connexion, dont le socket est fermé ou transmis à un thread de traitement.
+ */
+static void lobby_forget(Pending *p) {
+    if (p->prev) p->prev->next = p->next;
+    else srv.lobby = p->next;
+    if (p->next) p->next->prev = p->prev;
+    else srv.lobby_tail = p->prev;
+    if (srv.waiting == p) srv.waiting = NULL;
+    p->fd = -1;
+    p->next = srv.lobby_dead;
+    srv.lobby_dead = p;
+}
+
+/**
+ * @brief Retire une connexion de l'attente.
+ * @param p La connexion.
+ * @param close_fd true pour fermer le socket, false s'il va être transmis ou refusé.
+ */
+static void lobby_remove(Pending *p, bool close_fd) {
+    if (p->fd < 0) return;
+    epoll_ctl(srv.lobby_fd, EPOLL_CTL_DEL, p->fd, NULL);
+    if (close_fd) close(p->fd);
+    lobby_forget(p);
+}
+
+/**
+ * @brief Refuse une connexion en attente avec une trame ERROR.
+ * @param p La connexion.
+ * @param code Un `ProtoError`.
+ */
+static void lobby_reject(Pending *p, int code) {
+    int fd = p->fd;
+    lobby_remove(p, false);
+    reject_connection(fd, code);
+}
+
+/**
+ * @brief Apparie un joueur dont la trame HELLO est lue, ou le met en attente d'un adversaire.
+ * @param p Le joueur.
+ */
+static void lobby_pair(Pending *p) {
+    Pending *blue = srv.waiting;
+    if (!blue) {
+        // Seule la déconnexion intéresse avant l'appariement : les coups
+        // déjà envoyés attendent dans le socket.
+        struct epoll_event ev = { .events = EPOLLRDHUP, .data.ptr = p };
+        epoll_ctl(srv.lobby_fd, EPOLL_CTL_MOD, p->fd, &ev);
+        srv.waiting = p;
+        return;
+    }
+
+    // Les sockets quittent l'epoll d'acceptation avant que le thread de
+    // traitement ne puisse les fermer.
+    epoll_ctl(srv.lobby_fd, EPOLL_CTL_DEL, blue->fd, NULL);
+    epoll_ctl(srv.lobby_fd, EPOLL_CTL_DEL, p->fd, NULL);
+    uint32_t id = match_start(blue->fd, p->fd, &srv.workers[srv.next_worker]);
+    if (id == 0) {
+        atomic_fetch_add(&counters.refused, 1);
+        struct epoll_event ev = { .events = EPOLLRDHUP, .data.ptr = blue };
+        epoll_ctl(srv.lobby_fd, EPOLL_CTL_ADD, blue->fd, &ev);
+        lobby_remove(p, true);
+        return;
+    }
+    lobby_forget(blue);
+    lobby_forget(p);
+    srv.latest = id;
+    srv.next_worker = (srv.next_worker + 1) % srv.nworkers;
+}
+
+/**
+ * @brief Confie un spectateur au thread de la partie demandée.
+ * @param p La connexion, dont les trames HELLO et WATCH sont lues.
+ * @param game L'identifiant demandé, ou PROTO_WATCH_LATEST.
+ */
+static void lobby_watch(Pending *p, uint32_t game) {
+    if (game == PROTO_WATCH_LATEST) game = srv.latest;
+    Worker *w = match_lookup(game);
+    Spectator *s = w ? calloc(1, sizeof(Spectator)) : NULL;
+    if (!s) {
+        lobby_reject(p, PROTO_ERR_NO_GAME);
+        return;
+    }
+    s->kind = CONN_SPECTATOR;
+    s->fd = p->fd;
+    s->game = game;
+    lobby_remove(p, false);
+    worker_post(w, s);
+}
+
+/**
+ * @brief Confie une demande de reprise au thread de la partie, qui vérifiera le jeton.
+ * @param p La connexion, dont les trames HELLO et RESUME sont lues.
+ * @param msg La trame RESUME.
+ */
+static void lobby_resume(Pending *p, const ProtoMsg *msg) {
+    Worker *w = match_lookup(msg->u.session.game);
+    Resume *r = w ? malloc(sizeof(Resume)) : NULL;
+    if (!r) {
+        lobby_reject(p, PROTO_ERR_NO_GAME);
+        return;
+    }
+    r->fd = p->fd;
+    r->game = msg->u.session.game;
+    r->token = msg->u.session.token;
+    r->plies = msg->u.session.plies;
+    lobby_remove(p, false);
+    worker_post_resume(w, r);
+}
+
+/**
+ * @brief Lit la trame HELLO, puis WATCH ou RESUME selon le rôle, d'une connexion en attente.
+ *
+ * Seules ces trames sont lues, en-tête puis contenu annoncé : la suite du
+ * flux reste dans le socket pour le thread de traitement.
+ * @param p La connexion.
+ */
+static void lobby_read(Pending *p) {
+    for (;;) {
+        int want = PROTO_HEADER_SIZE;
+        if (p->in.len >= PROTO_HEADER_SIZE) want += p->in.buf[0] << 8 | p->in.buf[1];
+        if (want > PROTO_FRAME_MAX) want = PROTO_FRAME_MAX; // refusée par le décodage
+        ssize_t n = recv(p->fd, p->in.buf + p->in.len, want - p->in.len, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+        if (n <= 0) {
+            lobby_remove(p, true);
+            return;
+        }
+        p->in.len += (int)n;
+
+        ProtoMsg msg;
+        int got = proto_reader_next(&p->in, &msg);
+        if (got == 0) continue;
+        if (got < 0) {
+            lobby_reject(p, -got);
+            return;
+        }
+
+        if (p->expect != PROTO_HELLO) {
+            if (msg.type != p->expect) lobby_reject(p, PROTO_ERR_MALFORMED);
+            else if (msg.type == PROTO_WATCH) lobby_watch(p, msg.u.game);
+            else lobby_resume(p, &msg);
+            return;
+        }
+        if (msg.type != PROTO_HELLO || msg.u.hello.role > PROTO_ROLE_RESUME) {
+            lobby_reject(p, PROTO_ERR_MALFORMED);
+            return;
+        }
+        if (msg.u.hello.version != PROTO_VERSION) {
+            lobby_reject(p, PROTO_ERR_VERSION);
+            return;
+        }
+        if (msg.u.hello.role == PROTO_ROLE_SPECTATOR) p->expect = PROTO_WATCH;
+        else if (msg.u.hello.role == PROTO_ROLE_RESUME) p->expect = PROTO_RESUME;
+        else {
+            lobby_pair(p);
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Traite un événement epoll concernant une connexion en attente.
+ * @param p La connexion.
+ * @param events Les événements signalés.
+ */
+static void lobby_event(Pending *p, uint32_t events) {
+    if (p->fd < 0) return; // retirée plus tôt dans le même lot
+    if (p == srv.waiting) {
+        // Le joueur en attente est parti avant d'avoir un adversaire.
+        lobby_remove(p, true);
+        return;
+    }
+    if (events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) lobby_read(p);
+}
+
+/**
+ * @brief Délai avant la prochaine échéance des connexions en attente de leurs premières trames.
+ * @return Le délai pour `epoll_wait`, en millisecondes (-1 si aucune connexion n'attend).
+ */
+static int lobby_timeout(void) {
+    Pending *p = srv.lobby;
+    if (p && p == srv.waiting) p = p->next;
+    if (!p) return -1;
+    int64_t left = p->deadline_us - now_us();
+    return left > 0 ? (int)((left + 999) / 1000) : 0;
+}
+
+/**
+ * @brief Ferme les connexions qui n'ont pas achevé leur présentation à temps.
+ *
+ * Le joueur en attente d'un adversaire a envoyé sa trame HELLO : il reste.
+ */
+static void lobby_expire(void) {
+    int64_t now = now_us();
+    for (Pending *p = srv.lobby, *next; p && (p == srv.waiting || p->deadline_us <= now); p = next) {
+        next = p->next;
+        if (p != srv.waiting) lobby_remove(p, true);
+    }
+}
+
+/**
+ * @brief Crée le socket d'écoute, non bloquant.
+ * @param port Le port TCP.
+ * @return Le socket, ou -1 en cas d'erreur.
+ */
+static int listen_socket(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+
+    int opt = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = INADDR_ANY;
+    addr.sin_port = htons(port);
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(fd, SRV_LISTEN_BACKLOG) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/**
+ * @brief Ferme un spectateur qui n'a pas été libéré par un thread de traitement.
+ * @param s Le spectateur.
+ */
+static void spectator_free(Spectator *s) {
+    if (s->fd >= 0) close(s->fd);
+    for (int i=0; i<s->count; i++) shared_frame_unref(s->queue[(s->head + i) % SRV_SPECTATOR_QUEUE]);
+    free(s);
+}
+
+/**
+ * @brief Libère les ressources du serveur (threads déjà rejoints).
+ */
+static void server_cleanup(void) {
+    for (int i=0; i<srv.nworkers; i++) {
+        Worker *w = &srv.workers[i];
+        close(w->epfd);
+        close(w->inbox_fd);
+        while (w->inbox) {
+            Spectator *s = w->inbox;
+            w->inbox = s->next;
+            spectator_free(s);
+        }
+        while (w->resumes) {
+            Resume *r = w->resumes;
+            w->resumes = r->next;
+            close(r->fd);
+            free(r);
+        }
+        w->starts = NULL; // parties fermées avec le tableau
+    }
+    srv.nworkers = 0;
+    if (srv.slab) {
+        for (int i=0; i<srv.capacity; i++) {
+            Match *m = &srv.slab[i];
+            if (!m->live) continue;
+            for (int k=0; k<2; k++)
+                if (m->players[k].fd >= 0) close(m->players[k].fd);
+            while (m->spectators) {
+                Spectator *s = m->spectators;
+                m->spectators = s->next;
+                spectator_free(s);
+                atomic_fetch_sub(&counters.watching, 1);
+            }
+            shared_frame_unref(m->snapshot);
+            m->snapshot = NULL;
+            match_journal_close(m);
+            m->live = false;
+            atomic_fetch_sub(&counters.active, 1);
+        }
+    }
+    free(srv.slab);
+    srv.slab = NULL;
+    if (srv.wakeup_fd >= 0) close(srv.wakeup_fd);
+    srv.wakeup_fd = -1;
+}
+
+/**
+ * @brief Lance un thread de traitement et son instance epoll.
+ * @param w Le thread.
+ * @return 0 si succès, -1 en cas d'erreur (rien n'est laissé ouvert).
+ */
+static int worker_start(Worker *w) {
+    w->epfd = epoll_create1(EPOLL_CLOEXEC);
+    w->inbox_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    w->inbox_kind = CONN_INBOX;
+    w->inbox = NULL;
+    w->resumes = NULL;
+    w->starts = NULL;
+    w->susp_head = w->susp_tail = NULL;
+    w->dead = NULL;
+    pthread_mutex_init(&w->inbox_lock, NULL);
+
+    struct epoll_event ev = { .events = EPOLLIN, .data.ptr = NULL };
+    struct epoll_event iev = { .events = EPOLLIN, .data.ptr = &w->inbox_kind };
+    if (w->epfd < 0 || w->inbox_fd < 0 ||
+        epoll_ctl(w->epfd, EPOLL_CTL_ADD, srv.wakeup_fd, &ev) < 0 ||
+        epoll_ctl(w->epfd, EPOLL_CTL_ADD, w->inbox_fd, &iev) < 0 ||
+        pthread_create(&w->tid, NULL, worker_main, w) != 0) {
+        if (w->epfd >= 0) close(w->epfd);
+        if (w->inbox_fd >= 0) close(w->inbox_fd);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @see serveur.h
+ */
+int server_run(const ServerConfig *cfg) {
+    if (!cfg || cfg->workers < 1 || cfg->workers > SRV_MAX_WORKERS ||
+        cfg->max_games < 1 || cfg->max_games > SRV_MAX_GAMES) return -1;
+
+    srv.slab = calloc(cfg->max_games, sizeof(Match));
+    srv.wakeup_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (!srv.slab || srv.wakeup_fd < 0) {
+        server_cleanup();
+        return -1;
+    }
+    srv.capacity = cfg->max_games;
+    srv.cfg = cfg;
+    for (int i=0; i<srv.capacity; i++) srv.slab[i].next_free = i + 1 < srv.capacity ? i + 1 : -1;
+    srv.free_head = 0;
+
+    int lfd = listen_socket(cfg->port);
+    srv.lobby_fd = epoll_create1(EPOLL_CLOEXEC);
+    struct epoll_event lev = { .events = EPOLLIN, .data.ptr = &lfd };
+    struct epoll_event wev = { .events = EPOLLIN, .data.ptr = NULL };
+    if (lfd < 0 || srv.lobby_fd < 0 ||
+        epoll_ctl(srv.lobby_fd, EPOLL_CTL_ADD, lfd, &lev) < 0 ||
+        epoll_ctl(srv.lobby_fd, EPOLL_CTL_ADD, srv.wakeup_fd, &wev) < 0) {
+        if (lfd >= 0) close(lfd);
+        if (srv.lobby_fd >= 0) close(srv.lobby_fd);
+        srv.lobby_fd = -1;
+        server_cleanup();
+        return -1;
+    }
+
+    for (int i=0; i<cfg->workers; i++) {
+        if (worker_start(&srv.workers[i]) < 0) break;
+        srv.nworkers++;
+    }
+
+    srv.next_worker = 0;
+    srv.latest = 0;
+    bool stop = srv.nworkers == 0;
+    if (stop) fprintf(stderr, "Erreur : impossible de lancer les threads du serveur\n");
+
+    while (!stop) {
+        struct epoll_event events[SRV_EVENTS];
+        int n = epoll_wait(srv.lobby_fd, events, SRV_EVENTS, lobby_timeout());
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            perror("epoll_wait");
+            break;
+        }
+
+        for (int i=0; i<n; i++) {
+            void *ptr = events[i].data.ptr;
+            if (!ptr) {
+                stop = true;
+            } else if (ptr == &lfd) {
+                for (;;) {
+                    int cfd = accept4(lfd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+                    if (cfd < 0) {
+                        if (errno == EINTR) continue;
+                        if (errno != EAGAIN && errno != EWOULDBLOCK) perror("accept4");
+                        break;
+                    }
+                    atomic_fetch_add(&counters.accepted, 1);
+                    int on = 1; // les trames sont petites : pas d'attente de Nagle
+                    setsockopt(cfd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+                    lobby_add(cfd);
+                }
+            } else {
+                lobby_event(ptr, events[i].events);
+            }
+        }
+        lobby_expire();
+        while (srv.lobby_dead) {
+            Pending *p = srv.lobby_dead;
+            srv.lobby_dead = p->next;
+            free(p);
+        }
+    }
+
+    for (int i=0; i<srv.nworkers; i++) pthread_join(srv.workers[i].tid, NULL);
+    while (srv.lobby) lobby_remove(srv.lobby, true);
+    while (srv.lobby_dead) {
+        Pending *p = srv.lobby_dead;
+        srv.lobby_dead = p->next;
+        free(p);
+    }
+    close(lfd);
+    close(srv.lobby_fd);
+    srv.lobby_fd = -1;
+    server_cleanup();
+    return 0;
+}
+
+/**
+ * @see serveur.h
+ */
+void server_stop(void) {
+    uint64_t one = 1;
+    if (srv.wakeup_fd >= 0 && write(srv.wakeup_fd, &one, sizeof(one)) < 0) {
+        // Rien à faire : le compteur de l'eventfd est déjà non nul.
+    }
+}
+
+/**
+ * @see serveur.h
+ */
+void server_get_stats(ServerStats *out) {
+    out->accepted = atomic_load(&counters.accepted);
+    out->refused = atomic_load(&counters.refused);
+    out->games_started = atomic_load(&counters.started);
+    out->games_finished = atomic_load(&counters.finished);
+    out->games_aborted = atomic_load(&counters.aborted);
+    out->moves = atomic_load(&counters.moves);
+    out->spectators = atomic_load(&counters.spectators);
+    out->spectators_dropped = atomic_load(&counters.dropped);
+    out->resyncs = atomic_load(&counters.resyncs);
+    out->journal_errors = atomic_load(&counters.journal_errors);
+    out->resumed = atomic_load(&counters.resumed);
+    out->active_games = atomic_load(&counters.active);
+    out->active_spectators = atomic_load(&counters.watching);
+}
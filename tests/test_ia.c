@@ -17,8 +17,10 @@
  */
 
 #include <stdio.h>
+#include <string.h>
 #include <assert.h>
 #include "ia.h"
+#include "geometrie.h"
 
 
 /**
@@ -54,6 +56,13 @@ int test_ia_choisit_capture_avantageuse();
 int test_ia_avance_roi_vers_objectif();
 int test_ia_piece_index_cas_invalide();
 int test_ia_genere_tt_exact_flag();
+int test_ia_plateau_compact();
+int test_ia_parallele_coup_gagnant();
+int test_ia_parallele_deterministe();
+int test_ia_multipv_lignes_distinctes();
+int test_ia_arret_recherche();
+int test_ia_evite_repetition();
+int test_ia_tt_sauvegarde_et_rechargement();
 
 
 // SUITE DE TESTS POUR L'IA 
@@ -246,6 +255,589 @@ int test_ia_genere_tt_exact_flag() {
     return m.r1 != -1;
 }
 
+/**
+ * @brief Test 7: Vérifie que le plateau de l'IA utilise un octet par case.
+ *
+ * Les copies de `Board` sont effectuées à chaque nœud de la recherche : le
+ * plateau doit tenir sur 81 octets et conserver les valeurs des pièces.
+ * @return 1 en cas de succès, 0 en cas d'échec.
+ */
+int test_ia_plateau_compact() {
+    Board b = {0};
+    b.pion[8][8] = ROI_BLEU;
+    Board copie = b;
+
+    int ok = (sizeof(Board) == SIZE * SIZE) && (copie.pion[8][8] == ROI_BLEU);
+    assert(ok);
+
+    return ok;
+}
+
+/**
+ * @brief Test 8: Vérifie que la recherche parallèle trouve le coup gagnant.
+ *
+ * @b Arrange: Même position que le test 1, recherche sur 4 threads.
+ * @b Assert: Le roi bleu doit toujours rejoindre la case de victoire (8,8).
+ * @return 1 en cas de succès, 0 en cas d'échec.
+ */
+int test_ia_parallele_coup_gagnant() {
+    Board b = {0};
+    b.pion[8][7] = ROI_BLEU;
+    b.pion[0][1] = ROI_ROUGE;
+    b.pion[0][0] = SOLDAT_BLEU;
+    b.pion[1][0] = SOLDAT_ROUGE;
+    b.pion[4][4] = SOLDAT_BLEU;
+    b.pion[4][6] = SOLDAT_ROUGE;
+
+    ia_init_once();
+    ia_set_threads(4);
+    Move best_move = search_best_move(&b, true);
+    SearchStats stats;
+    ia_get_search_stats(&stats);
+    ia_set_threads(1);
+
+    int ok = (best_move.r1 == 8 && best_move.c1 == 7 && best_move.r2 == 8 && best_move.c2 == 8)
+          && stats.threads == 4;
+    assert(ok);
+
+    return ok;
+}
+
+/**
+ * @brief Test 9: Vérifie que le mode déterministe reproduit le même nombre de nœuds.
+ *
+ * @b Act: Lance deux fois la même recherche sur 3 threads en mode déterministe.
+ * @b Assert: Les deux recherches visitent exactement le même nombre de nœuds
+ * et choisissent le même coup.
+ * @return 1 en cas de succès, 0 en cas d'échec.
+ */
+int test_ia_parallele_deterministe() {
+    Board b = {0};
+    b.pion[1][1] = ROI_BLEU;
+    b.pion[7][7] = ROI_ROUGE;
+    b.pion[2][2] = SOLDAT_BLEU;
+    b.pion[3][1] = SOLDAT_BLEU;
+    b.pion[6][7] = SOLDAT_ROUGE;
+    b.pion[7][5] = SOLDAT_ROUGE;
+
+    ia_init_once();
+    ia_set_threads(3);
+    ia_set_deterministic(true);
+
+    SearchStats s1, s2;
+    Move m1 = search_best_move(&b, true);
+    ia_get_search_stats(&s1);
+    Move m2 = search_best_move(&b, true);
+    ia_get_search_stats(&s2);
+
+    ia_set_deterministic(false);
+    ia_set_threads(1);
+
+    int ok = s1.nodes == s2.nodes && s1.splits > 0 &&
+             m1.r1 == m2.r1 && m1.c1 == m2.c1 && m1.r2 == m2.r2 && m1.c2 == m2.c2;
+    assert(ok);
+
+    return ok;
+}
+
+/**
+ * @brief Test 10: Vérifie l'analyse multi-PV.
+ *
+ * @b Arrange: Le roi bleu peut gagner immédiatement (position du test 1).
+ * @b Act: Demande les 3 meilleures lignes pour le joueur Bleu.
+ * @b Assert: La première ligne est le coup gagnant, les trois coups racine
+ * sont distincts, les scores décroissent et chaque variation commence par
+ * son coup racine.
+ * @return 1 en cas de succès, 0 en cas d'échec.
+ */
+int test_ia_multipv_lignes_distinctes() {
+    Board b = {0};
+    b.pion[8][7] = ROI_BLEU;
+    b.pion[0][1] = ROI_ROUGE;
+    b.pion[0][0] = SOLDAT_BLEU;
+    b.pion[1][0] = SOLDAT_ROUGE;
+
+    ia_init_once();
+    PVLine lines[3];
+    int n = search_multipv(&b, true, 3, lines);
+
+    int ok = (n == 3);
+    ok = ok && lines[0].move.r1 == 8 && lines[0].move.c1 == 7 && lines[0].move.r2 == 8 && lines[0].move.c2 == 8;
+    for (int i=0; ok && i<n; i++) {
+        ok = ok && lines[i].length >= 1;
+        ok = ok && lines[i].pv[0].r2 == lines[i].move.r2 && lines[i].pv[0].c2 == lines[i].move.c2;
+        if (i > 0) {
+            ok = ok && lines[i].score <= lines[i-1].score;
+            ok = ok && !(lines[i].move.r2 == lines[i-1].move.r2 && lines[i].move.c2 == lines[i-1].move.c2 &&
+                         lines[i].move.r1 == lines[i-1].move.r1 && lines[i].move.c1 == lines[i-1].move.c1);
+        }
+    }
+    assert(ok);
+
+    return ok;
+}
+
+/**
+ * @brief Test 11: Vérifie la demande d'arrêt de la recherche.
+ *
+ * @b Act: Lance une recherche alors qu'un arrêt est demandé, puis une
+ * seconde après avoir annulé la demande.
+ * @b Assert: La première ne rend aucun coup (aucune itération terminée),
+ * la seconde rend le coup gagnant.
+ * @return 1 en cas de succès, 0 en cas d'échec.
+ */
+int test_ia_arret_recherche() {
+    Board b = {0};
+    b.pion[8][7] = ROI_BLEU;
+    b.pion[0][1] = ROI_ROUGE;
+    b.pion[0][0] = SOLDAT_BLEU;
+    b.pion[1][0] = SOLDAT_ROUGE;
+
+    ia_init_once();
+    ia_stop_search();
+    Move arrete = search_best_move(&b, true);
+    ia_reset_stop();
+    Move complet = search_best_move(&b, true);
+
+    int ok = arrete.r1 == -1 && complet.r1 == 8 && complet.c1 == 7 && complet.r2 == 8 && complet.c2 == 8;
+    assert(ok);
+
+    return ok;
+}
+
+/**
+ * @brief Test 12: Vérifie que l'IA évite de reproduire une position déjà jouée.
+ *
+ * @b Arrange: On cherche d'abord le coup préféré de Bleu, puis on inscrit
+ * dans l'historique de la partie la position qu'il produit.
+ * @b Act: Nouvelle recherche avec une forte pénalité de répétition.
+ * @b Assert: L'IA choisit un autre coup ; sans historique, elle revient au premier.
+ * @return 1 en cas de succès, 0 en cas d'échec.
+ */
+int test_ia_evite_repetition() {
+    Board b = {0};
+    b.pion[1][1] = ROI_BLEU;
+    b.pion[7][7] = ROI_ROUGE;
+    b.pion[0][5] = SOLDAT_BLEU;
+    b.pion[6][7] = SOLDAT_ROUGE;
+    b.pion[7][6] = SOLDAT_ROUGE;
+
+    ia_init_once();
+    ia_history_clear();
+    Move first = search_best_move(&b, true);
+
+    Board after = b;
+    after.pion[first.r2][first.c2] = after.pion[first.r1][first.c1];
+    after.pion[first.r1][first.c1] = EMPTY;
+    ia_history_push(&after, false);
+    ia_history_push(&b, true);
+    ia_set_repetition_policy(REP_SCORE_CONTEMPT, 5000);
+    Move avoid = search_best_move(&b, true);
+
+    ia_history_clear();
+    ia_set_repetition_policy(REP_SCORE_DRAW, 0);
+    Move again = search_best_move(&b, true);
+
+    int ok = !(avoid.r1 == first.r1 && avoid.c1 == first.c1 && avoid.r2 == first.r2 && avoid.c2 == first.c2)
+          && avoid.r1 != -1
+          && again.r1 == first.r1 && again.c1 == first.c1 && again.r2 == first.r2 && again.c2 == first.c2;
+    assert(ok);
+
+    return ok;
+}
+
+/**
+ * @brief Test 13: Vérifie la sauvegarde et le rechargement de la TT.
+ *
+ * @b Arrange: Une recherche Minimax remplit la TT, qui est sauvegardée puis vidée.
+ * @b Act: Recharge le fichier, puis un fichier dont l'empreinte Zobrist a été
+ * altérée, puis un fichier dont un enregistrement porte un drapeau invalide.
+ * @b Assert: Le premier chargement relit toutes les entrées et la recherche
+ * suivante rend le même coup ; les fichiers altérés sont refusés.
+ * @return 1 en cas de succès, 0 en cas d'échec.
+ */
+int test_ia_tt_sauvegarde_et_rechargement() {
+    const char *path = "test_ia_tt.bin";
+    Board b = {0};
+    b.pion[1][1] = ROI_BLEU;
+    b.pion[7][7] = ROI_ROUGE;
+    b.pion[2][2] = SOLDAT_BLEU;
+    b.pion[6][6] = SOLDAT_ROUGE;
+
+    // Recherche Minimax seule : le solveur de finale, qui prouverait cette
+    // position, n'écrit pas dans la TT.
+    ia_init_once();
+    ia_tt_clear();
+    PVLine l1, l2;
+    int n1 = search_multipv(&b, true, 1, &l1);
+    Move m1 = l1.move;
+    int saved = ia_tt_save(path, 1);
+
+    ia_tt_clear();
+    int loaded = ia_tt_load(path);
+    int n2 = search_multipv(&b, true, 1, &l2);
+    Move m2 = l2.move;
+
+    // Altération de l'empreinte Zobrist (octets 16 à 23 de l'en-tête).
+    FILE *f = fopen(path, "r+b");
+    int rejected = 0;
+    if (f) {
+        fseek(f, 16, SEEK_SET);
+        fputc(0x5A, f);
+        fclose(f);
+        rejected = (ia_tt_load(path) == -1);
+    }
+
+    // Drapeau du premier enregistrement (octet 11 après l'en-tête de 32 octets).
+    int bad_flag = 0;
+    if (ia_tt_save(path, 1) == saved && (f = fopen(path, "r+b"))) {
+        fseek(f, 32 + 11, SEEK_SET);
+        fputc(7, f);
+        fclose(f);
+        bad_flag = (ia_tt_load(path) == -1);
+    }
+    remove(path);
+
+    int ok = n1 == 1 && n2 == 1 && saved > 0 && loaded == saved && rejected && bad_flag &&
+             m1.r1 == m2.r1 && m1.c1 == m2.c1 && m1.r2 == m2.r2 && m1.c2 == m2.c2;
+    assert(ok);
+
+    return ok;
+}
+
+
+/**
+ * @brief Test 14: Vérifie le solveur de finale sur un gain forcé hors de portée de Minimax.
+ *
+ * @b Arrange: Finale à 6 pièces où Bleu force la conquête de I1 en plusieurs
+ * coups, au-delà de la profondeur MAX_DEPTH.
+ * @b Act: Résolution, puis recherche complète sur la même position.
+ * @b Assert: Le gain est prouvé sans rien inscrire dans la TT (la preuve
+ * dépend de l'historique), et `search_best_move` joue ce coup.
+ * @return 1 en cas de succès, 0 en cas d'échec.
+ */
+int test_ia_solveur_finale() {
+    Board b = {0};
+    b.pion[6][4] = ROI_BLEU;
+    b.pion[2][2] = ROI_ROUGE;
+    b.pion[4][8] = SOLDAT_BLEU;
+    b.pion[7][8] = SOLDAT_BLEU;
+    b.pion[4][6] = SOLDAT_ROUGE;
+    b.pion[5][1] = SOLDAT_ROUGE;
+
+    ia_init_once();
+    ia_history_clear();
+    ia_tt_clear();
+    Move win;
+    int proven = ia_solve_endgame(&b, true, &win);
+    int untouched = 1;
+    for (uint32_t i=0; i<TT_SIZE; i++) untouched = untouched && TT[i].key == 0 && TT[i].depth == 0;
+    Move played = search_best_move(&b, true);
+
+    int ok = proven && untouched && win.r1 == 6 && win.c1 == 4 &&
+             played.r1 == win.r1 && played.c1 == win.c1 && played.r2 == win.r2 && played.c2 == win.c2;
+    assert(ok);
+
+    return ok;
+}
+
+/**
+ * @brief Test 15: Vérifie le cache d'évaluation et ses statistiques.
+ *
+ * @b Arrange: Position d'ouverture simplifiée, recherche déterministe.
+ * @b Act: Deux recherches successives sur la même position.
+ * @b Assert: Les évaluations sont comptées, la seconde recherche est servie
+ * en partie par le cache et visite exactement les mêmes nœuds.
+ * @return 1 en cas de succès, 0 en cas d'échec.
+ */
+int test_ia_cache_evaluation() {
+    Board b = {0};
+    b.pion[0][0] = ROI_BLEU;
+    b.pion[8][8] = ROI_ROUGE;
+    b.pion[2][3] = SOLDAT_BLEU;
+    b.pion[3][2] = SOLDAT_BLEU;
+    b.pion[5][6] = SOLDAT_ROUGE;
+    b.pion[6][5] = SOLDAT_ROUGE;
+
+    ia_init_once();
+    ia_history_clear();
+    ia_set_deterministic(true);
+    SearchStats first, second;
+    search_best_move(&b, true);
+    ia_get_search_stats(&first);
+    search_best_move(&b, true);
+    ia_get_search_stats(&second);
+    ia_set_deterministic(false);
+
+    int ok = first.eval_probes > 0 && first.eval_hits <= first.eval_probes &&
+             second.eval_hits > first.eval_hits && second.nodes == first.nodes;
+    assert(ok);
+
+    return ok;
+}
+
+/**
+ * @brief Test 16: Vérifie la répartition du temps et la recherche à la pendule.
+ *
+ * @b Arrange: Une pendule de 60 s avec 1 s d'incrément ; une position de milieu de partie.
+ * @b Act: Budgets calculés à plusieurs tours, puis une recherche limitée à 30 ms (120 ms au plus).
+ * @b Assert: Moins il reste de coups, plus le budget est grand ; la limite dure
+ * ne dépasse pas le temps restant ; la recherche rend un coup bien avant la
+ * fin de la pendule et mène au moins une itération à son terme.
+ * @return 1 en cas de succès, 0 en cas d'échec.
+ */
+int test_ia_gestion_du_temps() {
+    MoveBudget debut = ia_allocate_time(60000, 1000, 1);
+    MoveBudget fin = ia_allocate_time(60000, 1000, IA_TOURS_MAX - 1);
+    MoveBudget presse = ia_allocate_time(200, 1000, 10);
+
+    Board b = {0};
+    b.pion[0][0] = ROI_BLEU;
+    b.pion[8][8] = ROI_ROUGE;
+    b.pion[1][2] = SOLDAT_BLEU;
+    b.pion[2][1] = SOLDAT_BLEU;
+    b.pion[2][3] = SOLDAT_BLEU;
+    b.pion[3][2] = SOLDAT_BLEU;
+    b.pion[6][5] = SOLDAT_ROUGE;
+    b.pion[5][6] = SOLDAT_ROUGE;
+    b.pion[7][6] = SOLDAT_ROUGE;
+    b.pion[6][7] = SOLDAT_ROUGE;
+
+    ia_init_once();
+    ia_history_clear();
+    ia_reset_stop();
+    MoveBudget mb = { 30, 120 };
+    ia_set_move_budget(&mb);
+    Move m = search_best_move(&b, true);
+    ia_set_move_budget(NULL);
+    SearchStats stats;
+    ia_get_search_stats(&stats);
+
+    int ok = debut.soft_ms < fin.soft_ms && debut.soft_ms <= debut.hard_ms &&
+             fin.hard_ms <= 60000 && presse.hard_ms <= 200 &&
+             m.r1 >= 0 && stats.depth >= 1 && stats.time_ms < 1000;
+    assert(ok);
+
+    return ok;
+}
+
+/**
+ * @brief Test 17: Vérifie le calcul d'occupation par multiplication contre PEXT.
+ *
+ * @b Arrange: Un plateau à une seule pièce pour chaque case, puis des
+ * plateaux aléatoires de densités variées (générateur congruentiel fixe).
+ * @b Act: Occupation des lignes et colonnes par les deux versions.
+ * @b Assert: Les deux versions rendent l'occupation lue case par case ; la
+ * version PEXT n'est comparée que si le processeur dispose de BMI2.
+ * @return 1 en cas de succès, 0 en cas d'échec.
+ */
+int test_ia_occupation_multiplication() {
+    uint32_t seed = 12345;
+    int ok = 1;
+    for (int trial=0; trial<NB_CASES + 2000 && ok; trial++) {
+        Board b = {0};
+        if (trial < NB_CASES) {
+            b.pion[trial / SIZE][trial % SIZE] = (int8_t)(1 + trial % 4);
+        } else {
+            int density = trial % 10;
+            for (int i=0; i<NB_CASES; i++) {
+                seed = seed * 1103515245u + 12345u;
+                if ((int)(seed >> 16) % 10 < density) b.pion[i / SIZE][i % SIZE] = (int8_t)(1 + (seed >> 8) % 4);
+            }
+        }
+
+        uint16_t rows[SIZE] = {0}, cols[SIZE] = {0};
+        for (int r=0; r<SIZE; r++)
+            for (int c=0; c<SIZE; c++)
+                if (b.pion[r][c]) {
+                    rows[r] |= (uint16_t)(1u << c);
+                    cols[c] |= (uint16_t)(1u << r);
+                }
+
+        uint16_t mrows[SIZE], mcols[SIZE], prows[SIZE], pcols[SIZE];
+        ok = ia_test_occupancy(&b, false, mrows, mcols) == 0 &&
+             memcmp(mrows, rows, sizeof(rows)) == 0 && memcmp(mcols, cols, sizeof(cols)) == 0;
+        if (ok && ia_test_occupancy(&b, true, prows, pcols) == 0)
+            ok = memcmp(prows, rows, sizeof(rows)) == 0 && memcmp(pcols, cols, sizeof(cols)) == 0;
+    }
+    assert(ok);
+
+    return ok;
+}
+
+/**
+ * @brief Test 18: Vérifie le gain des captures et l'évaluation des échanges.
+ *
+ * @b Arrange: Un soldat bleu en A5 face à un soldat rouge en E5 (poussée),
+ * le même avec un soldat rouge en D2 prêt à reprendre, puis un soldat bleu
+ * en D9 qui descend prendre en sandwich un soldat rouge en E5 (allié en F5).
+ * @b Act: Gain et bilan d'échange de chaque coup, et d'un coup sans prise.
+ * @b Assert: Chaque prise rapporte un soldat ; la reprise par poussée
+ * ramène le bilan à 0 ; le coup tranquille ne gagne rien.
+ * @return 1 en cas de succès, 0 en cas d'échec.
+ */
+int test_ia_evaluation_echanges() {
+    Board push = {0};
+    push.pion[8][0] = ROI_BLEU;
+    push.pion[0][8] = ROI_ROUGE;
+    push.pion[4][0] = SOLDAT_BLEU;
+    push.pion[4][4] = SOLDAT_ROUGE;
+
+    Board retake = push;
+    retake.pion[7][3] = SOLDAT_ROUGE;
+
+    Board sandwich = {0};
+    sandwich.pion[8][0] = ROI_BLEU;
+    sandwich.pion[0][8] = ROI_ROUGE;
+    sandwich.pion[0][3] = SOLDAT_BLEU;
+    sandwich.pion[4][4] = SOLDAT_ROUGE;
+    sandwich.pion[4][5] = SOLDAT_BLEU;
+
+    ia_init_once();
+    int ok = ia_test_capture_gain(&push, CASE_IDX(4, 0), CASE_IDX(4, 3)) == 12 &&
+             ia_test_see(&push, CASE_IDX(4, 0), CASE_IDX(4, 3)) == 12 &&
+             ia_test_capture_gain(&retake, CASE_IDX(4, 0), CASE_IDX(4, 3)) == 12 &&
+             ia_test_see(&retake, CASE_IDX(4, 0), CASE_IDX(4, 3)) == 0 &&
+             ia_test_capture_gain(&sandwich, CASE_IDX(0, 3), CASE_IDX(4, 3)) == 12 &&
+             ia_test_see(&sandwich, CASE_IDX(0, 3), CASE_IDX(4, 3)) == 12 &&
+             ia_test_capture_gain(&push, CASE_IDX(4, 0), CASE_IDX(4, 2)) == 0;
+    assert(ok);
+
+    return ok;
+}
+
+/**
+ * @brief Parcours en largeur de référence : coups d'un roi jusqu'à sa case but.
+ *
+ * Chaque coup glisse d'une ou plusieurs cases vides en ligne droite ; les
+ * autres pièces restent immobiles.
+ * @param b Le plateau (la case de départ est considérée comme libérée).
+ * @param from Indice de la case du roi.
+ * @param goal Indice de la case but.
+ * @return Le nombre de coups, ou -1 si le but est inaccessible.
+ */
+static int bfs_roi(const Board *b, int from, int goal) {
+    static const int dr[4] = { -1, 1, 0, 0 }, dc[4] = { 0, 0, -1, 1 };
+    int dist[NB_CASES], queue[NB_CASES], head = 0, tail = 0;
+    for (int i=0; i<NB_CASES; i++) dist[i] = -1;
+    dist[from] = 0;
+    queue[tail++] = from;
+    while (head < tail) {
+        int sq = queue[head++];
+        for (int d=0; d<4; d++) {
+            int r = sq / SIZE + dr[d], c = sq % SIZE + dc[d];
+            while (r >= 0 && r < SIZE && c >= 0 && c < SIZE && (b->pion[r][c] == EMPTY || r * SIZE + c == from)) {
+                int t = r * SIZE + c;
+                if (dist[t] < 0) {
+                    dist[t] = dist[sq] + 1;
+                    queue[tail++] = t;
+                }
+                r += dr[d];
+                c += dc[d];
+            }
+        }
+    }
+    return dist[goal];
+}
+
+/**
+ * @brief Test 19: Vérifie la course des rois contre un parcours en largeur simple.
+ *
+ * @b Arrange: Des plateaux aléatoires de densités variées, dont des plateaux
+ * où le roi est enfermé, et deux positions de fin de course.
+ * @b Act: Distance du roi bleu à I1 et du roi rouge à A9, puis détection du
+ * gain en un coup.
+ * @b Assert: Les distances (bornées à l'horizon) sont celles du parcours de
+ * référence ; le gain en un coup est vu sur une ligne libre et pas
+ * derrière un obstacle ni pour le camp qui n'a pas le trait.
+ * @return 1 en cas de succès, 0 en cas d'échec.
+ */
+int test_ia_course_des_rois() {
+    const int limit = 6;
+    uint32_t seed = 777;
+    int ok = 1;
+    ia_init_once();
+    for (int trial=0; trial<3000 && ok; trial++) {
+        Board b = {0};
+        int density = trial % 8;
+        for (int i=0; i<NB_CASES; i++) {
+            seed = seed * 1103515245u + 12345u;
+            if ((int)(seed >> 16) % 10 < density) b.pion[i / SIZE][i % SIZE] = (int8_t)(1 + (seed >> 8) % 2);
+        }
+        seed = seed * 1103515245u + 12345u;
+        int king = (int)((seed >> 16) % (NB_CASES - 1)) + 1;   // jamais sur A9, le but rouge
+        if (trial % 5 == 0) {
+            // Roi enfermé par quatre soldats.
+            for (int d=0; d<NB_DIRECTIONS; d++)
+                if (geo_voisin[king][d] >= 0) b.pion[CASE_LIGNE(geo_voisin[king][d])][CASE_COL(geo_voisin[king][d])] = SOLDAT_ROUGE;
+        }
+        b.pion[CASE_LIGNE(king)][CASE_COL(king)] = ROI_ROUGE;
+        b.pion[0][0] = EMPTY;
+
+        int ref = bfs_roi(&b, king, 0);
+        int expected = ref < 0 || ref > limit ? limit + 1 : ref;
+        ok = ia_test_king_moves_to_goal(&b, king, 0, limit) == expected;
+    }
+
+    Board race = {0};
+    race.pion[8][3] = ROI_BLEU;
+    race.pion[1][4] = ROI_ROUGE;
+    Board blocked = race;
+    blocked.pion[8][6] = SOLDAT_ROUGE;
+
+    ok = ok && ia_test_king_wins_next(&race, true) && !ia_test_king_wins_next(&race, false) &&
+         !ia_test_king_wins_next(&blocked, true) &&
+         ia_test_king_moves_to_goal(&blocked, CASE_IDX(8, 3), NB_CASES - 1, limit) == 3;
+    assert(ok);
+
+    return ok;
+}
+
+/**
+ * @brief Test 20: Vérifie l'analyse multi-PV interrompue au milieu d'une itération.
+ *
+ * @b Arrange: Des positions de milieu de partie tirées au hasard.
+ * @b Act: Demande 3 lignes aux bleus en arrêtant la recherche après 1 ou 2
+ * lignes de l'itération 2, 3 ou 4.
+ * @b Assert: Les 3 lignes rendues, celles de la dernière itération
+ * terminée, ont des coups racine distincts et des scores décroissants.
+ * @return 1 en cas de succès, 0 en cas d'échec.
+ */
+int test_ia_multipv_interrompue() {
+    uint32_t seed = 2029;
+    int ok = 1;
+    ia_init_once();
+    for (int trial=0; trial<8 && ok; trial++) {
+        Board b = {0};
+        for (int i=0; i<NB_CASES; i++) {
+            seed = seed * 1103515245u + 12345u;
+            if ((int)(seed >> 16) % 10 < 2) b.pion[i / SIZE][i % SIZE] = (int8_t)(1 + (seed >> 8) % 2);
+        }
+        b.pion[2][2] = ROI_BLEU;
+        b.pion[6][6] = ROI_ROUGE;
+        b.pion[0][0] = b.pion[8][8] = EMPTY;
+
+        for (int d=2; d<=MAX_DEPTH && ok; d++) {
+            for (int k=1; k<3 && ok; k++) {
+                PVLine lines[3];
+                ia_test_stop_multipv_at(d, k);
+                int n = search_multipv(&b, true, 3, lines);
+                ia_reset_stop();
+                ok = n == 3;
+                for (int i=1; ok && i<n; i++) {
+                    ok = lines[i].score <= lines[i-1].score;
+                    for (int j=0; j<i; j++)
+                        ok = ok && !(lines[i].move.r1 == lines[j].move.r1 && lines[i].move.c1 == lines[j].move.c1 &&
+                                     lines[i].move.r2 == lines[j].move.r2 && lines[i].move.c2 == lines[j].move.c2);
+                }
+            }
+        }
+    }
+    ia_test_stop_multipv_at(0, 0);
+    assert(ok);
+
+    return ok;
+}
 
 /**
  * @brief Point d'entrée principal pour l'exécutable de test de l'IA.
@@ -264,6 +856,20 @@ int main() {
     run_test(test_ia_choisit_capture_avantageuse, "Doit préférer une capture à un coup neutre", &stats);
     run_test(test_ia_avance_roi_vers_objectif, "Doit avancer son roi en situation neutre", &stats);
     run_test(test_ia_genere_tt_exact_flag, "Doit déclencher la recherche complète (couverture)", &stats);
+    run_test(test_ia_plateau_compact, "Le plateau doit tenir sur 81 octets", &stats);
+    run_test(test_ia_parallele_coup_gagnant, "Recherche parallèle : doit trouver le coup gagnant", &stats);
+    run_test(test_ia_parallele_deterministe, "Mode déterministe : nombre de nœuds reproductible", &stats);
+    run_test(test_ia_multipv_lignes_distinctes, "Multi-PV : lignes distinctes et triées", &stats);
+    run_test(test_ia_arret_recherche, "Doit s'interrompre sur demande d'arrêt", &stats);
+    run_test(test_ia_evite_repetition, "Doit éviter de répéter une position de la partie", &stats);
+    run_test(test_ia_tt_sauvegarde_et_rechargement, "TT : sauvegarde, rechargement et refus", &stats);
+    run_test(test_ia_solveur_finale, "Solveur de finale : gain forcé prouvé et joué", &stats);
+    run_test(test_ia_cache_evaluation, "Cache d'évaluation : succès comptés, recherche inchangée", &stats);
+    run_test(test_ia_gestion_du_temps, "Pendule : budget selon les coups restants, limite respectée", &stats);
+    run_test(test_ia_occupation_multiplication, "Occupation : multiplication identique à PEXT", &stats);
+    run_test(test_ia_evaluation_echanges, "Échanges : prise par poussée, par sandwich et reprise", &stats);
+    run_test(test_ia_course_des_rois, "Course des rois : distance et gain en un coup", &stats);
+    run_test(test_ia_multipv_interrompue, "Multi-PV interrompue : lignes d'une même itération", &stats);
     
     printf("--- Résumé des tests IA ---\n");
     if (stats.failures == 0) {
@@ -12,6 +12,14 @@
 #include <stdio.h>
 #include <assert.h>
 #include "jeu_logique.h" // dépendance logique pure.
+#include "geometrie.h"
+#include "protocole.h"
+#include "file_coups.h"
+#include "latence.h"
+#include "journal.h"
+#include <pthread.h>
+#include <string.h>
+#include <unistd.h>
 
 // Structure et utilitaire pour l'exécution des tests
 
@@ -295,6 +303,326 @@ int test_prise_echoue_si_attaquant_vide() {
     return 1;
 }
 
+//  Tests des coups joués
+/** @brief Teste un coup joué hors interface : déplacement, contrôle, tour suivant et refus. */
+int test_jouer_coup() {
+    GameState state;
+    logique_init_game(&state);
+    assert(logique_jouer_coup(&state, CASE_IDX(3, 1), CASE_IDX(5, 1)) == 0);
+    assert(state.pion[3][1] == EMPTY && state.pion[5][1] == SOLDAT_BLEU);
+    assert(state.couleur[5][1] == 2 && state.tour == 2);
+
+    // Aux rouges : une pièce bleue, une diagonale ou une case occupée sont refusées.
+    assert(logique_jouer_coup(&state, CASE_IDX(5, 1), CASE_IDX(6, 1)) == -1);
+    assert(logique_jouer_coup(&state, CASE_IDX(5, 7), CASE_IDX(4, 6)) == -1);
+    assert(logique_jouer_coup(&state, CASE_IDX(5, 7), CASE_IDX(5, 8)) == -1);
+    assert(state.tour == 2);
+    return 1;
+}
+
+/** @brief Teste la légalité d'un coup : trajet libre, destination libre, camp au trait. */
+int test_coup_legal_trajet() {
+    GameState state;
+    logique_init_game(&state);
+    state.pion[5][2] = SOLDAT_BLEU;
+    state.pion[5][5] = SOLDAT_ROUGE;
+    for (int c = 3; c < SIZE; c++) if (c != 5) state.pion[5][c] = EMPTY;
+
+    assert(logique_coup_legal(&state, CASE_IDX(5, 2), CASE_IDX(5, 4)));
+    assert(!logique_coup_legal(&state, CASE_IDX(5, 2), CASE_IDX(5, 5))); // destination occupée
+    assert(!logique_coup_legal(&state, CASE_IDX(5, 2), CASE_IDX(5, 6))); // pièce sur le trajet
+    assert(!logique_coup_legal(&state, CASE_IDX(5, 2), CASE_IDX(5, 2))); // pas de déplacement
+    assert(!logique_coup_legal(&state, CASE_IDX(5, 5), CASE_IDX(5, 6))); // pièce rouge, bleus au trait
+    assert(logique_jouer_coup(&state, CASE_IDX(5, 2), CASE_IDX(5, 8)) == -1);
+    assert(state.pion[5][2] == SOLDAT_BLEU && state.tour == 1);
+    return 1;
+}
+
+/** @brief Teste l'énumération des coups légaux contre logique_coup_legal, sur une partie entière. */
+int test_coups_legaux() {
+    GameState state;
+    logique_init_game(&state);
+    uint8_t coups[LOGIQUE_MAX_COUPS][2];
+    unsigned graine = 12345;
+
+    while (state.game_over_status == 0) {
+        int n = logique_coups_legaux(&state, coups);
+        int attendus = 0;
+        for (int from = 0; from < NB_CASES; from++)
+            for (int to = 0; to < NB_CASES; to++) attendus += logique_coup_legal(&state, from, to);
+        assert(n == attendus && n > 0);
+        for (int i = 0; i < n; i++) assert(logique_coup_legal(&state, coups[i][0], coups[i][1]));
+
+        graine = graine * 1103515245u + 12345u;
+        int i = (int)(graine >> 16) % n;
+        assert(logique_jouer_coup(&state, coups[i][0], coups[i][1]) == 0);
+    }
+    assert(logique_coups_legaux(&state, coups) == 0);
+    return 1;
+}
+
+
+/** @brief Teste les tables de géométrie : rayons et voisins d'un coin et du centre. */
+int test_geometrie_rayons_et_voisins() {
+    int coin = CASE_IDX(0, 0);
+    assert(geo_rayons[coin].longueur[DIR_HAUT] == 0);
+    assert(geo_rayons[coin].longueur[DIR_DROITE] == SIZE - 1);
+    assert(geo_rayons[coin].cases[DIR_BAS][0] == CASE_IDX(1, 0));
+    assert(geo_rayons[coin].cases[DIR_BAS][SIZE - 2] == CASE_IDX(SIZE - 1, 0));
+    assert(geo_voisin[coin][DIR_GAUCHE] == -1);
+    assert(geo_voisin2[CASE_IDX(1, 0)][DIR_HAUT] == -1);
+    assert(geo_voisin[CASE_IDX(1, 0)][DIR_HAUT] == coin);
+
+    int centre = CASE_IDX(4, 4);
+    for (int d = 0; d < NB_DIRECTIONS; d++) assert(geo_rayons[centre].longueur[d] == 4);
+    assert(geo_voisin2[centre][DIR_GAUCHE] == CASE_IDX(4, 2));
+
+    assert(geo_direction("droite") == DIR_DROITE);
+    assert(geo_direction("diagonale") == -1);
+    assert(geo_index_depuis_id("A9") == coin);
+    assert(geo_index_depuis_id("I1") == CASE_IDX(SIZE - 1, SIZE - 1));
+    assert(geo_index_depuis_id("J1") == -1);
+
+    char id[3];
+    geo_id_depuis_index(CASE_IDX(SIZE - 1, SIZE - 1), id);
+    assert(strcmp(id, "I1") == 0);
+    return 1;
+}
+
+//  Tests du protocole réseau
+/** @brief Teste le codage puis le décodage d'une trame de chaque type. */
+int test_protocole_aller_retour() {
+    ProtoMsg in[4] = {
+        { .type = PROTO_HELLO, .seq = 0, .u.hello = { PROTO_VERSION, PROTO_ROLE_RED } },
+        { .type = PROTO_MOVE, .seq = 1, .u.move = { CASE_IDX(3, 1), CASE_IDX(5, 1) } },
+        { .type = PROTO_PING, .seq = 2, .u.ping = 0x0123456789ABCDEFull },
+        { .type = PROTO_STATE, .seq = 3 },
+    };
+    logique_init_game(&in[3].u.state);
+    in[3].u.state.tour = 17;
+
+    uint8_t buf[PROTO_BUF_SIZE];
+    ProtoMsg out;
+    for (int i = 0; i < 4; i++) {
+        int n = proto_encode(&in[i], buf, sizeof(buf));
+        assert(n > PROTO_HEADER_SIZE);
+        assert(proto_decode(buf, n - 1, &out) == 0); // trame incomplète
+        assert(proto_decode(buf, n, &out) == n);
+        assert(out.type == in[i].type && out.seq == in[i].seq);
+    }
+    assert(out.u.state.tour == 17 && out.u.state.pion[3][1] == SOLDAT_BLEU);
+
+    ProtoMsg reprise = { .type = PROTO_RESUME, .seq = 1, .u.session = { 0x00020001, 0xFEDCBA9876543210ull, 12 } };
+    int n = proto_encode(&reprise, buf, sizeof(buf));
+    assert(n == PROTO_HEADER_SIZE + 16 && proto_decode(buf, n, &out) == n);
+    assert(out.u.session.game == 0x00020001 && out.u.session.token == 0xFEDCBA9876543210ull);
+    assert(out.u.session.plies == 12);
+
+    ProtoMsg coup = { .type = PROTO_MOVE, .u.move = { SIZE * SIZE, 0 } };
+    assert(proto_encode(&coup, buf, sizeof(buf)) == -1); // case hors plateau
+    assert(proto_encode(&in[3], buf, PROTO_HEADER_SIZE + 10) == -1); // tampon trop petit
+    return 1;
+}
+
+/** @brief Teste le regroupement de trames en un envoi, leur découpage et le contrôle des séquences. */
+int test_protocole_lecteur_ecrivain() {
+    ProtoWriter w;
+    ProtoReader r;
+    proto_writer_init(&w);
+    proto_reader_init(&r);
+    for (int i = 0; i < 3; i++) {
+        ProtoMsg m = { .type = PROTO_MOVE, .u.move = { (uint8_t)i, (uint8_t)(i + 1) } };
+        assert(proto_writer_push(&w, &m) == 0);
+    }
+
+    // Les trois trames arrivent en deux morceaux coupés au milieu d'une trame.
+    ProtoMsg m;
+    memcpy(r.buf, w.buf, 5);
+    r.len = 5;
+    assert(proto_reader_next(&r, &m) == 0);
+    memcpy(r.buf + r.len, w.buf + 5, w.len - 5);
+    r.len += w.len - 5;
+    for (int i = 0; i < 3; i++) {
+        assert(proto_reader_next(&r, &m) == 1);
+        assert(m.seq == (uint32_t)i && m.u.move.from == i);
+    }
+    assert(proto_reader_next(&r, &m) == 0 && r.len == 0);
+    proto_writer_consume(&w, w.len);
+    assert(w.len == 0);
+
+    // Une trame rejouée (même séquence) ou corrompue est refusée.
+    ProtoMsg ping = { .type = PROTO_PING, .seq = 1 };
+    r.len = proto_encode(&ping, r.buf, PROTO_BUF_SIZE);
+    assert(proto_reader_next(&r, &m) == -PROTO_ERR_SEQUENCE);
+    r.buf[2] = 0xFF; // type inconnu
+    assert(proto_reader_next(&r, &m) == -PROTO_ERR_MALFORMED);
+    return 1;
+}
+
+/** @brief Teste le flux d'un spectateur : WATCH, puis séquences fixées par chaque trame STATE diffusée. */
+int test_protocole_diffusion() {
+    uint8_t buf[PROTO_BUF_SIZE];
+    ProtoMsg m;
+    ProtoMsg watch = { .type = PROTO_WATCH, .u.game = 0x00020007u };
+    int n = proto_encode(&watch, buf, sizeof(buf));
+    assert(proto_decode(buf, n, &m) == n && m.u.game == 0x00020007u);
+
+    // Le spectateur arrive après 5 trames diffusées, puis prend du retard.
+    ProtoReader r;
+    proto_reader_init(&r);
+    ProtoMsg flux[4] = {
+        { .type = PROTO_STATE, .flags = PROTO_FLAG_BROADCAST, .seq = 5 },
+        { .type = PROTO_MOVE, .flags = PROTO_FLAG_BROADCAST, .seq = 6 },
+        { .type = PROTO_STATE, .flags = PROTO_FLAG_BROADCAST, .seq = 9 }, // remplace les trames 7 à 9
+        { .type = PROTO_MOVE, .flags = PROTO_FLAG_BROADCAST, .seq = 10 },
+    };
+    logique_init_game(&flux[0].u.state);
+    flux[2].u.state = flux[0].u.state;
+    for (int i = 0; i < 4; i++) {
+        r.len = proto_encode(&flux[i], r.buf, PROTO_BUF_SIZE);
+        assert(proto_reader_next(&r, &m) == 1);
+        assert(m.seq == flux[i].seq && m.flags == PROTO_FLAG_BROADCAST);
+    }
+
+    // Une trame sautée hors resynchronisation reste une erreur.
+    flux[3].seq = 12;
+    r.len = proto_encode(&flux[3], r.buf, PROTO_BUF_SIZE);
+    assert(proto_reader_next(&r, &m) == -PROTO_ERR_SEQUENCE);
+    return 1;
+}
+
+//  Tests de la file des coups reçus
+/** @brief Teste la file vide, pleine, et le passage par la fin du tableau circulaire. */
+int test_file_coups_capacite() {
+    static MoveQueue q;
+    move_queue_init(&q);
+    QueuedMove m;
+    assert(move_queue_pop(&q, &m) == 0);
+
+    for (int tour = 0; tour < 3; tour++) {
+        for (int i = 0; i < MOVE_QUEUE_CAPACITY; i++)
+            assert(move_queue_push(&q, (QueuedMove){ (uint8_t)(i % NB_CASES), (uint8_t)tour, 0, (uint8_t)(i & MOVE_QUEUE_REPLAY) }) == 0);
+        assert(move_queue_push(&q, (QueuedMove){ 0, 0, 0, 0 }) == -1);
+        for (int i = 0; i < MOVE_QUEUE_CAPACITY; i++) {
+            assert(move_queue_pop(&q, &m) == 1);
+            assert(m.from == i % NB_CASES && m.to == tour && m.flags == (i & MOVE_QUEUE_REPLAY));
+        }
+        assert(move_queue_pop(&q, &m) == 0);
+    }
+    return 1;
+}
+
+#define TEST_FILE_COUPS_N 200000 /**< Coups échangés par le test à deux threads. */
+
+/**
+ * @brief Producteur du test à deux threads : pousse les coups numérotés, en réessayant si la file est pleine.
+ * @param arg La file.
+ * @return NULL.
+ */
+static void *file_coups_producteur(void *arg) {
+    MoveQueue *q = arg;
+    for (int i = 0; i < TEST_FILE_COUPS_N; i++) {
+        QueuedMove m = { (uint8_t)(i % NB_CASES), (uint8_t)(i / NB_CASES % NB_CASES), i, 0 };
+        while (move_queue_push(q, m) < 0) {}
+    }
+    return NULL;
+}
+
+/** @brief Teste qu'un consommateur reçoit tous les coups d'un producteur concurrent, dans l'ordre. */
+int test_file_coups_deux_threads() {
+    static MoveQueue q;
+    move_queue_init(&q);
+    pthread_t producteur;
+    assert(pthread_create(&producteur, NULL, file_coups_producteur, &q) == 0);
+
+    for (int i = 0; i < TEST_FILE_COUPS_N; i++) {
+        QueuedMove m;
+        while (!move_queue_pop(&q, &m)) {}
+        assert(m.from == i % NB_CASES && m.to == i / NB_CASES % NB_CASES && m.received_us == i);
+    }
+    pthread_join(producteur, NULL);
+    return 1;
+}
+
+//  Tests des histogrammes de latence
+/** @brief Teste les centiles d'un histogramme : valeurs exactes en bas de plage, erreur bornée au-delà. */
+int test_latence_histogramme() {
+    static LatencyHistogram h;
+    lat_hist_reset(&h);
+    assert(lat_hist_percentile(&h, 50) == 0);
+
+    for (int v = 1; v <= 1000; v++) lat_hist_record(&h, v);
+    lat_hist_record(&h, 1000000);
+    assert(atomic_load(&h.total) == 1001 && atomic_load(&h.min) == 1);
+    assert(lat_hist_percentile(&h, 1) == 10); // petites valeurs : intervalles d'une unité
+    uint64_t p50 = lat_hist_percentile(&h, 50);
+    assert(p50 >= 501 && p50 <= 501 + 501 / 16);
+    uint64_t p99 = lat_hist_percentile(&h, 99);
+    assert(p99 >= 991 && p99 <= 991 + 991 / 16);
+    assert(lat_hist_percentile(&h, 100) == 1000000); // borné par le maximum mesuré
+
+    lat_hist_record(&h, -5); // une durée négative compte pour 0
+    assert(atomic_load(&h.min) == 0);
+    return 1;
+}
+
+//  Tests du journal des parties
+#define TEST_JOURNAL_COUPS 40 /**< Coups joués par le test du journal (plus d'un instantané). */
+
+/**
+ * @brief Joue le premier coup légal trouvé en parcourant les cases dans l'ordre.
+ * @param s La position.
+ * @param[out] from La case de départ.
+ * @param[out] to La case d'arrivée.
+ * @return 1 si un coup a été joué, 0 sinon.
+ */
+static int journal_premier_coup(GameState *s, int *from, int *to) {
+    for (*from = 0; *from < NB_CASES; (*from)++)
+        for (*to = 0; *to < NB_CASES; (*to)++)
+            if (logique_coup_legal(s, *from, *to)) return logique_jouer_coup(s, *from, *to) == 0;
+    return 0;
+}
+
+/** @brief Teste l'écriture et la relecture d'un journal : position intermédiaire, fin tronquée, CRC faux. */
+int test_journal_relecture() {
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/test_journal_%d.krj", (int)getpid());
+    Journal j;
+    assert(journal_open(&j, path, 0x2A, JOURNAL_SYNC_NEVER, 0) == 0);
+
+    GameState state, milieu;
+    logique_init_game(&state);
+    for (int i = 0; i < TEST_JOURNAL_COUPS; i++) {
+        int from, to;
+        assert(journal_premier_coup(&state, &from, &to));
+        assert(journal_move(&j, &state, from, to) == 0);
+        if (i + 1 == TEST_JOURNAL_COUPS / 2) milieu = state;
+    }
+    assert(journal_end(&j, &state) == 0 && journal_close(&j) == 0);
+
+    GameState out;
+    JournalInfo info;
+    assert(journal_replay(path, -1, &out, &info) == TEST_JOURNAL_COUPS);
+    assert(info.game_id == 0x2A && info.plies == TEST_JOURNAL_COUPS && info.status == 0 && !info.truncated);
+    assert(memcmp(out.pion, state.pion, sizeof(out.pion)) == 0 && out.tour == state.tour);
+    assert(journal_replay(path, TEST_JOURNAL_COUPS / 2, &out, NULL) == TEST_JOURNAL_COUPS / 2);
+    assert(memcmp(out.pion, milieu.pion, sizeof(out.pion)) == 0 && out.tour == milieu.tour);
+
+    // Arrêt brutal pendant l'écriture de l'instantané final : la fin est ignorée.
+    FILE *f = fopen(path, "r+b");
+    assert(f && fseek(f, 0, SEEK_END) == 0);
+    long size = ftell(f);
+    assert(truncate(path, size - 10) == 0);
+    assert(journal_replay(path, -1, &out, &info) == TEST_JOURNAL_COUPS && info.truncated);
+
+    // Un octet modifié dans le premier segment est une corruption.
+    assert(fseek(f, 40, SEEK_SET) == 0);
+    int c = fgetc(f);
+    assert(fseek(f, 40, SEEK_SET) == 0 && fputc(c ^ 0x01, f) != EOF && fclose(f) == 0);
+    assert(journal_replay(path, -1, &out, NULL) == -1);
+    unlink(path);
+    return 1;
+}
 
 /**
  * @brief Point d'entrée principal pour l'exécutable de test de la logique du jeu.
@@ -339,6 +667,29 @@ int main() {
     run_test(test_actions_impossibles_si_partie_finie, "Cas Limites : Action impossible si partie finie", &stats);
     run_test(test_prise_echoue_si_attaquant_vide, "Cas Limites : Prise impossible depuis une case vide", &stats);
 
+    // Tests des coups joués
+    run_test(test_jouer_coup, "Coup joué : Déplacement, tour suivant et refus", &stats);
+    run_test(test_coup_legal_trajet, "Coup joué : Trajet et destination libres", &stats);
+    run_test(test_coups_legaux, "Coup joué : Énumération des coups légaux", &stats);
+
+    // Tests des tables de géométrie
+    run_test(test_geometrie_rayons_et_voisins, "Géométrie : Rayons et voisins précalculés", &stats);
+
+    // Tests du protocole réseau
+    run_test(test_protocole_aller_retour, "Protocole : Codage et décodage des trames", &stats);
+    run_test(test_protocole_lecteur_ecrivain, "Protocole : Regroupement, découpage et séquences", &stats);
+    run_test(test_protocole_diffusion, "Protocole : Flux d'un spectateur et resynchronisation", &stats);
+
+    // Tests de la file des coups reçus
+    run_test(test_file_coups_capacite, "File des coups : Vide, pleine et circulaire", &stats);
+    run_test(test_file_coups_deux_threads, "File des coups : Ordre avec un producteur concurrent", &stats);
+
+    // Tests des histogrammes de latence
+    run_test(test_latence_histogramme, "Latence : Centiles et précision de l'histogramme", &stats);
+
+    // Tests du journal des parties
+    run_test(test_journal_relecture, "Journal : Relecture, fin tronquée et corruption", &stats);
+
     printf("--- Résumé des tests ---\n");
     if (stats.failures == 0) {
         printf("SUCCÈS : %d/%d tests passés.\n", stats.test_count, stats.test_count);
@@ -0,0 +1,912 @@
+/**
+ * @file charge.c
+ * @brief Générateur de charge pour le serveur de parties : des bots sans interface.
+ * @authors Groupe 8
+ *
+ * Usage : `./charge <adresse:port> [-clients <n>] [-threads <n>] [-duree <s>]
+ * [-strategie hasard|glouton] [-reflexion <ms>[:constante|uniforme|exponentielle]]
+ * [-montee <ms>] [-graine <n>]`.
+ *
+ * Chaque bot ouvre une connexion avec le protocole des clients
+ * (`protocole.h`), est apparié par le serveur, joue des coups légaux
+ * (`logique_coups_legaux`) après un temps de réflexion tiré selon la loi
+ * choisie, puis se reconnecte pour une nouvelle partie. Les bots sont
+ * répartis sur quelques threads epoll ; les réflexions sont des échéances
+ * dans un tas binaire par thread.
+ *
+ * Mesures (histogrammes de `latence.h`) : relais d'un coup, de son envoi
+ * par un bot à sa réception par l'adversaire lorsque les deux bots sont dans
+ * ce processus ; aller-retour PING/PONG avec le serveur après chaque coup ;
+ * appariement, du HELLO envoyé au HELLO reçu. Le débit est affiché chaque
+ * seconde, puis un bilan avec les erreurs.
+ */
+
+#include "jeu_logique.h"
+#include "geometrie.h"
+#include "protocole.h"
+#include "latence.h"
+
+#include <errno.h>
+#include <math.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+
+#define CHARGE_MAX_THREADS 64     /**< Threads de bots au plus. */
+#define CHARGE_EVENTS      256    /**< Événements epoll traités par appel. */
+#define CHARGE_TICK_MS     100    /**< Attente maximale d'un thread, pour voir la demande d'arrêt. */
+#define CHARGE_RETRY_MS    500    /**< Pause avant de reconnecter un bot après une erreur. */
+#define CHARGE_RELAY_SLOTS 0x10000 /**< Horodatages de relais, indexés par les 16 bits bas de l'identifiant de partie. */
+
+/**
+ * @enum ThinkLaw
+ * @brief Loi du temps de réflexion d'un bot.
+ */
+typedef enum
+{
+    THINK_CONSTANT,   /**< Toujours la moyenne. */
+    THINK_UNIFORM,    /**< Uniforme entre 0 et deux fois la moyenne. */
+    THINK_EXPONENTIAL /**< Exponentielle de moyenne donnée (arrivées de Poisson). */
+} ThinkLaw;
+
+/**
+ * @enum BotPhase
+ * @brief Étape de la vie d'un bot.
+ */
+typedef enum
+{
+    BOT_IDLE,       /**< Sans connexion, en attente de son échéance pour se connecter. */
+    BOT_CONNECTING, /**< Connexion TCP en cours. */
+    BOT_HELLO,      /**< HELLO envoyé, en attente de l'appariement. */
+    BOT_PLAYING,    /**< Partie en cours. */
+    BOT_FINISHING   /**< Partie finie, en attente de la fermeture par le serveur. */
+} BotPhase;
+
+/**
+ * @enum BotOutcome
+ * @brief Raison de la fermeture de la connexion d'un bot.
+ */
+typedef enum
+{
+    OUTCOME_FINISHED, /**< Partie menée à son terme. */
+    OUTCOME_ABORTED,  /**< Partie interrompue (adversaire parti, serveur). */
+    OUTCOME_ERROR,    /**< Connexion impossible ou erreur avant l'appariement. */
+    OUTCOME_STOP      /**< Fin du test. */
+} BotOutcome;
+
+/**
+ * @struct Bot
+ * @brief Un client simulé.
+ */
+typedef struct
+{
+    int fd;              /**< Socket, -1 sans connexion. */
+    BotPhase phase;      /**< Étape courante. */
+    bool blue;           /**< Couleur attribuée par le serveur. */
+    bool want_out;       /**< true si EPOLLOUT est demandé (écrivain non vide). */
+    uint32_t game;       /**< Identifiant de partie (trame SESSION), 0 s'il est inconnu. */
+    GameState state;     /**< Position de la partie, rejouée avec les règles. */
+    ProtoReader in;      /**< Trames reçues. */
+    ProtoWriter out;     /**< Trames à envoyer. */
+    int64_t hello_us;    /**< Envoi du HELLO, pour mesurer l'appariement. */
+    int64_t wake_us;     /**< Échéance : fin de réflexion, ou reconnexion. */
+    int heap_pos;        /**< Place dans le tas des échéances, -1 si absent. */
+    unsigned seed;       /**< Générateur pseudo-aléatoire du bot (`rand_r`). */
+} Bot;
+
+/**
+ * @struct Loader
+ * @brief Un thread de bots : son instance epoll, ses bots et leurs échéances.
+ */
+typedef struct
+{
+    pthread_t thread; /**< Le thread. */
+    int epfd;         /**< Instance epoll. */
+    Bot *bots;        /**< Bots du thread. */
+    int nbots;        /**< Leur nombre. */
+    Bot **heap;       /**< Tas binaire des échéances, la plus proche en tête. */
+    int heap_len;     /**< Échéances dans le tas. */
+} Loader;
+
+/**
+ * @struct RelayStamp
+ * @brief Envoi du dernier coup d'une partie, relu par le bot adverse.
+ */
+typedef struct
+{
+    _Atomic uint64_t tag;     /**< Identifiant de partie (32 bits hauts) et tour du coup. */
+    _Atomic int64_t sent_us;  /**< Instant de l'envoi. */
+} RelayStamp;
+
+/**
+ * @struct ChargeConfig
+ * @brief Paramètres d'un test de charge.
+ */
+typedef struct
+{
+    struct sockaddr_in addr; /**< Adresse du serveur. */
+    int clients;             /**< Bots simulés. */
+    int threads;             /**< Threads de bots. */
+    int duration_s;          /**< Durée du test. */
+    bool greedy;             /**< true : coup glouton, false : coup au hasard. */
+    int think_ms;            /**< Temps de réflexion moyen. */
+    ThinkLaw law;            /**< Loi du temps de réflexion. */
+    int ramp_ms;             /**< Étalement des premières connexions. */
+    unsigned seed;           /**< Graine des générateurs. */
+} ChargeConfig;
+
+static ChargeConfig cfg;                 /**< Paramètres du test. */
+static atomic_bool stopping;             /**< Demande d'arrêt (fin de durée ou signal). */
+static RelayStamp relay[CHARGE_RELAY_SLOTS]; /**< Envois des derniers coups, par partie. */
+static LatencyHistogram hist_relay;      /**< Relais d'un coup entre deux bots. */
+static LatencyHistogram hist_rtt;        /**< Aller-retour PING/PONG avec le serveur. */
+static LatencyHistogram hist_pairing;    /**< HELLO envoyé jusqu'au HELLO reçu. */
+
+/**
+ * @brief Compteurs partagés par tous les threads.
+ */
+static struct
+{
+    _Atomic uint64_t connects;        /**< Connexions établies. */
+    _Atomic uint64_t connect_errors;  /**< Connexions refusées ou échouées. */
+    _Atomic uint64_t games;           /**< Appariements (un par joueur). */
+    _Atomic uint64_t finished;        /**< Parties menées à leur terme (une par joueur). */
+    _Atomic uint64_t aborted;         /**< Parties interrompues (une par joueur). */
+    _Atomic uint64_t moves_sent;      /**< Coups joués par les bots. */
+    _Atomic uint64_t moves_received;  /**< Coups adverses reçus. */
+    _Atomic uint64_t server_errors;   /**< Trames ERROR reçues. */
+    _Atomic uint64_t protocol_errors; /**< Trames invalides, hors séquence ou inattendues. */
+    _Atomic uint64_t illegal;         /**< Coups adverses refusés par les règles. */
+} counters;
+
+// Échéances
+
+/**
+ * @brief Échange deux échéances du tas.
+ * @param l Le thread.
+ * @param i La première place.
+ * @param j La seconde place.
+ */
+static void heap_swap(Loader *l, int i, int j)
+{
+    Bot *t = l->heap[i];
+    l->heap[i] = l->heap[j];
+    l->heap[j] = t;
+    l->heap[i]->heap_pos = i;
+    l->heap[j]->heap_pos = j;
+}
+
+/**
+ * @brief Remonte une échéance vers la tête du tas.
+ * @param l Le thread.
+ * @param i Sa place.
+ */
+static void heap_up(Loader *l, int i)
+{
+    while (i > 0 && l->heap[(i - 1) / 2]->wake_us > l->heap[i]->wake_us)
+    {
+        heap_swap(l, i, (i - 1) / 2);
+        i = (i - 1) / 2;
+    }
+}
+
+/**
+ * @brief Descend une échéance vers le bas du tas.
+ * @param l Le thread.
+ * @param i Sa place.
+ */
+static void heap_down(Loader *l, int i)
+{
+    for (;;)
+    {
+        int min = i, a = 2 * i + 1, b = a + 1;
+        if (a < l->heap_len && l->heap[a]->wake_us < l->heap[min]->wake_us)
+            min = a;
+        if (b < l->heap_len && l->heap[b]->wake_us < l->heap[min]->wake_us)
+            min = b;
+        if (min == i)
+            return;
+        heap_swap(l, i, min);
+        i = min;
+    }
+}
+
+/**
+ * @brief Retire l'échéance d'un bot, s'il en a une.
+ * @param l Le thread.
+ * @param b Le bot.
+ */
+static void timer_cancel(Loader *l, Bot *b)
+{
+    int i = b->heap_pos;
+    if (i < 0)
+        return;
+    b->heap_pos = -1;
+    if (--l->heap_len == i)
+        return;
+    l->heap[i] = l->heap[l->heap_len];
+    l->heap[i]->heap_pos = i;
+    heap_up(l, i);
+    heap_down(l, l->heap[i]->heap_pos);
+}
+
+/**
+ * @brief Fixe l'échéance d'un bot (la précédente est remplacée).
+ * @param l Le thread.
+ * @param b Le bot.
+ * @param at L'instant (`latency_now_us`).
+ */
+static void timer_set(Loader *l, Bot *b, int64_t at)
+{
+    timer_cancel(l, b);
+    b->wake_us = at;
+    b->heap_pos = l->heap_len;
+    l->heap[l->heap_len++] = b;
+    heap_up(l, b->heap_pos);
+}
+
+// Décisions des bots
+
+/**
+ * @brief Tire un nombre uniforme dans ]0, 1[ avec le générateur d'un bot.
+ * @param b Le bot.
+ * @return Le nombre.
+ */
+static double bot_uniform(Bot *b)
+{
+    return (rand_r(&b->seed) + 0.5) / ((double)RAND_MAX + 1.0);
+}
+
+/**
+ * @brief Tire un temps de réflexion selon la loi configurée.
+ * @param b Le bot.
+ * @return La durée en microsecondes.
+ */
+static int64_t bot_think_us(Bot *b)
+{
+    double mean = cfg.think_ms * 1000.0;
+    switch (cfg.law)
+    {
+    case THINK_UNIFORM:
+        return (int64_t)(2.0 * mean * bot_uniform(b));
+    case THINK_EXPONENTIAL:
+        return (int64_t)(-mean * log(bot_uniform(b)));
+    default:
+        return (int64_t)mean;
+    }
+}
+
+/**
+ * @brief Choisit un coup légal : au hasard, ou le meilleur gain immédiat (glouton).
+ *
+ * Le glouton joue chaque coup sur une copie de la position et préfère la
+ * victoire, puis le plus grand écart de soldats capturés ; les égalités
+ * sont départagées au hasard.
+ * @param b Le bot.
+ * @param[out] from La case de départ.
+ * @param[out] to La case d'arrivée.
+ * @return 0 si un coup est choisi, -1 s'il n'y en a aucun.
+ */
+static int bot_choose(Bot *b, int *from, int *to)
+{
+    uint8_t coups[LOGIQUE_MAX_COUPS][2];
+    int n = logique_coups_legaux(&b->state, coups);
+    if (n == 0)
+        return -1;
+
+    int best = rand_r(&b->seed) % n;
+    if (cfg.greedy)
+    {
+        int best_score = INT32_MIN;
+        for (int i = 0; i < n; i++)
+        {
+            GameState s = b->state;
+            logique_jouer_coup(&s, coups[i][0], coups[i][1]);
+            int gain = b->blue ? s.dead_red_count - s.dead_blue_count : s.dead_blue_count - s.dead_red_count;
+            int score = gain * 16 + rand_r(&b->seed) % 16;
+            if (s.game_over_status == (b->blue ? 2 : 1))
+                score = INT32_MAX;
+            if (score > best_score)
+            {
+                best_score = score;
+                best = i;
+            }
+        }
+    }
+    *from = coups[best][0];
+    *to = coups[best][1];
+    return 0;
+}
+
+// Connexions des bots
+
+/**
+ * @brief Ferme la connexion d'un bot, compte son issue et prévoit sa reconnexion.
+ * @param l Le thread.
+ * @param b Le bot.
+ * @param outcome L'issue.
+ */
+static void bot_close(Loader *l, Bot *b, BotOutcome outcome)
+{
+    if (b->fd >= 0)
+    {
+        epoll_ctl(l->epfd, EPOLL_CTL_DEL, b->fd, NULL);
+        close(b->fd);
+        b->fd = -1;
+    }
+    timer_cancel(l, b);
+    b->phase = BOT_IDLE;
+    if (outcome == OUTCOME_FINISHED)
+        atomic_fetch_add(&counters.finished, 1);
+    else if (outcome == OUTCOME_ABORTED)
+        atomic_fetch_add(&counters.aborted, 1);
+    if (outcome != OUTCOME_STOP)
+        timer_set(l, b, latency_now_us() + (outcome == OUTCOME_ERROR ? CHARGE_RETRY_MS * 1000 : 0));
+}
+
+/**
+ * @brief Issue d'une connexion fermée en cours de route, selon l'étape du bot.
+ * @param b Le bot.
+ * @return L'issue.
+ */
+static BotOutcome bot_outcome(const Bot *b)
+{
+    if (b->phase == BOT_FINISHING)
+        return OUTCOME_FINISHED;
+    return b->phase == BOT_PLAYING ? OUTCOME_ABORTED : OUTCOME_ERROR;
+}
+
+/**
+ * @brief Envoie les trames en attente d'un bot, et surveille EPOLLOUT tant qu'il en reste.
+ * @param l Le thread.
+ * @param b Le bot.
+ * @return 0 si succès, -1 si la connexion est perdue.
+ */
+static int bot_flush(Loader *l, Bot *b)
+{
+    while (b->out.len > 0)
+    {
+        ssize_t n = send(b->fd, b->out.buf, b->out.len, MSG_NOSIGNAL);
+        if (n > 0)
+        {
+            proto_writer_consume(&b->out, (int)n);
+            continue;
+        }
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            break;
+        return -1;
+    }
+    bool want = b->out.len > 0;
+    if (want != b->want_out)
+    {
+        struct epoll_event ev = { .events = EPOLLIN | EPOLLRDHUP | (want ? EPOLLOUT : 0), .data.ptr = b };
+        if (epoll_ctl(l->epfd, EPOLL_CTL_MOD, b->fd, &ev) < 0)
+            return -1;
+        b->want_out = want;
+    }
+    return 0;
+}
+
+/**
+ * @brief Envoie HELLO une fois la connexion établie.
+ * @param l Le thread.
+ * @param b Le bot.
+ */
+static void bot_hello(Loader *l, Bot *b)
+{
+    atomic_fetch_add(&counters.connects, 1);
+    int on = 1;
+    setsockopt(b->fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    b->phase = BOT_HELLO;
+    b->hello_us = latency_now_us();
+    ProtoMsg hello = { .type = PROTO_HELLO, .u.hello = { PROTO_VERSION, PROTO_ROLE_ANY } };
+    if (proto_writer_push(&b->out, &hello) < 0 || bot_flush(l, b) < 0)
+        bot_close(l, b, OUTCOME_ERROR);
+}
+
+/**
+ * @brief Ouvre une nouvelle connexion pour un bot (connexion non bloquante).
+ * @param l Le thread.
+ * @param b Le bot.
+ */
+static void bot_connect(Loader *l, Bot *b)
+{
+    b->fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (b->fd < 0)
+    {
+        atomic_fetch_add(&counters.connect_errors, 1);
+        bot_close(l, b, OUTCOME_ERROR);
+        return;
+    }
+    proto_reader_init(&b->in);
+    proto_writer_init(&b->out);
+    logique_init_game(&b->state);
+    b->game = 0;
+    b->want_out = true;
+    b->phase = BOT_CONNECTING;
+
+    int r = connect(b->fd, (struct sockaddr *)&cfg.addr, sizeof(cfg.addr));
+    struct epoll_event ev = { .events = EPOLLIN | EPOLLRDHUP | EPOLLOUT, .data.ptr = b };
+    if ((r < 0 && errno != EINPROGRESS) || epoll_ctl(l->epfd, EPOLL_CTL_ADD, b->fd, &ev) < 0)
+    {
+        atomic_fetch_add(&counters.connect_errors, 1);
+        bot_close(l, b, OUTCOME_ERROR);
+    }
+}
+
+/**
+ * @brief Joue le coup d'un bot dont la réflexion est terminée, suivi d'un PING.
+ * @param l Le thread.
+ * @param b Le bot.
+ */
+static void bot_play(Loader *l, Bot *b)
+{
+    int from, to;
+    if (bot_choose(b, &from, &to) < 0)
+    {
+        bot_close(l, b, OUTCOME_ABORTED); // aucun coup : la position est bloquée
+        return;
+    }
+    int tour = b->state.tour;
+    logique_jouer_coup(&b->state, from, to);
+
+    int64_t now = latency_now_us();
+    RelayStamp *stamp = &relay[b->game & (CHARGE_RELAY_SLOTS - 1)];
+    atomic_store_explicit(&stamp->sent_us, now, memory_order_relaxed);
+    atomic_store_explicit(&stamp->tag, (uint64_t)b->game << 32 | (uint32_t)tour, memory_order_release);
+
+    ProtoMsg move = { .type = PROTO_MOVE, .u.move = { (uint8_t)from, (uint8_t)to } };
+    ProtoMsg ping = { .type = PROTO_PING, .u.ping = (uint64_t)now };
+    if (proto_writer_push(&b->out, &move) < 0 || proto_writer_push(&b->out, &ping) < 0 || bot_flush(l, b) < 0)
+    {
+        bot_close(l, b, OUTCOME_ABORTED);
+        return;
+    }
+    atomic_fetch_add(&counters.moves_sent, 1);
+    if (b->state.game_over_status != 0)
+        b->phase = BOT_FINISHING;
+}
+
+/**
+ * @brief Lance la réflexion d'un bot si c'est à lui de jouer.
+ * @param l Le thread.
+ * @param b Le bot.
+ */
+static void bot_maybe_think(Loader *l, Bot *b)
+{
+    if (b->phase == BOT_PLAYING && (b->state.tour % 2 != 0) == b->blue)
+        timer_set(l, b, latency_now_us() + bot_think_us(b));
+}
+
+/**
+ * @brief Traite une trame reçue par un bot.
+ * @param l Le thread.
+ * @param b Le bot.
+ * @param m La trame.
+ * @return true si la connexion continue.
+ */
+static bool bot_frame(Loader *l, Bot *b, const ProtoMsg *m)
+{
+    int64_t now = latency_now_us();
+    if (m->type == PROTO_ERROR)
+    {
+        atomic_fetch_add(&counters.server_errors, 1);
+        return false;
+    }
+    if (b->phase == BOT_HELLO)
+    {
+        if (m->type != PROTO_HELLO || m->u.hello.version != PROTO_VERSION ||
+            (m->u.hello.role != PROTO_ROLE_BLUE && m->u.hello.role != PROTO_ROLE_RED))
+        {
+            atomic_fetch_add(&counters.protocol_errors, 1);
+            return false;
+        }
+        lat_hist_record(&hist_pairing, now - b->hello_us);
+        atomic_fetch_add(&counters.games, 1);
+        b->blue = m->u.hello.role == PROTO_ROLE_BLUE;
+        b->phase = BOT_PLAYING;
+        bot_maybe_think(l, b);
+        return true;
+    }
+
+    switch (m->type)
+    {
+    case PROTO_SESSION:
+        b->game = m->u.session.game;
+        return true;
+    case PROTO_MOVE:
+    {
+        if (b->phase != BOT_PLAYING)
+            return true;
+        RelayStamp *stamp = &relay[b->game & (CHARGE_RELAY_SLOTS - 1)];
+        uint64_t tag = (uint64_t)b->game << 32 | (uint32_t)b->state.tour;
+        if (b->game != 0 && atomic_load_explicit(&stamp->tag, memory_order_acquire) == tag)
+            lat_hist_record(&hist_relay, now - atomic_load_explicit(&stamp->sent_us, memory_order_relaxed));
+        if (logique_jouer_coup(&b->state, m->u.move.from, m->u.move.to) < 0)
+        {
+            atomic_fetch_add(&counters.illegal, 1);
+            return false;
+        }
+        atomic_fetch_add(&counters.moves_received, 1);
+        if (b->state.game_over_status != 0)
+            b->phase = BOT_FINISHING;
+        bot_maybe_think(l, b);
+        return true;
+    }
+    case PROTO_PONG:
+        lat_hist_record(&hist_rtt, now - (int64_t)m->u.ping);
+        return true;
+    case PROTO_RESIGN:
+        b->phase = BOT_FINISHING;
+        timer_cancel(l, b);
+        return true;
+    case PROTO_CLOCK:
+        return true;
+    default:
+        atomic_fetch_add(&counters.protocol_errors, 1);
+        return false;
+    }
+}
+
+/**
+ * @brief Lit les octets disponibles d'un bot et traite ses trames.
+ * @param l Le thread.
+ * @param b Le bot.
+ */
+static void bot_read(Loader *l, Bot *b)
+{
+    for (;;)
+    {
+        ssize_t n = recv(b->fd, b->in.buf + b->in.len, PROTO_BUF_SIZE - b->in.len, 0);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            break;
+        if (n <= 0)
+        {
+            bot_close(l, b, bot_outcome(b)); // fermeture par le serveur
+            return;
+        }
+        b->in.len += (int)n;
+
+        ProtoMsg msg;
+        int got;
+        while ((got = proto_reader_next(&b->in, &msg)) > 0)
+        {
+            if (!bot_frame(l, b, &msg))
+            {
+                bot_close(l, b, b->phase == BOT_PLAYING ? OUTCOME_ABORTED : OUTCOME_ERROR);
+                return;
+            }
+        }
+        if (got < 0)
+        {
+            atomic_fetch_add(&counters.protocol_errors, 1);
+            bot_close(l, b, b->phase == BOT_PLAYING ? OUTCOME_ABORTED : OUTCOME_ERROR);
+            return;
+        }
+    }
+    if (bot_flush(l, b) < 0)
+        bot_close(l, b, bot_outcome(b));
+}
+
+/**
+ * @brief Traite un événement epoll d'un bot.
+ * @param l Le thread.
+ * @param b Le bot.
+ * @param events Les événements.
+ */
+static void bot_event(Loader *l, Bot *b, uint32_t events)
+{
+    if (b->phase == BOT_CONNECTING)
+    {
+        int err = 0;
+        socklen_t len = sizeof(err);
+        if (getsockopt(b->fd, SOL_SOCKET, SO_ERROR, &err, &len) < 0 || err != 0)
+        {
+            atomic_fetch_add(&counters.connect_errors, 1);
+            bot_close(l, b, OUTCOME_ERROR);
+            return;
+        }
+        bot_hello(l, b);
+        return;
+    }
+    if (events & EPOLLOUT)
+    {
+        if (bot_flush(l, b) < 0)
+        {
+            bot_close(l, b, bot_outcome(b));
+            return;
+        }
+    }
+    if (events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR))
+        bot_read(l, b);
+}
+
+/**
+ * @brief Corps d'un thread de bots.
+ * @param arg Le `Loader`.
+ * @return NULL.
+ */
+static void *loader_main(void *arg)
+{
+    Loader *l = arg;
+    struct epoll_event events[CHARGE_EVENTS];
+
+    while (!atomic_load(&stopping))
+    {
+        int64_t now = latency_now_us();
+        int timeout = CHARGE_TICK_MS;
+        if (l->heap_len > 0)
+        {
+            int64_t left = (l->heap[0]->wake_us - now + 999) / 1000;
+            if (left < timeout)
+                timeout = left > 0 ? (int)left : 0;
+        }
+        int n = epoll_wait(l->epfd, events, CHARGE_EVENTS, timeout);
+        if (n < 0 && errno != EINTR)
+        {
+            perror("epoll_wait");
+            break;
+        }
+        for (int i = 0; i < n; i++)
+        {
+            Bot *b = events[i].data.ptr;
+            if (b->fd >= 0)
+                bot_event(l, b, events[i].events);
+        }
+
+        now = latency_now_us();
+        while (l->heap_len > 0 && l->heap[0]->wake_us <= now)
+        {
+            Bot *b = l->heap[0];
+            timer_cancel(l, b);
+            if (b->phase == BOT_IDLE)
+                bot_connect(l, b);
+            else if (b->phase == BOT_PLAYING)
+                bot_play(l, b);
+        }
+    }
+
+    // Fin du test : les parties en cours sont abandonnées plutôt que laissées en suspens.
+    for (int i = 0; i < l->nbots; i++)
+    {
+        Bot *b = &l->bots[i];
+        if (b->phase == BOT_PLAYING)
+        {
+            ProtoMsg resign = { .type = PROTO_RESIGN };
+            if (proto_writer_push(&b->out, &resign) == 0)
+                bot_flush(l, b);
+        }
+        bot_close(l, b, OUTCOME_STOP);
+    }
+    return NULL;
+}
+
+// Programme principal
+
+/**
+ * @brief Gestionnaire de SIGINT et SIGTERM : demande l'arrêt du test.
+ * @param sig Le signal reçu.
+ */
+static void on_signal(int sig)
+{
+    (void)sig;
+    atomic_store(&stopping, true);
+}
+
+/**
+ * @brief Lit l'adresse du serveur ("adresse:port").
+ * @param arg L'argument.
+ * @return 0 si succès, -1 si l'adresse est invalide.
+ */
+static int parse_address(const char *arg)
+{
+    char host[64];
+    const char *colon = strrchr(arg, ':');
+    if (!colon || colon == arg || colon - arg >= (int)sizeof(host))
+        return -1;
+    memcpy(host, arg, colon - arg);
+    host[colon - arg] = '\0';
+    int port = atoi(colon + 1);
+    cfg.addr.sin_family = AF_INET;
+    cfg.addr.sin_port = htons((uint16_t)port);
+    return port > 0 && port < 65536 && inet_pton(AF_INET, host, &cfg.addr.sin_addr) == 1 ? 0 : -1;
+}
+
+/**
+ * @brief Lit le temps de réflexion : "<ms>" ou "<ms>:<loi>".
+ * @param arg L'argument de -reflexion.
+ * @return 0 si succès, -1 si l'argument est invalide.
+ */
+static int parse_think(const char *arg)
+{
+    char *end;
+    long ms = strtol(arg, &end, 10);
+    if (end == arg || ms < 0 || ms > 3600000)
+        return -1;
+    cfg.think_ms = (int)ms;
+    if (*end == '\0' || strcmp(end, ":constante") == 0)
+        cfg.law = THINK_CONSTANT;
+    else if (strcmp(end, ":uniforme") == 0)
+        cfg.law = THINK_UNIFORM;
+    else if (strcmp(end, ":exponentielle") == 0)
+        cfg.law = THINK_EXPONENTIAL;
+    else
+        return -1;
+    return 0;
+}
+
+/**
+ * @brief Affiche une ligne du tableau des latences.
+ * @param name Le nom de la mesure.
+ * @param h L'histogramme.
+ */
+static void print_histogram(const char *name, const LatencyHistogram *h)
+{
+    uint64_t n = atomic_load(&h->total);
+    if (n == 0)
+    {
+        printf("%-14s %8d\n", name, 0);
+        return;
+    }
+    printf("%-14s %8llu %9llu %9llu %9llu %9llu %9llu %9llu\n", name, (unsigned long long)n,
+           (unsigned long long)(atomic_load(&h->sum) / n), (unsigned long long)lat_hist_percentile(h, 50),
+           (unsigned long long)lat_hist_percentile(h, 90), (unsigned long long)lat_hist_percentile(h, 99),
+           (unsigned long long)lat_hist_percentile(h, 99.9), (unsigned long long)atomic_load(&h->max));
+}
+
+int main(int argc, char *argv[])
+{
+    static const char *laws[] = { "constante", "uniforme", "exponentielle" };
+    bool ok = argc >= 2 && parse_address(argv[1]) == 0;
+    cfg.clients = 100;
+    cfg.threads = 1;
+    cfg.duration_s = 10;
+    cfg.ramp_ms = 1000;
+    cfg.seed = 1;
+    for (int i = 2; ok && i < argc; i++)
+    {
+        if (strcmp(argv[i], "-clients") == 0 && i + 1 < argc)
+            cfg.clients = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-threads") == 0 && i + 1 < argc)
+            cfg.threads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-duree") == 0 && i + 1 < argc)
+            cfg.duration_s = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-strategie") == 0 && i + 1 < argc)
+        {
+            const char *s = argv[++i];
+            cfg.greedy = strcmp(s, "glouton") == 0;
+            ok = cfg.greedy || strcmp(s, "hasard") == 0;
+        }
+        else if (strcmp(argv[i], "-reflexion") == 0 && i + 1 < argc)
+            ok = parse_think(argv[++i]) == 0;
+        else if (strcmp(argv[i], "-montee") == 0 && i + 1 < argc)
+            cfg.ramp_ms = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-graine") == 0 && i + 1 < argc)
+            cfg.seed = (unsigned)strtoul(argv[++i], NULL, 10);
+        else
+            ok = false;
+    }
+    if (!ok || cfg.clients < 1 || cfg.threads < 1 || cfg.threads > CHARGE_MAX_THREADS || cfg.duration_s < 1 ||
+        cfg.ramp_ms < 0)
+    {
+        fprintf(stderr, "Usage : %s <adresse:port> [-clients <n>] [-threads <1-%d>] [-duree <s>]"
+                " [-strategie hasard|glouton] [-reflexion <ms>[:constante|uniforme|exponentielle]]"
+                " [-montee <ms>] [-graine <n>]\n", argv[0], CHARGE_MAX_THREADS);
+        return 1;
+    }
+    if (cfg.threads > cfg.clients)
+        cfg.threads = cfg.clients;
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_signal;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    signal(SIGPIPE, SIG_IGN);
+    lat_hist_reset(&hist_relay);
+    lat_hist_reset(&hist_rtt);
+    lat_hist_reset(&hist_pairing);
+
+    Bot *bots = calloc(cfg.clients, sizeof(Bot));
+    Bot **heap = calloc(cfg.clients, sizeof(Bot *));
+    Loader loaders[CHARGE_MAX_THREADS];
+    if (!bots || !heap)
+    {
+        fprintf(stderr, "Erreur : mémoire insuffisante pour %d bots\n", cfg.clients);
+        return 1;
+    }
+
+    // Les bots sont répartis en tranches contiguës ; leurs connexions, étalées sur la montée.
+    int64_t start = latency_now_us();
+    int started = 0;
+    for (int t = 0; t < cfg.threads; t++)
+    {
+        Loader *l = &loaders[t];
+        int first = (int)((int64_t)cfg.clients * t / cfg.threads);
+        int last = (int)((int64_t)cfg.clients * (t + 1) / cfg.threads);
+        l->bots = bots + first;
+        l->nbots = last - first;
+        l->heap = heap + first;
+        l->heap_len = 0;
+        l->epfd = epoll_create1(EPOLL_CLOEXEC);
+        for (int i = 0; i < l->nbots; i++)
+        {
+            Bot *b = &l->bots[i];
+            b->fd = -1;
+            b->heap_pos = -1;
+            b->seed = cfg.seed * 2654435761u + (unsigned)(first + i);
+            timer_set(l, b, start + (int64_t)cfg.ramp_ms * 1000 * (first + i) / cfg.clients);
+        }
+        if (l->epfd < 0 || pthread_create(&l->thread, NULL, loader_main, l) != 0)
+        {
+            fprintf(stderr, "Erreur : impossible de lancer le thread %d\n", t);
+            atomic_store(&stopping, true);
+            break;
+        }
+        started++;
+    }
+
+    printf("Charge : %d clients sur %d threads pendant %d s, stratégie %s, réflexion %d ms (%s)\n",
+           cfg.clients, cfg.threads, cfg.duration_s, cfg.greedy ? "glouton" : "hasard", cfg.think_ms,
+           laws[cfg.law]);
+    uint64_t last_moves = 0;
+    for (int s = 1; s <= cfg.duration_s && !atomic_load(&stopping); s++)
+    {
+        int64_t wake = start + (int64_t)s * 1000000;
+        while (!atomic_load(&stopping) && latency_now_us() < wake)
+            usleep(10000);
+        uint64_t moves = atomic_load(&counters.moves_sent);
+        uint64_t games = atomic_load(&counters.games);
+        uint64_t ended = atomic_load(&counters.finished) + atomic_load(&counters.aborted);
+        printf("[%3d s] %7llu coups/s, %6llu joueurs en partie, %llu erreurs\n", s,
+               (unsigned long long)(moves - last_moves), (unsigned long long)(games - ended),
+               (unsigned long long)(atomic_load(&counters.connect_errors) + atomic_load(&counters.server_errors) +
+                                    atomic_load(&counters.protocol_errors) + atomic_load(&counters.illegal)));
+        fflush(stdout);
+        last_moves = moves;
+    }
+    atomic_store(&stopping, true);
+    for (int t = 0; t < started; t++)
+    {
+        pthread_join(loaders[t].thread, NULL);
+        close(loaders[t].epfd);
+    }
+    double elapsed = (latency_now_us() - start) / 1e6;
+
+    uint64_t moves = atomic_load(&counters.moves_sent);
+    uint64_t finished = atomic_load(&counters.finished);
+    printf("Connexions : %llu établies, %llu échouées\n", (unsigned long long)atomic_load(&counters.connects),
+           (unsigned long long)atomic_load(&counters.connect_errors));
+    printf("Parties (une par joueur) : %llu appariées, %llu terminées, %llu interrompues\n",
+           (unsigned long long)atomic_load(&counters.games), (unsigned long long)finished,
+           (unsigned long long)atomic_load(&counters.aborted));
+    printf("Débit : %llu coups joués, %llu reçus en %.1f s ; %.0f coups/s, %.1f parties terminées/s\n",
+           (unsigned long long)moves, (unsigned long long)atomic_load(&counters.moves_received), elapsed,
+           moves / elapsed, finished / 2.0 / elapsed);
+    printf("Erreurs : %llu trames ERROR du serveur, %llu erreurs de protocole, %llu coups illégaux reçus\n",
+           (unsigned long long)atomic_load(&counters.server_errors),
+           (unsigned long long)atomic_load(&counters.protocol_errors),
+           (unsigned long long)atomic_load(&counters.illegal));
+    printf("%-14s %8s %9s %9s %9s %9s %9s %9s\n", "Latences (µs)", "n", "moyenne", "p50", "p90", "p99", "p99.9",
+           "max");
+    print_histogram("relais", &hist_relay);
+    print_histogram("aller-retour", &hist_rtt);
+    print_histogram("appariement", &hist_pairing);
+
+    free(heap);
+    free(bots);
+    return 0;
+}
@@ -0,0 +1,61 @@
+/**
+ * @file journal.c
+ * @brief Outil de relecture des journaux de parties.
+ * @authors Groupe 8
+ *
+ * Usage : `./journal <fichier> [coups]`. Affiche la description du journal
+ * et la position après <coups> coups (par défaut, la dernière).
+ */
+
+#include "journal.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/**
+ * @brief Affiche une position : r/b pour les soldats, R/B pour les rois.
+ * @param s La position.
+ */
+static void print_board(const GameState *s)
+{
+    static const char symbols[] = ".rbRB";
+    for (int r = 0; r < SIZE; r++)
+    {
+        printf("%d  ", SIZE - r);
+        for (int c = 0; c < SIZE; c++)
+        {
+            int p = s->pion[r][c];
+            printf("%c ", p >= 0 && p <= ROI_BLEU ? symbols[p] : '?');
+        }
+        printf("\n");
+    }
+    printf("   A B C D E F G H I\n");
+    printf("Tour %d, soldats perdus : %d rouges, %d bleus\n", s->tour, s->dead_red_count, s->dead_blue_count);
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2 || argc > 3)
+    {
+        fprintf(stderr, "Usage : %s <fichier> [coups]\n", argv[0]);
+        return 1;
+    }
+
+    int ply = argc == 3 ? atoi(argv[2]) : -1;
+    GameState state;
+    JournalInfo info;
+    int done = journal_replay(argv[1], ply, &state, &info);
+    if (done < 0)
+    {
+        fprintf(stderr, "Erreur : journal %s illisible ou corrompu\n", argv[1]);
+        return 1;
+    }
+
+    static const char *results[] = { "interrompue", "rouges gagnants", "bleus gagnants", "égalité" };
+    printf("Partie %08x du %lld : %d coups, %s%s\n", (unsigned)info.game_id, (long long)info.created, info.plies,
+           info.status < 0 ? "sans fin enregistrée" : info.status <= 3 ? results[info.status] : "résultat inconnu",
+           info.truncated ? " (fin de fichier incomplète ignorée)" : "");
+    printf("Position après %d coups :\n", done);
+    print_board(&state);
+    return 0;
+}
@@ -0,0 +1,139 @@
+/**
+ * @file serveur.c
+ * @brief Serveur de parties sans interface graphique.
+ * @authors Groupe 8
+ *
+ * Usage : `./serveur <port> [-workers <n>] [-parties <n>] [-journal <répertoire>]
+ * [-sync <ms>|toujours|jamais]`. Les clients
+ * (`./game -c <adresse:port>`, bots) sont appariés dans l'ordre d'arrivée ;
+ * des spectateurs peuvent suivre les parties en cours. Ctrl-C arrête le serveur et affiche ses compteurs.
+ */
+
+#include "serveur.h"
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/**
+ * @brief Lit la politique de synchronisation des journaux : "toujours", "jamais" ou un intervalle en ms.
+ * @param arg L'argument de -sync.
+ * @param cfg La configuration à compléter.
+ * @return 0 si succès, -1 si l'argument est invalide.
+ */
+static int parse_sync(const char *arg, ServerConfig *cfg)
+{
+    if (strcmp(arg, "toujours") == 0)
+    {
+        cfg->journal_sync = JOURNAL_SYNC_ALWAYS;
+    }
+    else if (strcmp(arg, "jamais") == 0)
+    {
+        cfg->journal_sync = JOURNAL_SYNC_NEVER;
+    }
+    else
+    {
+        char *end;
+        long ms = strtol(arg, &end, 10);
+        if (*end != '\0' || ms <= 0)
+        {
+            return -1;
+        }
+        cfg->journal_sync = JOURNAL_SYNC_INTERVAL;
+        cfg->journal_sync_ms = (int)ms;
+    }
+    return 0;
+}
+
+/**
+ * @brief Gestionnaire de SIGINT et SIGTERM : demande l'arrêt du serveur.
+ * @param sig Le signal reçu.
+ */
+static void on_signal(int sig)
+{
+    (void)sig;
+    server_stop();
+}
+
+int main(int argc, char *argv[])
+{
+    ServerConfig cfg = { .port = 0, .workers = SRV_DEFAULT_WORKERS, .max_games = SRV_DEFAULT_MAX_GAMES,
+                         .journal_dir = NULL, .journal_sync = JOURNAL_SYNC_INTERVAL,
+                         .journal_sync_ms = JOURNAL_DEFAULT_SYNC_MS };
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-workers") == 0 && i + 1 < argc)
+        {
+            cfg.workers = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-parties") == 0 && i + 1 < argc)
+        {
+            cfg.max_games = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-journal") == 0 && i + 1 < argc)
+        {
+            cfg.journal_dir = argv[++i];
+        }
+        else if (strcmp(argv[i], "-sync") == 0 && i + 1 < argc)
+        {
+            if (parse_sync(argv[++i], &cfg) < 0)
+            {
+                cfg.port = -1;
+            }
+        }
+        else if (cfg.port == 0)
+        {
+            cfg.port = atoi(argv[i]);
+        }
+        else
+        {
+            cfg.port = -1;
+        }
+    }
+    if (cfg.port <= 0 || cfg.workers < 1 || cfg.workers > SRV_MAX_WORKERS || cfg.max_games < 1 ||
+        cfg.max_games > SRV_MAX_GAMES)
+    {
+        fprintf(stderr, "Usage : %s <port> [-workers <1-%d>] [-parties <1-%d>] [-journal <répertoire>]"
+                " [-sync <ms>|toujours|jamais]\n", argv[0], SRV_MAX_WORKERS, SRV_MAX_GAMES);
+        return 1;
+    }
+    if (cfg.journal_dir && access(cfg.journal_dir, W_OK | X_OK) != 0)
+    {
+        fprintf(stderr, "Erreur : répertoire de journaux %s inaccessible\n", cfg.journal_dir);
+        return 1;
+    }
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_signal;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    printf("Serveur de parties sur le port %d : %d threads, %d parties au plus\n",
+           cfg.port, cfg.workers, cfg.max_games);
+    if (server_run(&cfg) < 0)
+    {
+        fprintf(stderr, "Erreur : impossible de lancer le serveur sur le port %d\n", cfg.port);
+        return 1;
+    }
+
+    ServerStats st;
+    server_get_stats(&st);
+    printf("Connexions : %llu acceptées, %llu refusées\n",
+           (unsigned long long)st.accepted, (unsigned long long)st.refused);
+    printf("Parties : %llu formées, %llu terminées, %llu interrompues ; %llu coups relayés ; %llu reprises\n",
+           (unsigned long long)st.games_started, (unsigned long long)st.games_finished,
+           (unsigned long long)st.games_aborted, (unsigned long long)st.moves, (unsigned long long)st.resumed);
+    printf("Spectateurs : %llu acceptés, %llu déconnectés car trop lents ; %llu resynchronisations\n",
+           (unsigned long long)st.spectators, (unsigned long long)st.spectators_dropped,
+           (unsigned long long)st.resyncs);
+    if (cfg.journal_dir)
+    {
+        printf("Journaux dans %s : %llu erreurs\n", cfg.journal_dir, (unsigned long long)st.journal_errors);
+    }
+    return 0;
+}